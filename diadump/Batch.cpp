@@ -0,0 +1,236 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <wctype.h>
+#include "Disassembler.h"
+#include "GapScanner.h"
+#include "OutputFormatter.h"
+#include "Parallel.h"
+#include "Stats.h"
+#include "Utility.h"
+#include "Batch.h"
+
+using namespace std;
+
+static bool HasImageExtension(const wstring& filename)
+{
+	size_t extStart = filename.find_last_of(L'.');
+
+	if(extStart == wstring::npos)
+		return false;
+
+	wstring ext = filename.substr(extStart);
+	transform(ext.begin(), ext.end(), ext.begin(), towlower);
+
+	return ext == L".exe" || ext == L".dll";
+}
+
+static bool ListDirectory(const wstring& dir, vector<wstring>& inputs)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAW findData;
+	HANDLE find = FindFirstFileW(JoinPath(dir, L"*").c_str(), &findData);
+
+	if(find == INVALID_HANDLE_VALUE)
+		return false;
+
+	do {
+		if(!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && HasImageExtension(findData.cFileName))
+			inputs.push_back(JoinPath(dir, findData.cFileName));
+	} while(FindNextFileW(find, &findData));
+
+	FindClose(find);
+#else
+	DIR* dirHandle = opendir(WideToUtf8(dir).c_str());
+
+	if(!dirHandle)
+		return false;
+
+	while(dirent* entry = readdir(dirHandle)) {
+		wstring name = Utf8ToWide(entry->d_name);
+
+		if(HasImageExtension(name))
+			inputs.push_back(JoinPath(dir, name));
+	}
+
+	closedir(dirHandle);
+#endif
+
+	// same order every run, whatever order the file system lists them in
+	sort(inputs.begin(), inputs.end());
+	return true;
+}
+
+static bool IsDirectory(const wstring& path)
+{
+#ifdef _WIN32
+	DWORD attributes = GetFileAttributesW(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat info;
+	return stat(WideToUtf8(path).c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+bool GetBatchInputs(const wstring& listOrDir, vector<wstring>& inputs)
+{
+	inputs.clear();
+
+	if(IsDirectory(listOrDir))
+		return ListDirectory(listOrDir, inputs);
+
+	ifstream listFile(NativePath(listOrDir).c_str());
+
+	if(!listFile)
+		return false;
+
+	string line;
+
+	while(getline(listFile, line)) {
+		// tolerate CRLF list files and surrounding blanks
+		size_t first = line.find_first_not_of(" \t\r");
+		size_t last = line.find_last_not_of(" \t\r");
+
+		if(first == string::npos || line[first] == '#')
+			continue;
+
+		inputs.push_back(Utf8ToWide(line.substr(first, last - first + 1)));
+	}
+
+	return true;
+}
+
+void RunBatch(const vector<wstring>& inputs, const BatchOptions& options, vector<BatchResult>& results)
+{
+	results.assign(inputs.size(), BatchResult());
+
+	// output files are named after the image, numbered if two share a name
+	map<wstring, unsigned int> nameCounts;
+
+	for(size_t i = 0, i_end = inputs.size(); i < i_end; ++i) {
+		size_t	nameStart = inputs[i].find_last_of(L"\\/");
+		wstring	name = nameStart == wstring::npos ? inputs[i] : inputs[i].substr(nameStart + 1);
+
+		unsigned int count = nameCounts[name]++;
+
+		if(count) {
+			wostringstream numbered;
+			numbered << name << L'_' << count;
+			name = numbered.str();
+		}
+
+		results[i].inputFilename = inputs[i];
+		results[i].outputFilename = JoinPath(options.outputDir, name + L".txt");
+		results[i].bSucceeded = false;
+		results[i].numFunctions = 0;
+		results[i].bytesWritten = 0;
+		results[i].seconds = 0;
+	}
+
+	vector<size_t> order(inputs.size());
+
+	for(size_t i = 0, i_end = order.size(); i < i_end; ++i)
+		order[i] = i;
+
+	mutex diagMutex;
+
+	// one image per worker at a time; each image is decoded on its
+	// worker's thread, which keeps small images from paying for
+	// thread hand-offs and bounds memory to numJobs images
+	ParallelFor(order, options.numJobs, [&](size_t imageNum) {
+		BatchResult&	result = results[imageNum];
+		wostringstream	diag;
+
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+		try {
+			Disassembler disas(result.inputFilename.c_str(), options.symbolCacheDir);
+
+			disas.SetRecursiveDescent(options.bRecursive);
+			disas.SetOutputControlFlowGraph(options.bOutputCFG);
+			disas.SetDiagnosticStream(diag);
+
+			if(!options.filter.IsEmpty())
+				disas.SelectFunctions(options.filter);
+
+			if(options.bScanGaps) {
+				GapScanner			scanner(disas.GetPE(), disas.GetPDB());
+				vector<SectionGap>	gaps;
+				vector<Function>	candidates;
+
+				scanner.Scan(gaps);
+				GapScanner::GetCandidateFunctions(gaps, candidates);
+				disas.AddFunctions(candidates, options.filter);
+			}
+
+			ofstream outFile(NativePath(result.outputFilename).c_str(), ios::out | ios::binary);
+
+			if(!outFile)
+				throw runtime_error("Unable to open output file.");
+
+			OutputFormatter outDump(outFile);
+
+			disas.DisassembleAndOutputFunctions(outDump, 1);
+			outDump.Flush();
+
+			result.numFunctions = disas.GetFunctions().size();
+			result.bytesWritten = outDump.GetBytesWritten();
+			AddStatsCounter(CounterBytesWritten, result.bytesWritten);
+			result.bSucceeded = outFile.good();
+
+			if(!result.bSucceeded)
+				result.error = "Unable to write output file.";
+		} catch(const exception& e) {
+			result.error = e.what();
+		}
+
+		result.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+
+		wstring diagText = diag.str();
+
+		if(!diagText.empty()) {
+			lock_guard<mutex> lock(diagMutex);
+			wcout << L"== " << result.inputFilename << endl << diagText;
+		}
+	});
+}
+
+void WriteBatchSummary(const vector<BatchResult>& results, double totalSeconds, wostream& out)
+{
+	size_t				numSucceeded = 0;
+	size_t				numFunctions = 0;
+	unsigned long long	bytesWritten = 0;
+
+	for(vector<BatchResult>::const_iterator i = results.begin(), i_end = results.end(); i != i_end; ++i) {
+		if(i->bSucceeded) {
+			out << L"OK     " << fixed << setprecision(3) << i->seconds << L" s  "
+				<< i->numFunctions << L" functions  " << i->bytesWritten << L" bytes  " << i->inputFilename << endl;
+
+			++numSucceeded;
+			numFunctions += i->numFunctions;
+			bytesWritten += i->bytesWritten;
+		} else {
+			out << L"FAILED " << fixed << setprecision(3) << i->seconds << L" s  "
+				<< i->inputFilename << L": " << Utf8ToWide(i->error) << endl;
+		}
+	}
+
+	out << endl
+		<< numSucceeded << L" of " << results.size() << L" images dumped, "
+		<< numFunctions << L" functions, " << bytesWritten << L" bytes in "
+		<< fixed << setprecision(2) << totalSeconds << L" s" << endl;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FunctionFilter.h"
+
+typedef struct
+{
+	unsigned int		numJobs;
+	bool				bRecursive;
+	bool				bOutputCFG;
+	std::wstring		symbolCacheDir;
+	std::wstring		outputDir;
+	FunctionFilter		filter;
+	bool				bScanGaps;
+} BatchOptions;
+
+typedef struct
+{
+	std::wstring		inputFilename;
+	std::wstring		outputFilename;
+	bool				bSucceeded;
+	std::string			error;
+	size_t				numFunctions;
+	unsigned long long	bytesWritten;
+	double				seconds;
+} BatchResult;
+
+//
+//	Dumps many images in one process. Each image is streamed to its
+//	own file in the output directory by one worker, with images spread
+//	across numJobs workers; the XED tables and everything else
+//	process-wide are set up once for the whole batch.
+//
+
+// listOrDir is either a directory (every .exe and .dll in it) or a
+// text file with one path per line; blank lines and # comments are skipped
+bool	GetBatchInputs(const std::wstring& listOrDir, std::vector<std::wstring>& inputs);
+void	RunBatch(const std::vector<std::wstring>& inputs, const BatchOptions& options, std::vector<BatchResult>& results);
+void	WriteBatchSummary(const std::vector<BatchResult>& results, double totalSeconds, std::wostream& out);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include "Disassembler.h"
+#include "OutputFormatter.h"
+#include "PDB.h"
+#include "PE.h"
+#include "RegisterMap.h"
+#include "Utility.h"
+#include "VariableIndex.h"
+#include "Benchmark.h"
+
+using namespace std;
+
+static const unsigned long long NumLookups = 1000000;
+static const unsigned long long NumFormatterLines = 1000000;
+
+static volatile size_t s_benchmarkSink;
+
+// swallows whatever is written, so output benchmarks
+// measure formatting rather than the disk
+class NullStreamBuffer : public streambuf
+{
+protected:
+	virtual int_type overflow(int_type c)
+	{
+		return traits_type::not_eof(c);
+	}
+
+	virtual streamsize xsputn(const char*, streamsize count)
+	{
+		return count;
+	}
+};
+
+typedef chrono::high_resolution_clock BenchmarkClock;
+
+static double SecondsSince(BenchmarkClock::time_point start)
+{
+	return chrono::duration<double>(BenchmarkClock::now() - start).count();
+}
+
+// runs the benchmark numRepeats times and keeps the fastest
+static void Measure(const string& name, unsigned int numRepeats, unsigned long long items, const function<double ()>& run, vector<BenchmarkResult>& results)
+{
+	BenchmarkResult result;
+	result.name = name;
+	result.items = items;
+	result.seconds = 0;
+
+	for(unsigned int repeat = 0; repeat < numRepeats; ++repeat) {
+		double seconds = run();
+
+		if(!repeat || seconds < result.seconds)
+			result.seconds = seconds;
+	}
+
+	results.push_back(result);
+}
+
+void RunBenchmarks(const BenchmarkOptions& options, vector<BenchmarkResult>& results)
+{
+	wstring exeFilename = JoinPath(options.workDir, L"synthetic.exe");
+	wstring pdbFilename = JoinPath(options.workDir, L"synthetic.pdb");
+	unsigned int numRepeats = options.numRepeats ? options.numRepeats : 1;
+
+	WriteSyntheticImage(options.image, exeFilename, pdbFilename);
+
+	results.clear();
+
+	Measure("pe_load", numRepeats, 1, [&]() -> double {
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		PE pe(exeFilename);
+		return SecondsSince(start);
+	}, results);
+
+	PE pe(exeFilename);
+
+	Measure("pdb_load", numRepeats, options.image.numFunctions, [&]() -> double {
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		PDB pdb(pe, exeFilename.c_str());
+		return SecondsSince(start);
+	}, results);
+
+	Disassembler disas(exeFilename.c_str());
+
+	const vector<Function>& functions = disas.GetFunctions();
+
+	if(functions.empty())
+		return;
+
+	// lookups spread over the whole code section, hits and misses alike
+	vector<unsigned long long>	lookups(NumLookups);
+	unsigned long long			codeStart = functions.front().address;
+	unsigned long long			codeSpan = functions.back().address + functions.back().length - codeStart;
+	unsigned long				state = options.image.seed;
+
+	for(size_t i = 0; i < NumLookups; ++i) {
+		// kept to 32 bits so the lookups are the same wherever unsigned long is 64
+		state = (state * 1103515245 + 12345) & 0xFFFFFFFF;
+		lookups[i] = codeStart + (state >> 8) % codeSpan;
+	}
+
+	Measure("find_function", numRepeats, NumLookups, [&]() -> double {
+		const PDB&	pdb = disas.GetPDB();
+		size_t		numFound = 0;
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for(vector<unsigned long long>::const_iterator i = lookups.begin(), i_end = lookups.end(); i != i_end; ++i)
+			numFound += pdb.FindFunction(*i) != 0;
+
+		double seconds = SecondsSince(start);
+
+		// keeps the loop from being optimized away
+		s_benchmarkSink = numFound;
+
+		return seconds;
+	}, results);
+
+	Measure("disassemble_functions", numRepeats, functions.size(), [&]() -> double {
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+		disas.DisassembleFunctions(1);
+		return SecondsSince(start);
+	}, results);
+
+	const vector<DisassembledFunction>& disassembled = disas.GetDisassembledFunctions();
+
+	unsigned long long numInstructions = 0;
+
+	for(vector<DisassembledFunction>::const_iterator i = disassembled.begin(), i_end = disassembled.end(); i != i_end; ++i)
+		numInstructions += i->offsets.size();
+
+	NullStreamBuffer	nullBuffer;
+	ostream				nullStream(&nullBuffer);
+	RegisterMap			registers(pe.Is64Bit());
+
+	// only the PrintOperands calls are timed; decoding each
+	// function's instructions up front stays outside the clock
+	Measure("print_operands", numRepeats, numInstructions, [&]() -> double {
+		OutputFormatter				out(nullStream);
+		vector<xed_decoded_inst_t>	decoded;
+		double						seconds = 0;
+
+		for(size_t funcNum = 0, funcNum_end = functions.size(); funcNum < funcNum_end; ++funcNum) {
+			const DisassembledFunction&	disasFunc = disassembled[funcNum];
+			VariableIndex				variables(functions[funcNum], registers);
+
+			decoded.resize(disasFunc.offsets.size());
+
+			for(size_t instrNum = 0, instrNum_end = decoded.size(); instrNum < instrNum_end; ++instrNum)
+				disas.DecodeInstruction(disasFunc, instrNum, decoded[instrNum]);
+
+			BenchmarkClock::time_point start = BenchmarkClock::now();
+
+			for(size_t instrNum = 0, instrNum_end = decoded.size(); instrNum < instrNum_end; ++instrNum) {
+				if(disasFunc.flags[instrNum] & InstrValid)
+					disas.PrintOperands(decoded[instrNum], variables, 0, out);
+			}
+
+			seconds += SecondsSince(start);
+		}
+
+		return seconds;
+	}, results);
+
+	// one instruction line's worth of formatter calls per item
+	Measure("output_formatter", numRepeats, NumFormatterLines, [&]() -> double {
+		OutputFormatter out(nullStream);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for(unsigned long long line = 0; line < NumFormatterLines; ++line) {
+			out.Append("0x", 2);
+			out.AppendHex(0x140001000ULL + line * 4, 16, true);
+			out.Append(' ');
+
+			unsigned long long fieldStart = out.GetPosition();
+			out.Append("mov eax, dword ptr [rbp-0x10]");
+			out.PadFrom(fieldStart, 40);
+
+			for(unsigned int byteNum = 0; byteNum < 3; ++byteNum) {
+				out.Append(' ');
+				out.AppendHex((line + byteNum) & 0xFF, 2, false);
+			}
+
+			out.AppendLine();
+		}
+
+		out.Flush();
+		return SecondsSince(start);
+	}, results);
+
+	Measure("output_functions", numRepeats, functions.size(), [&]() -> double {
+		OutputFormatter out(nullStream);
+
+		BenchmarkClock::time_point start = BenchmarkClock::now();
+
+		for(vector<Function>::const_iterator i = functions.begin(), i_end = functions.end(); i != i_end; ++i)
+			disas.OutputFunctionDisassembly(i, out);
+
+		out.Flush();
+		return SecondsSince(start);
+	}, results);
+}
+
+void WriteBenchmarkResults(const vector<BenchmarkResult>& results, wostream& out)
+{
+	out << left << setw(24) << L"Benchmark" << right << setw(14) << L"Seconds" << setw(14) << L"Items" << setw(14) << L"ns/item" << endl;
+
+	for(vector<BenchmarkResult>::const_iterator i = results.begin(), i_end = results.end(); i != i_end; ++i) {
+		out << left << setw(24) << i->name.c_str() << right
+			<< fixed << setprecision(6) << setw(14) << i->seconds
+			<< setw(14) << i->items
+			<< setprecision(1) << setw(14) << (i->items ? i->seconds * 1e9 / i->items : 0.0) << endl;
+	}
+}
+
+bool SaveBenchmarkBaseline(const wstring& filename, const vector<BenchmarkResult>& results)
+{
+	ofstream baselineFile(NativePath(filename).c_str(), ios::out | ios::binary);
+
+	baselineFile << "# diadump benchmark baseline: name seconds items" << '\n';
+
+	for(vector<BenchmarkResult>::const_iterator i = results.begin(), i_end = results.end(); i != i_end; ++i)
+		baselineFile << i->name << ' ' << setprecision(9) << i->seconds << ' ' << i->items << '\n';
+
+	return baselineFile.good();
+}
+
+int CompareBenchmarkBaseline(const wstring& filename, const vector<BenchmarkResult>& results, double tolerance, wostream& out)
+{
+	ifstream baselineFile(NativePath(filename).c_str(), ios::in | ios::binary);
+
+	if(!baselineFile)
+		return -1;
+
+	// compared per item, so a baseline taken with a different image size still lines up
+	map<string, double> baseline;
+	string line;
+
+	while(getline(baselineFile, line)) {
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		istringstream		fields(line);
+		string				name;
+		double				seconds;
+		unsigned long long	items;
+
+		if(fields >> name >> seconds >> items)
+			baseline[name] = items ? seconds / items : seconds;
+	}
+
+	int numRegressions = 0;
+
+	out << left << setw(24) << L"Benchmark" << right << setw(14) << L"Baseline ns" << setw(14) << L"Current ns" << setw(10) << L"Ratio" << endl;
+
+	for(vector<BenchmarkResult>::const_iterator i = results.begin(), i_end = results.end(); i != i_end; ++i) {
+		map<string, double>::const_iterator found = baseline.find(i->name);
+
+		if(found == baseline.end() || found->second <= 0)
+			continue;
+
+		double current = i->items ? i->seconds / i->items : i->seconds;
+		double ratio = current / found->second;
+		bool bRegressed = ratio > 1.0 + tolerance;
+
+		if(bRegressed)
+			++numRegressions;
+
+		out << left << setw(24) << i->name.c_str() << right << fixed << setprecision(1)
+			<< setw(14) << found->second * 1e9 << setw(14) << current * 1e9
+			<< setprecision(2) << setw(10) << ratio << (bRegressed ? L"  REGRESSION" : L"") << endl;
+	}
+
+	return numRegressions;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "SyntheticImage.h"
+
+//
+//	Benchmarks each stage of the pipeline against a synthetic image
+//	written into workDir, so the numbers can be reproduced on any machine
+//	from the same options. Macro benchmarks time a whole stage (loading
+//	the PE, ingesting the PDB, decoding and writing every function);
+//	micro benchmarks time one hot call in a loop (function lookup,
+//	operand annotation, the output formatter).
+//
+//	Every benchmark runs numRepeats times and keeps its fastest run.
+//	Results can be saved as a baseline and later runs compared against
+//	it; anything slower than the baseline by more than tolerance
+//	(0.10 is 10%) counts as a regression.
+//
+
+typedef struct
+{
+	SyntheticImageOptions	image;
+	std::wstring			workDir;
+	unsigned int			numRepeats;
+	double					tolerance;
+} BenchmarkOptions;
+
+typedef struct
+{
+	std::string				name;
+	double					seconds;
+	unsigned long long		items;
+} BenchmarkResult;
+
+void	RunBenchmarks(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results);
+void	WriteBenchmarkResults(const std::vector<BenchmarkResult>& results, std::wostream& out);
+bool	SaveBenchmarkBaseline(const std::wstring& filename, const std::vector<BenchmarkResult>& results);
+
+// returns the number of regressions, or -1 if the baseline can't be read
+int		CompareBenchmarkBaseline(const std::wstring& filename, const std::vector<BenchmarkResult>& results, double tolerance, std::wostream& out);
+
+#endif
\ No newline at end of file
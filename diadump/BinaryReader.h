@@ -0,0 +1,117 @@
+#ifndef __BINARYREADER_H__
+#define __BINARYREADER_H__
+
+#include <stdexcept>
+#include <string>
+#include <string.h>
+
+//
+//	Bounds-checked little-endian reader over a raw byte buffer.
+//	Throws std::runtime_error on any read past the end of the buffer
+//	so that a truncated or corrupt file can't take us off into the weeds.
+//
+class BinaryReader
+{
+public:
+	BinaryReader()
+		: m_data(0), m_size(0), m_pos(0)
+	{
+	}
+
+	BinaryReader(const unsigned char* data, size_t size)
+		: m_data(data), m_size(size), m_pos(0)
+	{
+	}
+
+	template<typename T>
+	T Read()
+	{
+		T value;
+		Require(sizeof(T));
+		memcpy(&value, m_data + m_pos, sizeof(T));
+		m_pos += sizeof(T);
+		return value;
+	}
+
+	void ReadBytes(void* dest, size_t size)
+	{
+		Require(size);
+		memcpy(dest, m_data + m_pos, size);
+		m_pos += size;
+	}
+
+	// reads a CodeView numeric leaf, which is either a value below
+	// LF_NUMERIC stored directly or a type tag followed by the value
+	unsigned long long ReadNumeric()
+	{
+		unsigned short leaf = Read<unsigned short>();
+
+		if(leaf < 0x8000)
+			return leaf;
+
+		switch(leaf) {
+			case 0x8000:	return static_cast<unsigned long long>(Read<signed char>());
+			case 0x8001:	return static_cast<unsigned long long>(Read<short>());
+			case 0x8002:	return Read<unsigned short>();
+			case 0x8003:	return static_cast<unsigned long long>(Read<int>());
+			case 0x8004:	return Read<unsigned int>();
+			case 0x8009:	return static_cast<unsigned long long>(Read<long long>());
+			case 0x800a:	return Read<unsigned long long>();
+		}
+
+		throw std::runtime_error("Unsupported CodeView numeric leaf.");
+	}
+
+	std::string ReadCString()
+	{
+		const unsigned char* start = m_data + m_pos;
+		const void* end = memchr(start, 0, m_size - m_pos);
+
+		if(!end)
+			throw std::runtime_error("Unterminated string in binary data.");
+
+		std::string str(reinterpret_cast<const char*>(start), reinterpret_cast<const char*>(end));
+		m_pos += str.length() + 1;
+		return str;
+	}
+
+	void Skip(size_t size)
+	{
+		Require(size);
+		m_pos += size;
+	}
+
+	void Seek(size_t pos)
+	{
+		if(pos > m_size)
+			throw std::runtime_error("Seek past end of binary data.");
+
+		m_pos = pos;
+	}
+
+	void Align(size_t alignment)
+	{
+		size_t rem = m_pos % alignment;
+
+		if(rem)
+			Skip(alignment - rem);
+	}
+
+	const unsigned char*	Current() const		{ return m_data + m_pos; }
+	size_t					Tell() const		{ return m_pos; }
+	size_t					Remaining() const	{ return m_size - m_pos; }
+	bool					AtEnd() const		{ return m_pos >= m_size; }
+
+private:
+	void Require(size_t size) const
+	{
+		if(size > m_size - m_pos)
+			throw std::runtime_error("Read past end of binary data.");
+	}
+
+	const unsigned char*	m_data;
+	size_t					m_size;
+	size_t					m_pos;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef __CVCONST_H__
+#define __CVCONST_H__
+
+//
+//	The register and basic type enumerations from the DIA SDK's
+//	cvconst.h, with the same names and values. Only the entries the
+//	PDB reader and the register map use are listed, so the DIA SDK
+//	isn't needed to build.
+//
+enum CV_HREG_e
+{
+	CV_REG_NONE					= 0,
+	CV_REG_AL					= 1,
+	CV_REG_CL					= 2,
+	CV_REG_DL					= 3,
+	CV_REG_BL					= 4,
+	CV_REG_AH					= 5,
+	CV_REG_CH					= 6,
+	CV_REG_DH					= 7,
+	CV_REG_BH					= 8,
+	CV_REG_AX					= 9,
+	CV_REG_CX					= 10,
+	CV_REG_DX					= 11,
+	CV_REG_BX					= 12,
+	CV_REG_SP					= 13,
+	CV_REG_BP					= 14,
+	CV_REG_SI					= 15,
+	CV_REG_DI					= 16,
+	CV_REG_EAX					= 17,
+	CV_REG_ECX					= 18,
+	CV_REG_EDX					= 19,
+	CV_REG_EBX					= 20,
+	CV_REG_ESP					= 21,
+	CV_REG_EBP					= 22,
+	CV_REG_ESI					= 23,
+	CV_REG_EDI					= 24,
+	CV_REG_ES					= 25,
+	CV_REG_CS					= 26,
+	CV_REG_SS					= 27,
+	CV_REG_DS					= 28,
+	CV_REG_FS					= 29,
+	CV_REG_GS					= 30,
+	CV_REG_IP					= 31,
+	CV_REG_FLAGS				= 32,
+	CV_REG_EIP					= 33,
+	CV_REG_EFLAGS				= 34,
+	CV_REG_CR0					= 80,
+	CV_REG_CR1					= 81,
+	CV_REG_CR2					= 82,
+	CV_REG_CR3					= 83,
+	CV_REG_CR4					= 84,
+	CV_REG_DR0					= 90,
+	CV_REG_DR1					= 91,
+	CV_REG_DR2					= 92,
+	CV_REG_DR3					= 93,
+	CV_REG_DR4					= 94,
+	CV_REG_DR5					= 95,
+	CV_REG_DR6					= 96,
+	CV_REG_DR7					= 97,
+	CV_REG_GDTR					= 110,
+	CV_REG_IDTR					= 112,
+	CV_REG_LDTR					= 114,
+	CV_REG_TR					= 115,
+	CV_REG_ST0					= 128,
+	CV_REG_ST1					= 129,
+	CV_REG_ST2					= 130,
+	CV_REG_ST3					= 131,
+	CV_REG_ST4					= 132,
+	CV_REG_ST5					= 133,
+	CV_REG_ST6					= 134,
+	CV_REG_ST7					= 135,
+	CV_REG_XMM0					= 154,
+	CV_REG_XMM1					= 155,
+	CV_REG_XMM2					= 156,
+	CV_REG_XMM3					= 157,
+	CV_REG_XMM4					= 158,
+	CV_REG_XMM5					= 159,
+	CV_REG_XMM6					= 160,
+	CV_REG_XMM7					= 161,
+	CV_REG_XMM10				= 166,
+	CV_REG_XMM11				= 167,
+	CV_REG_XMM12				= 168,
+	CV_REG_XMM13				= 169,
+	CV_REG_MXCSR				= 211,
+	CV_REG_YMM0					= 252,
+	CV_REG_YMM1					= 253,
+	CV_REG_YMM2					= 254,
+	CV_REG_YMM3					= 255,
+	CV_REG_YMM4					= 256,
+	CV_REG_YMM5					= 257,
+	CV_REG_YMM6					= 258,
+	CV_REG_YMM7					= 259,
+
+	// x64 numbering; the general registers below 32 share the x86 values
+	CV_AMD64_FLAGS				= 32,
+	CV_AMD64_RIP				= 33,
+	CV_AMD64_EFLAGS				= 34,
+	CV_AMD64_CR8				= 88,
+	CV_AMD64_DR8				= 98,
+	CV_AMD64_DR9				= 99,
+	CV_AMD64_DR10				= 100,
+	CV_AMD64_DR11				= 101,
+	CV_AMD64_DR12				= 102,
+	CV_AMD64_DR13				= 103,
+	CV_AMD64_DR14				= 104,
+	CV_AMD64_DR15				= 105,
+	CV_AMD64_XMM8				= 252,
+	CV_AMD64_XMM9				= 253,
+	CV_AMD64_XMM10				= 254,
+	CV_AMD64_XMM11				= 255,
+	CV_AMD64_XMM12				= 256,
+	CV_AMD64_XMM13				= 257,
+	CV_AMD64_XMM14				= 258,
+	CV_AMD64_XMM15				= 259,
+	CV_AMD64_SIL				= 324,
+	CV_AMD64_DIL				= 325,
+	CV_AMD64_BPL				= 326,
+	CV_AMD64_SPL				= 327,
+	CV_AMD64_RAX				= 328,
+	CV_AMD64_RBX				= 329,
+	CV_AMD64_RCX				= 330,
+	CV_AMD64_RDX				= 331,
+	CV_AMD64_RSI				= 332,
+	CV_AMD64_RDI				= 333,
+	CV_AMD64_RBP				= 334,
+	CV_AMD64_RSP				= 335,
+	CV_AMD64_R8					= 336,
+	CV_AMD64_R9					= 337,
+	CV_AMD64_R10				= 338,
+	CV_AMD64_R11				= 339,
+	CV_AMD64_R12				= 340,
+	CV_AMD64_R13				= 341,
+	CV_AMD64_R14				= 342,
+	CV_AMD64_R15				= 343,
+	CV_AMD64_R8B				= 344,
+	CV_AMD64_R9B				= 345,
+	CV_AMD64_R10B				= 346,
+	CV_AMD64_R11B				= 347,
+	CV_AMD64_R12B				= 348,
+	CV_AMD64_R13B				= 349,
+	CV_AMD64_R14B				= 350,
+	CV_AMD64_R15B				= 351,
+	CV_AMD64_R8W				= 352,
+	CV_AMD64_R9W				= 353,
+	CV_AMD64_R10W				= 354,
+	CV_AMD64_R11W				= 355,
+	CV_AMD64_R12W				= 356,
+	CV_AMD64_R13W				= 357,
+	CV_AMD64_R14W				= 358,
+	CV_AMD64_R15W				= 359,
+	CV_AMD64_R8D				= 360,
+	CV_AMD64_R9D				= 361,
+	CV_AMD64_R10D				= 362,
+	CV_AMD64_R11D				= 363,
+	CV_AMD64_R12D				= 364,
+	CV_AMD64_R13D				= 365,
+	CV_AMD64_R14D				= 366,
+	CV_AMD64_R15D				= 367,
+	CV_AMD64_YMM0				= 368,
+	CV_AMD64_YMM1				= 369,
+	CV_AMD64_YMM2				= 370,
+	CV_AMD64_YMM3				= 371,
+	CV_AMD64_YMM4				= 372,
+	CV_AMD64_YMM5				= 373,
+	CV_AMD64_YMM6				= 374,
+	CV_AMD64_YMM7				= 375,
+	CV_AMD64_YMM8				= 376,
+	CV_AMD64_YMM9				= 377,
+	CV_AMD64_YMM10				= 378,
+	CV_AMD64_YMM11				= 379,
+	CV_AMD64_YMM12				= 380,
+	CV_AMD64_YMM13				= 381,
+	CV_AMD64_YMM14				= 382,
+	CV_AMD64_YMM15				= 383
+};
+
+enum BasicType
+{
+	btNoType					= 0,
+	btVoid						= 1,
+	btChar						= 2,
+	btWChar						= 3,
+	btInt						= 6,
+	btUInt						= 7,
+	btFloat						= 8,
+	btBCD						= 9,
+	btBool						= 10,
+	btLong						= 13,
+	btULong						= 14,
+	btCurrency					= 25,
+	btDate						= 26,
+	btVariant					= 27,
+	btComplex					= 28,
+	btBit						= 29,
+	btBSTR						= 30,
+	btHresult					= 31,
+	btChar16					= 32,
+	btChar32					= 33
+};
+
+#endif
\ No newline at end of file
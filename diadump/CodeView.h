@@ -0,0 +1,100 @@
+#ifndef __CODEVIEW_H__
+#define __CODEVIEW_H__
+
+//
+//	Raw CodeView record identifiers used when reading the PDB
+//	streams directly. Only the records we actually consume are listed.
+//
+namespace CodeView
+{
+	// fixed stream indices in a PDB 7.0 MSF container
+	enum StreamIndex
+	{
+		PDBStream	= 1,
+		TPIStream	= 2,
+		DBIStream	= 3,
+		IPIStream	= 4
+	};
+
+	enum SymbolKind
+	{
+		S_END									= 0x0006,
+		S_FRAMEPROC								= 0x1012,
+		S_THUNK32								= 0x1102,
+		S_BLOCK32								= 0x1103,
+		S_WITH32								= 0x1104,
+		S_REGISTER								= 0x1106,
+		S_BPREL32								= 0x110B,
+		S_LDATA32								= 0x110C,
+		S_GDATA32								= 0x110D,
+		S_LPROC32								= 0x110F,
+		S_GPROC32								= 0x1110,
+		S_REGREL32								= 0x1111,
+		S_SEPCODE								= 0x1132,
+		S_LOCAL									= 0x113E,
+		S_DEFRANGE								= 0x113F,
+		S_DEFRANGE_SUBFIELD						= 0x1140,
+		S_DEFRANGE_REGISTER						= 0x1141,
+		S_DEFRANGE_FRAMEPOINTER_REL				= 0x1142,
+		S_DEFRANGE_SUBFIELD_REGISTER			= 0x1143,
+		S_DEFRANGE_FRAMEPOINTER_REL_FULL_SCOPE	= 0x1144,
+		S_DEFRANGE_REGISTER_REL					= 0x1145,
+		S_LPROC32_ID							= 0x1146,
+		S_GPROC32_ID							= 0x1147,
+		S_INLINESITE							= 0x114D,
+		S_INLINESITE_END						= 0x114E,
+		S_PROC_ID_END							= 0x114F,
+		S_LPROC32_DPC							= 0x1155,
+		S_LPROC32_DPC_ID						= 0x1156
+	};
+
+	enum LeafKind
+	{
+		LF_MODIFIER		= 0x1001,
+		LF_POINTER		= 0x1002,
+		LF_PROCEDURE	= 0x1008,
+		LF_MFUNCTION	= 0x1009,
+		LF_FIELDLIST	= 0x1203,
+		LF_BCLASS		= 0x1400,
+		LF_VBCLASS		= 0x1401,
+		LF_IVBCLASS		= 0x1402,
+		LF_INDEX		= 0x1404,
+		LF_VFUNCTAB		= 0x1409,
+		LF_ENUMERATE	= 0x1502,
+		LF_ARRAY		= 0x1503,
+		LF_CLASS		= 0x1504,
+		LF_STRUCTURE	= 0x1505,
+		LF_UNION		= 0x1506,
+		LF_ENUM			= 0x1507,
+		LF_MEMBER		= 0x150D,
+		LF_STMEMBER		= 0x150E,
+		LF_METHOD		= 0x150F,
+		LF_NESTTYPE		= 0x1510,
+		LF_ONEMETHOD	= 0x1511,
+		LF_INTERFACE	= 0x1519,
+		LF_FUNC_ID		= 0x1601,
+		LF_MFUNC_ID		= 0x1602
+	};
+
+	// CV_prop_t bits on class/struct/union/enum records
+	enum UDTProperty
+	{
+		PropForwardRef		= 0x0080,
+		PropHasUniqueName	= 0x0200
+	};
+
+	// CV_LVARFLAGS bits on S_LOCAL
+	enum LocalFlags
+	{
+		LocalIsParam		= 0x0001,
+		LocalIsOptimizedOut	= 0x0100
+	};
+
+	// first type index that refers to a record rather than a built-in type
+	const unsigned long FirstNonSimpleTypeIndex = 0x1000;
+
+	// the signature that starts every C13 module symbol stream
+	const unsigned long ModuleSymbolSignature = 4;
+}
+
+#endif
@@ -0,0 +1,370 @@
+#include <stdexcept>
+#include <string.h>
+#include "Utility.h"
+#include "ColumnarFile.h"
+
+using namespace std;
+
+static const unsigned int ColumnarMagic = 0x46434444;	// "DDCF"
+static const unsigned int ColumnarVersion = 1;
+static const size_t HeaderSize = 24;
+static const size_t FooterEntrySize = 24;
+static const size_t ColumnEntrySize = 16;
+
+static const unsigned int NumTableColumns[NumColumnarTables] = { NumFunctionColumns, NumVariableColumns, NumInstructionColumns };
+
+// the offsets column of each variable-length value, which gets a leading 0 per row group
+static const unsigned int OffsetColumns[NumColumnarTables][2] =
+{
+	{ FunctionColumnNameOffsets, FunctionColumnCompilandOffsets },
+	{ VariableColumnNameOffsets, VariableColumnNameOffsets },
+	{ InstructionColumnOperandOffsets, InstructionColumnOperandOffsets }
+};
+
+template<typename T>
+static void Append(vector<unsigned char>& column, T value)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+	column.insert(column.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static T Read(const unsigned char* data)
+{
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+static void AppendString(vector<unsigned char>& offsets, vector<unsigned char>& bytes, const wstring& str)
+{
+	string utf8 = WideToUtf8(str);
+
+	bytes.insert(bytes.end(), utf8.begin(), utf8.end());
+	Append<unsigned int>(offsets, static_cast<unsigned int>(bytes.size()));
+}
+
+static void ResetColumns(vector<vector<unsigned char> >& columns, ColumnarTable table)
+{
+	columns.assign(NumTableColumns[table], vector<unsigned char>());
+
+	Append<unsigned int>(columns[OffsetColumns[table][0]], 0);
+
+	if(OffsetColumns[table][1] != OffsetColumns[table][0])
+		Append<unsigned int>(columns[OffsetColumns[table][1]], 0);
+}
+
+static size_t AlignUp(size_t value)
+{
+	return (value + 7) & ~static_cast<size_t>(7);
+}
+
+ColumnarWriter::ColumnarWriter(ostream& out, bool bIs64Bit, unsigned long long imageBase, unsigned long rowGroupSize)
+	: m_out(out), m_offset(0), m_rowGroupSize(rowGroupSize ? rowGroupSize : 1), m_currentFunction(0), m_currentFunctionRow(0),
+	m_functionFirstInstruction(0), m_functionFirstVariable(0)
+{
+	for(int table = 0; table < NumColumnarTables; ++table) {
+		ResetColumns(m_columns[table], static_cast<ColumnarTable>(table));
+		m_pendingRows[table] = 0;
+		m_tableRows[table] = 0;
+	}
+
+	vector<unsigned char> header;
+
+	Append<unsigned int>(header, ColumnarMagic);
+	Append<unsigned int>(header, ColumnarVersion);
+	Append<unsigned int>(header, bIs64Bit ? 1 : 0);
+	Append<unsigned int>(header, m_rowGroupSize);
+	Append<unsigned long long>(header, imageBase);
+
+	WriteBytes(&header[0], header.size());
+}
+
+unsigned long ColumnarWriter::BeginFunction(const Function& func)
+{
+	Columns& variables = m_columns[ColumnarVariables];
+
+	m_currentFunction = &func;
+	m_currentFunctionRow = m_tableRows[ColumnarFunctions];
+	m_functionFirstInstruction = m_tableRows[ColumnarInstructions];
+	m_functionFirstVariable = static_cast<unsigned long>(m_tableRows[ColumnarVariables]);
+
+	for(int listNum = 0; listNum < 2; ++listNum) {
+		const vector<Variable>& list = listNum == 0 ? func.parameters : func.localVariables;
+
+		for(vector<Variable>::const_iterator var = list.begin(), var_end = list.end(); var != var_end; ++var) {
+			Append<unsigned int>(variables[VariableColumnFunction], static_cast<unsigned int>(m_currentFunctionRow));
+			Append<unsigned char>(variables[VariableColumnIsParameter], listNum == 0 ? 1 : 0);
+			Append<unsigned char>(variables[VariableColumnLocation], static_cast<unsigned char>(var->location));
+			Append<unsigned short>(variables[VariableColumnRegister], static_cast<unsigned short>(var->eRegister));
+			Append<long long>(variables[VariableColumnOffset], var->offset);
+			AppendString(variables[VariableColumnNameOffsets], variables[VariableColumnNameBytes], var->name);
+
+			++m_pendingRows[ColumnarVariables];
+			++m_tableRows[ColumnarVariables];
+
+			if(m_pendingRows[ColumnarVariables] >= m_rowGroupSize)
+				FlushTable(ColumnarVariables);
+		}
+	}
+
+	return m_functionFirstVariable;
+}
+
+void ColumnarWriter::AddInstruction(const ColumnarInstruction& instr, const ColumnarOperand* operands, size_t numOperands)
+{
+	Columns& columns = m_columns[ColumnarInstructions];
+
+	Append<unsigned int>(columns[InstructionColumnRVA], static_cast<unsigned int>(instr.rva));
+	Append<unsigned int>(columns[InstructionColumnFunction], static_cast<unsigned int>(m_currentFunctionRow));
+	Append<unsigned char>(columns[InstructionColumnLength], instr.length);
+	Append<unsigned char>(columns[InstructionColumnFlags], instr.flags);
+	Append<unsigned short>(columns[InstructionColumnIClass], instr.iclass);
+	Append<unsigned int>(columns[InstructionColumnVariable], static_cast<unsigned int>(instr.variable));
+
+	for(size_t i = 0; i < numOperands; ++i) {
+		Append<unsigned char>(columns[InstructionColumnOperandKind], operands[i].kind);
+		Append<unsigned short>(columns[InstructionColumnOperandRegister], operands[i].reg);
+		Append<unsigned short>(columns[InstructionColumnOperandIndex], operands[i].indexReg);
+		Append<unsigned char>(columns[InstructionColumnOperandScale], operands[i].scale);
+		Append<long long>(columns[InstructionColumnOperandValue], operands[i].value);
+	}
+
+	Append<unsigned int>(columns[InstructionColumnOperandOffsets], static_cast<unsigned int>(columns[InstructionColumnOperandKind].size()));
+
+	++m_pendingRows[ColumnarInstructions];
+	++m_tableRows[ColumnarInstructions];
+
+	if(m_pendingRows[ColumnarInstructions] >= m_rowGroupSize)
+		FlushTable(ColumnarInstructions);
+}
+
+void ColumnarWriter::EndFunction()
+{
+	if(!m_currentFunction)
+		return;
+
+	Columns& columns = m_columns[ColumnarFunctions];
+
+	Append<unsigned int>(columns[FunctionColumnRVA], m_currentFunction->address);
+	Append<unsigned int>(columns[FunctionColumnLength], static_cast<unsigned int>(m_currentFunction->length));
+	Append<unsigned long long>(columns[FunctionColumnFirstInstruction], m_functionFirstInstruction);
+	Append<unsigned int>(columns[FunctionColumnNumInstructions], static_cast<unsigned int>(m_tableRows[ColumnarInstructions] - m_functionFirstInstruction));
+	Append<unsigned int>(columns[FunctionColumnFirstVariable], m_functionFirstVariable);
+	Append<unsigned int>(columns[FunctionColumnNumVariables], static_cast<unsigned int>(m_tableRows[ColumnarVariables] - m_functionFirstVariable));
+	AppendString(columns[FunctionColumnNameOffsets], columns[FunctionColumnNameBytes], m_currentFunction->name);
+	AppendString(columns[FunctionColumnCompilandOffsets], columns[FunctionColumnCompilandBytes], m_currentFunction->compiland);
+
+	m_currentFunction = 0;
+
+	++m_pendingRows[ColumnarFunctions];
+	++m_tableRows[ColumnarFunctions];
+
+	if(m_pendingRows[ColumnarFunctions] >= m_rowGroupSize)
+		FlushTable(ColumnarFunctions);
+}
+
+bool ColumnarWriter::Finish()
+{
+	EndFunction();
+
+	for(int table = 0; table < NumColumnarTables; ++table)
+		FlushTable(static_cast<ColumnarTable>(table));
+
+	vector<unsigned char> footer;
+
+	for(vector<RowGroupInfo>::const_iterator i = m_rowGroups.begin(), i_end = m_rowGroups.end(); i != i_end; ++i) {
+		Append<unsigned int>(footer, i->table);
+		Append<unsigned int>(footer, i->numRows);
+		Append<unsigned long long>(footer, i->firstRow);
+		Append<unsigned long long>(footer, i->fileOffset);
+	}
+
+	Append<unsigned int>(footer, static_cast<unsigned int>(m_rowGroups.size()));
+	Append<unsigned int>(footer, ColumnarMagic);
+
+	WriteBytes(&footer[0], footer.size());
+	m_out.flush();
+
+	return m_out.good();
+}
+
+unsigned long long ColumnarWriter::GetBytesWritten() const
+{
+	return m_offset;
+}
+
+void ColumnarWriter::FlushTable(ColumnarTable table)
+{
+	if(!m_pendingRows[table])
+		return;
+
+	Columns& columns = m_columns[table];
+
+	RowGroupInfo info;
+	info.table = table;
+	info.numRows = m_pendingRows[table];
+	info.firstRow = m_tableRows[table] - m_pendingRows[table];
+	info.fileOffset = m_offset;
+	m_rowGroups.push_back(info);
+
+	// column directory, then each column 8-byte aligned
+	vector<unsigned char> directory;
+	size_t columnOffset = AlignUp(8 + columns.size() * ColumnEntrySize);
+
+	Append<unsigned int>(directory, static_cast<unsigned int>(columns.size()));
+	Append<unsigned int>(directory, 0);
+
+	for(Columns::const_iterator i = columns.begin(), i_end = columns.end(); i != i_end; ++i) {
+		Append<unsigned long long>(directory, columnOffset);
+		Append<unsigned long long>(directory, i->size());
+		columnOffset = AlignUp(columnOffset + i->size());
+	}
+
+	directory.resize(AlignUp(directory.size()), 0);
+	WriteBytes(&directory[0], directory.size());
+
+	static const unsigned char padding[8] = { 0 };
+
+	for(Columns::const_iterator i = columns.begin(), i_end = columns.end(); i != i_end; ++i) {
+		if(!i->empty())
+			WriteBytes(&(*i)[0], i->size());
+
+		WriteBytes(padding, AlignUp(i->size()) - i->size());
+	}
+
+	ResetColumns(columns, table);
+	m_pendingRows[table] = 0;
+}
+
+void ColumnarWriter::WriteBytes(const void* data, size_t size)
+{
+	m_out.write(reinterpret_cast<const char*>(data), size);
+	m_offset += size;
+}
+
+ColumnarReader::ColumnarReader(const wstring& filename)
+	: m_file(new MappedFile(filename)), m_bIs64Bit(false), m_imageBase(0)
+{
+	const unsigned char*	data = m_file->GetData();
+	size_t					size = m_file->GetSize();
+
+	if(size < HeaderSize + 8 || Read<unsigned int>(data) != ColumnarMagic || Read<unsigned int>(data + size - 4) != ColumnarMagic)
+		throw runtime_error("Not a columnar dump.");
+
+	if(Read<unsigned int>(data + 4) != ColumnarVersion)
+		throw runtime_error("Unsupported columnar dump version.");
+
+	m_bIs64Bit = Read<unsigned int>(data + 8) != 0;
+	m_imageBase = Read<unsigned long long>(data + 16);
+
+	for(int table = 0; table < NumColumnarTables; ++table)
+		m_tableRows[table] = 0;
+
+	size_t numGroups = Read<unsigned int>(data + size - 8);
+
+	if(numGroups > (size - HeaderSize - 8) / FooterEntrySize)
+		throw runtime_error("Corrupt columnar dump.");
+
+	size_t footerStart = size - 8 - numGroups * FooterEntrySize;
+
+	for(size_t groupNum = 0; groupNum < numGroups; ++groupNum) {
+		const unsigned char* entry = data + footerStart + groupNum * FooterEntrySize;
+
+		RowGroup group;
+		unsigned int table = Read<unsigned int>(entry);
+		unsigned long long fileOffset = Read<unsigned long long>(entry + 16);
+
+		if(table >= NumColumnarTables || fileOffset < HeaderSize || fileOffset + 8 > footerStart)
+			throw runtime_error("Corrupt columnar dump.");
+
+		group.table = static_cast<ColumnarTable>(table);
+		group.numRows = Read<unsigned int>(entry + 4);
+		group.firstRow = Read<unsigned long long>(entry + 8);
+		group.data = data + fileOffset;
+		group.numColumns = Read<unsigned int>(group.data);
+
+		// every column has to lie before the footer
+		size_t groupSpace = footerStart - static_cast<size_t>(fileOffset);
+
+		if(group.numColumns < NumTableColumns[table] || 8 + group.numColumns * ColumnEntrySize > groupSpace)
+			throw runtime_error("Corrupt columnar dump.");
+
+		for(unsigned long column = 0; column < group.numColumns; ++column) {
+			unsigned long long columnOffset = Read<unsigned long long>(group.data + 8 + column * ColumnEntrySize);
+			unsigned long long columnSize = Read<unsigned long long>(group.data + 16 + column * ColumnEntrySize);
+
+			if(columnOffset > groupSpace || columnSize > groupSpace - columnOffset)
+				throw runtime_error("Corrupt columnar dump.");
+		}
+
+		if(group.firstRow + group.numRows > m_tableRows[table])
+			m_tableRows[table] = group.firstRow + group.numRows;
+
+		m_rowGroups.push_back(group);
+	}
+}
+
+bool ColumnarReader::Is64Bit() const
+{
+	return m_bIs64Bit;
+}
+
+unsigned long long ColumnarReader::GetImageBase() const
+{
+	return m_imageBase;
+}
+
+unsigned long long ColumnarReader::GetNumRows(ColumnarTable table) const
+{
+	return m_tableRows[table];
+}
+
+size_t ColumnarReader::GetNumRowGroups() const
+{
+	return m_rowGroups.size();
+}
+
+ColumnarTable ColumnarReader::GetRowGroupTable(size_t groupNum) const
+{
+	return m_rowGroups[groupNum].table;
+}
+
+unsigned long ColumnarReader::GetRowGroupNumRows(size_t groupNum) const
+{
+	return m_rowGroups[groupNum].numRows;
+}
+
+unsigned long long ColumnarReader::GetRowGroupFirstRow(size_t groupNum) const
+{
+	return m_rowGroups[groupNum].firstRow;
+}
+
+ByteSpan ColumnarReader::GetColumn(size_t groupNum, unsigned int column) const
+{
+	ByteSpan span;
+	span.data = 0;
+	span.size = 0;
+
+	if(groupNum >= m_rowGroups.size() || column >= m_rowGroups[groupNum].numColumns)
+		return span;
+
+	const unsigned char* entry = m_rowGroups[groupNum].data + 8 + column * ColumnEntrySize;
+
+	span.data = m_rowGroups[groupNum].data + Read<unsigned long long>(entry);
+	span.size = static_cast<size_t>(Read<unsigned long long>(entry + 8));
+
+	return span;
+}
+
+string ColumnarReader::GetString(size_t groupNum, unsigned int offsetsColumn, unsigned int bytesColumn, size_t row) const
+{
+	size_t					numOffsets;
+	const unsigned int*		offsets = GetColumn<unsigned int>(groupNum, offsetsColumn, numOffsets);
+	ByteSpan				bytes = GetColumn(groupNum, bytesColumn);
+
+	if(row + 1 >= numOffsets || offsets[row] > offsets[row + 1] || offsets[row + 1] > bytes.size)
+		return string();
+
+	return string(reinterpret_cast<const char*>(bytes.data) + offsets[row], offsets[row + 1] - offsets[row]);
+}
\ No newline at end of file
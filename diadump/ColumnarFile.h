@@ -0,0 +1,204 @@
+#ifndef __COLUMNARFILE_H__
+#define __COLUMNARFILE_H__
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "PDB.h"
+
+//
+//	A compact binary alternative to the text dump, for scripts that
+//	would otherwise re-parse every line. Three tables are written:
+//	functions, their variables and their instructions, each instruction
+//	carrying its explicit operands and the variable it was annotated with.
+//
+//	Each table is stored in row groups of up to rowGroupSize rows, and
+//	each row group stores every column as one packed little-endian array,
+//	8-byte aligned, so a reader maps the file and scans columns in place.
+//	Variable-length values (strings, an instruction's operands) are an
+//	offsets column with numRows + 1 entries into a values column of the
+//	same row group.
+//
+//	header		magic, version, 64-bit flag, row group size, image base
+//	row groups	column count, then offset and size of each column
+//				relative to the row group, then the column data
+//	footer		table, row count, first row and file offset of every
+//				row group, then the row group count and the magic again
+//
+
+enum ColumnarTable
+{
+	ColumnarFunctions,
+	ColumnarVariables,
+	ColumnarInstructions,
+	NumColumnarTables
+};
+
+enum ColumnarFunctionColumn
+{
+	FunctionColumnRVA,					// u32
+	FunctionColumnLength,				// u32
+	FunctionColumnFirstInstruction,		// u64, row in the instructions table
+	FunctionColumnNumInstructions,		// u32
+	FunctionColumnFirstVariable,		// u32, row in the variables table
+	FunctionColumnNumVariables,			// u32
+	FunctionColumnNameOffsets,			// u32[numRows + 1]
+	FunctionColumnNameBytes,			// UTF-8
+	FunctionColumnCompilandOffsets,		// u32[numRows + 1]
+	FunctionColumnCompilandBytes,		// UTF-8
+	NumFunctionColumns
+};
+
+// a function's parameters come first, then its locals
+enum ColumnarVariableColumn
+{
+	VariableColumnFunction,				// u32
+	VariableColumnIsParameter,			// u8
+	VariableColumnLocation,				// u8, VariableLocation
+	VariableColumnRegister,				// u16, CV_HREG_e
+	VariableColumnOffset,				// i64
+	VariableColumnNameOffsets,			// u32[numRows + 1]
+	VariableColumnNameBytes,			// UTF-8
+	NumVariableColumns
+};
+
+enum ColumnarInstructionColumn
+{
+	InstructionColumnRVA,				// u32
+	InstructionColumnFunction,			// u32
+	InstructionColumnLength,			// u8
+	InstructionColumnFlags,				// u8, InstructionFlags
+	InstructionColumnIClass,			// u16, xed_iclass_enum_t
+	InstructionColumnVariable,			// u32, row in the variables table or NoColumnarVariable
+	InstructionColumnOperandOffsets,	// u32[numRows + 1]
+	InstructionColumnOperandKind,		// u8, ColumnarOperandKind
+	InstructionColumnOperandRegister,	// u16, xed_reg_enum_t: the register or memory base
+	InstructionColumnOperandIndex,		// u16, xed_reg_enum_t: the memory index
+	InstructionColumnOperandScale,		// u8
+	InstructionColumnOperandValue,		// i64: displacement, immediate or branch target RVA
+	NumInstructionColumns
+};
+
+enum ColumnarOperandKind
+{
+	OperandRegister,
+	OperandMemory,
+	OperandImmediate,
+	OperandBranch
+};
+
+const unsigned long NoColumnarVariable = 0xFFFFFFFF;
+
+typedef struct
+{
+	unsigned char			kind;
+	unsigned short			reg;
+	unsigned short			indexReg;
+	unsigned char			scale;
+	long long				value;
+} ColumnarOperand;
+
+typedef struct
+{
+	unsigned long			rva;
+	unsigned char			length;
+	unsigned char			flags;
+	unsigned short			iclass;
+	unsigned long			variable;
+} ColumnarInstruction;
+
+class ColumnarWriter
+{
+public:
+	ColumnarWriter(std::ostream& out, bool bIs64Bit, unsigned long long imageBase, unsigned long rowGroupSize = 1 << 16);
+
+	// adds the function's variables; returns the row of its first variable,
+	// which plus the variable's position gives InstructionColumnVariable
+	unsigned long					BeginFunction(const Function& func);
+	void							AddInstruction(const ColumnarInstruction& instr, const ColumnarOperand* operands, size_t numOperands);
+	void							EndFunction();
+
+	// writes what's left and the footer
+	bool							Finish();
+	unsigned long long				GetBytesWritten() const;
+
+private:
+	ColumnarWriter(const ColumnarWriter&);
+	ColumnarWriter&					operator=(const ColumnarWriter&);
+
+	typedef struct
+	{
+		unsigned long				table;
+		unsigned long				numRows;
+		unsigned long long			firstRow;
+		unsigned long long			fileOffset;
+	} RowGroupInfo;
+
+	typedef std::vector<std::vector<unsigned char> >	Columns;
+
+	void							FlushTable(ColumnarTable table);
+	void							WriteBytes(const void* data, size_t size);
+
+	std::ostream&					m_out;
+	unsigned long long				m_offset;
+	unsigned long					m_rowGroupSize;
+
+	Columns							m_columns[NumColumnarTables];
+	unsigned long					m_pendingRows[NumColumnarTables];
+	unsigned long long				m_tableRows[NumColumnarTables];
+	std::vector<RowGroupInfo>		m_rowGroups;
+
+	const Function*					m_currentFunction;
+	unsigned long long				m_currentFunctionRow;
+	unsigned long long				m_functionFirstInstruction;
+	unsigned long					m_functionFirstVariable;
+};
+
+class ColumnarReader
+{
+public:
+	explicit ColumnarReader(const std::wstring& filename);
+
+	bool							Is64Bit() const;
+	unsigned long long				GetImageBase() const;
+	unsigned long long				GetNumRows(ColumnarTable table) const;
+
+	// row groups of every table, in file order
+	size_t							GetNumRowGroups() const;
+	ColumnarTable					GetRowGroupTable(size_t groupNum) const;
+	unsigned long					GetRowGroupNumRows(size_t groupNum) const;
+	unsigned long long				GetRowGroupFirstRow(size_t groupNum) const;
+	ByteSpan						GetColumn(size_t groupNum, unsigned int column) const;
+
+	template<typename T>
+	const T*						GetColumn(size_t groupNum, unsigned int column, size_t& count) const
+	{
+		ByteSpan span = GetColumn(groupNum, column);
+		count = span.size / sizeof(T);
+		return reinterpret_cast<const T*>(span.data);
+	}
+
+	// one value of an offsets + bytes string column pair
+	std::string						GetString(size_t groupNum, unsigned int offsetsColumn, unsigned int bytesColumn, size_t row) const;
+
+private:
+	typedef struct
+	{
+		ColumnarTable				table;
+		unsigned long				numRows;
+		unsigned long long			firstRow;
+		const unsigned char*		data;
+		unsigned long				numColumns;
+	} RowGroup;
+
+	std::shared_ptr<MappedFile>	m_file;
+	bool							m_bIs64Bit;
+	unsigned long long				m_imageBase;
+	unsigned long long				m_tableRows[NumColumnarTables];
+	std::vector<RowGroup>			m_rowGroups;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,151 @@
+extern "C"
+{
+#include <xed-interface.h>
+}
+
+#include <algorithm>
+#include "ControlFlowGraph.h"
+
+using namespace std;
+
+ControlFlowGraph::ControlFlowGraph()
+{
+}
+
+void ControlFlowGraph::Build(const DisassembledFunction& disasFunc, const vector<unsigned int>& branchTargets)
+{
+	size_t numInstrs = disasFunc.offsets.size();
+
+	m_blockStarts.clear();
+	m_blockOf.assign(numInstrs, 0);
+	m_succOffsets.assign(1, 0);
+	m_succs.clear();
+	m_predOffsets.assign(1, 0);
+	m_preds.clear();
+
+	if(!numInstrs) {
+		m_blockStarts.push_back(0);
+		return;
+	}
+
+	// branch targets are offsets, map each to an instruction number
+	// (offsets are sorted); a target mid-instruction isn't a block start
+	vector<unsigned int> targetInstrs(numInstrs, NoTarget);
+
+	for(size_t i = 0; i < numInstrs; ++i) {
+		if(branchTargets[i] == NoTarget)
+			continue;
+
+		vector<unsigned int>::const_iterator found = lower_bound(disasFunc.offsets.begin(), disasFunc.offsets.end(), branchTargets[i]);
+
+		if(found != disasFunc.offsets.end() && *found == branchTargets[i])
+			targetInstrs[i] = static_cast<unsigned int>(found - disasFunc.offsets.begin());
+	}
+
+	vector<unsigned char> bLeader(numInstrs + 1, 0);
+	bLeader[0] = 1;
+
+	for(size_t i = 0; i < numInstrs; ++i) {
+		unsigned char	category = disasFunc.categories[i];
+		bool			bValid = (disasFunc.flags[i] & InstrValid) != 0;
+
+		// data and undecodable bytes sit in blocks of their own
+		if(!bValid)
+			bLeader[i] = bLeader[i + 1] = 1;
+
+		if(category == XED_CATEGORY_COND_BR || category == XED_CATEGORY_UNCOND_BR || category == XED_CATEGORY_RET)
+			bLeader[i + 1] = 1;
+
+		if(targetInstrs[i] != NoTarget)
+			bLeader[targetInstrs[i]] = 1;
+	}
+
+	for(size_t i = 0; i < numInstrs; ++i) {
+		if(bLeader[i])
+			m_blockStarts.push_back(static_cast<unsigned int>(i));
+
+		m_blockOf[i] = static_cast<unsigned int>(m_blockStarts.size() - 1);
+	}
+
+	size_t numBlocks = m_blockStarts.size();
+	m_blockStarts.push_back(static_cast<unsigned int>(numInstrs));
+
+	vector<unsigned int> edgeFrom;
+	vector<unsigned int> edgeTo;
+
+	for(size_t block = 0; block < numBlocks; ++block) {
+		size_t			last = m_blockStarts[block + 1] - 1;
+		unsigned char	category = disasFunc.categories[last];
+		bool			bFallsThrough = (disasFunc.flags[last] & InstrValid) != 0 &&
+										category != XED_CATEGORY_UNCOND_BR && category != XED_CATEGORY_RET &&
+										disasFunc.iclasses[last] != XED_ICLASS_INT3;
+
+		// a call's target is another function, so only jumps give edges here
+		bool			bJump = category == XED_CATEGORY_COND_BR || category == XED_CATEGORY_UNCOND_BR;
+		unsigned int	targetBlock = bJump && targetInstrs[last] != NoTarget ? m_blockOf[targetInstrs[last]] : NoTarget;
+
+		if(targetBlock != NoTarget) {
+			edgeFrom.push_back(static_cast<unsigned int>(block));
+			edgeTo.push_back(targetBlock);
+		}
+
+		if(bFallsThrough && block + 1 < numBlocks && targetBlock != block + 1) {
+			edgeFrom.push_back(static_cast<unsigned int>(block));
+			edgeTo.push_back(static_cast<unsigned int>(block + 1));
+		}
+	}
+
+	BuildAdjacency(numBlocks, edgeFrom, edgeTo, m_succOffsets, m_succs);
+	BuildAdjacency(numBlocks, edgeTo, edgeFrom, m_predOffsets, m_preds);
+}
+
+void ControlFlowGraph::BuildAdjacency(size_t numBlocks, const vector<unsigned int>& from, const vector<unsigned int>& to,
+	vector<unsigned int>& offsets, vector<unsigned int>& edges)
+{
+	// count, prefix sum, then scatter, keeping edge order per block
+	offsets.assign(numBlocks + 1, 0);
+
+	for(size_t i = 0, i_end = from.size(); i < i_end; ++i)
+		++offsets[from[i] + 1];
+
+	for(size_t block = 0; block < numBlocks; ++block)
+		offsets[block + 1] += offsets[block];
+
+	vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+	edges.resize(from.size());
+
+	for(size_t i = 0, i_end = from.size(); i < i_end; ++i)
+		edges[next[from[i]]++] = to[i];
+}
+
+size_t ControlFlowGraph::GetNumBlocks() const
+{
+	return m_blockStarts.size() - 1;
+}
+
+unsigned int ControlFlowGraph::GetBlockStart(size_t block) const
+{
+	return m_blockStarts[block];
+}
+
+unsigned int ControlFlowGraph::GetBlockEnd(size_t block) const
+{
+	return m_blockStarts[block + 1];
+}
+
+unsigned int ControlFlowGraph::GetBlockOf(unsigned int instrNum) const
+{
+	return m_blockOf[instrNum];
+}
+
+const unsigned int* ControlFlowGraph::GetSuccessors(size_t block, size_t& count) const
+{
+	count = m_succOffsets[block + 1] - m_succOffsets[block];
+	return count ? &m_succs[m_succOffsets[block]] : 0;
+}
+
+const unsigned int* ControlFlowGraph::GetPredecessors(size_t block, size_t& count) const
+{
+	count = m_predOffsets[block + 1] - m_predOffsets[block];
+	return count ? &m_preds[m_predOffsets[block]] : 0;
+}
\ No newline at end of file
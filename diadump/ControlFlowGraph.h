@@ -0,0 +1,46 @@
+#ifndef __CONTROLFLOWGRAPH_H__
+#define __CONTROLFLOWGRAPH_H__
+
+#include <vector>
+
+#include "DisassembledFunction.h"
+
+//
+//	Basic blocks of one function and the edges between them. Blocks
+//	are runs of instruction numbers in the DisassembledFunction; edges
+//	are kept CSR style, one flat array of successors (and one of
+//	predecessors) with a per-block offset into it.
+//
+class ControlFlowGraph
+{
+public:
+	static const unsigned int	NoTarget = 0xFFFFFFFF;
+
+	ControlFlowGraph();
+
+	// branchTargets holds the target offset of each relative branch, NoTarget elsewhere
+	void						Build(const DisassembledFunction& disasFunc, const std::vector<unsigned int>& branchTargets);
+
+	size_t						GetNumBlocks() const;
+	unsigned int				GetBlockStart(size_t block) const;
+	unsigned int				GetBlockEnd(size_t block) const;
+	unsigned int				GetBlockOf(unsigned int instrNum) const;
+
+	const unsigned int*			GetSuccessors(size_t block, size_t& count) const;
+	const unsigned int*			GetPredecessors(size_t block, size_t& count) const;
+
+private:
+	static void					BuildAdjacency(size_t numBlocks, const std::vector<unsigned int>& from, const std::vector<unsigned int>& to,
+									std::vector<unsigned int>& offsets, std::vector<unsigned int>& edges);
+
+	// first instruction of each block, plus the instruction count at the end
+	std::vector<unsigned int>	m_blockStarts;
+	std::vector<unsigned int>	m_blockOf;
+
+	std::vector<unsigned int>	m_succOffsets;
+	std::vector<unsigned int>	m_succs;
+	std::vector<unsigned int>	m_predOffsets;
+	std::vector<unsigned int>	m_preds;
+};
+
+#endif
\ No newline at end of file
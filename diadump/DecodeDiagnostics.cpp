@@ -0,0 +1,94 @@
+#include <iomanip>
+#include <string.h>
+
+#include "DecodeDiagnostics.h"
+
+using namespace std;
+
+// functions listed by name in the summary, the rest are only counted
+static const size_t MaxListedFunctions = 10;
+
+void ResetDecodeDiagnostics(DecodeDiagnostics& diag)
+{
+	memset(&diag, 0, sizeof(diag));
+}
+
+void AddInvalidRegion(DecodeDiagnostics& diag, const unsigned char* code, size_t codeSize, size_t offset, size_t length)
+{
+	if(!diag.numInvalidRegions) {
+		size_t numBytes = codeSize - offset < MaxDiagnosticBytes ? codeSize - offset : MaxDiagnosticBytes;
+
+		diag.firstInvalidOffset = static_cast<unsigned int>(offset);
+		diag.numFirstInvalidBytes = static_cast<unsigned char>(numBytes);
+		memcpy(diag.firstInvalidBytes, code + offset, numBytes);
+	}
+
+	++diag.numInvalidRegions;
+	diag.invalidBytes += length;
+}
+
+DecodeSummary::DecodeSummary()
+{
+	Clear();
+}
+
+void DecodeSummary::Clear()
+{
+	m_numFunctions = 0;
+	m_numInvalidRegions = 0;
+	m_invalidBytes = 0;
+	m_paddingBytes = 0;
+	m_listed.clear();
+}
+
+void DecodeSummary::Add(const Function& func, const DecodeDiagnostics& diag)
+{
+	m_paddingBytes += diag.paddingBytes;
+
+	if(!diag.numInvalidRegions)
+		return;
+
+	++m_numFunctions;
+	m_numInvalidRegions += diag.numInvalidRegions;
+	m_invalidBytes += diag.invalidBytes;
+
+	if(m_listed.size() < MaxListedFunctions) {
+		ListedFunction listed;
+
+		listed.compiland = func.compiland;
+		listed.name = func.name;
+		listed.address = func.address;
+		listed.diag = diag;
+
+		m_listed.push_back(listed);
+	}
+}
+
+bool DecodeSummary::IsEmpty() const
+{
+	return !m_numInvalidRegions;
+}
+
+void DecodeSummary::Write(wostream& out) const
+{
+	if(IsEmpty())
+		return;
+
+	out << L"Invalid instructions: " << dec << m_numInvalidRegions << L" regions, " << m_invalidBytes << L" bytes, in "
+		<< m_numFunctions << L" functions (" << m_paddingBytes << L" padding bytes skipped)" << endl;
+
+	for(vector<ListedFunction>::const_iterator i = m_listed.begin(), i_end = m_listed.end(); i != i_end; ++i) {
+		out << L"  " << i->compiland << L" " << i->name << L": " << dec << i->diag.numInvalidRegions << L" regions, "
+			<< i->diag.invalidBytes << L" bytes, first at RVA 0x" << hex << uppercase << i->address + i->diag.firstInvalidOffset << L":";
+
+		for(size_t byteNum = 0; byteNum < i->diag.numFirstInvalidBytes; ++byteNum)
+			out << L" " << nouppercase << setw(2) << setfill(L'0') << static_cast<unsigned int>(i->diag.firstInvalidBytes[byteNum]);
+
+		out << dec << setfill(L' ') << endl;
+	}
+
+	if(m_numFunctions > m_listed.size())
+		out << L"  ... and " << m_numFunctions - m_listed.size() << L" more functions" << endl;
+
+	out << endl;
+}
\ No newline at end of file
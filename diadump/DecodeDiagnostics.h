@@ -0,0 +1,62 @@
+#ifndef __DECODEDIAGNOSTICS_H__
+#define __DECODEDIAGNOSTICS_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PDB.h"
+
+// bytes shown for the first bad spot in a function
+static const size_t MaxDiagnosticBytes = 15;
+
+//
+//	What went wrong decoding one function. Filled in by the decoders
+//	instead of printing as they go, then added to a DecodeSummary
+//	once the function is done.
+//
+typedef struct
+{
+	unsigned int		numInvalidRegions;
+	unsigned long long	invalidBytes;
+	unsigned long long	paddingBytes;
+
+	unsigned int		firstInvalidOffset;
+	unsigned char		firstInvalidBytes[MaxDiagnosticBytes];
+	unsigned char		numFirstInvalidBytes;
+} DecodeDiagnostics;
+
+void	ResetDecodeDiagnostics(DecodeDiagnostics& diag);
+void	AddInvalidRegion(DecodeDiagnostics& diag, const unsigned char* code, size_t codeSize, size_t offset, size_t length);
+
+//
+//	Decode problems for a whole run: totals, plus the first few
+//	functions that had any, in the order they were added.
+//
+class DecodeSummary
+{
+public:
+	DecodeSummary();
+
+	void				Clear();
+	void				Add(const Function& func, const DecodeDiagnostics& diag);
+	bool				IsEmpty() const;
+	void				Write(std::wostream& out) const;
+
+private:
+	typedef struct
+	{
+		std::wstring		compiland;
+		std::wstring		name;
+		unsigned long		address;
+		DecodeDiagnostics	diag;
+	} ListedFunction;
+
+	unsigned long long				m_numFunctions;
+	unsigned long long				m_numInvalidRegions;
+	unsigned long long				m_invalidBytes;
+	unsigned long long				m_paddingBytes;
+	std::vector<ListedFunction>		m_listed;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __DISASSEMBLEDFUNCTION_H__
+#define __DISASSEMBLEDFUNCTION_H__
+
+#include <vector>
+
+#include "MappedFile.h"
+
+// bits in DisassembledFunction::flags
+enum InstructionFlags
+{
+	InstrValid				= 0x01,
+	InstrHasMemoryOperand	= 0x02,
+	InstrHasIndexRegister	= 0x04,
+	InstrRelativeBranch		= 0x08,
+	InstrData				= 0x10
+};
+
+// data records are split every this many bytes, one output line each
+static const size_t DataChunkSize = 16;
+
+//
+//	Decoded instructions of one function, one array per field.
+//	Only what we need to walk and summarize the code is kept; the
+//	bytes stay in the mapped image and the full XED decode is redone
+//	by DecodeInstruction when an instruction is actually printed.
+//
+typedef struct
+{
+	ByteSpan						code;
+
+	std::vector<unsigned int>		offsets;
+	std::vector<unsigned char>		lengths;
+	std::vector<unsigned short>		iclasses;
+	std::vector<unsigned char>		categories;
+	std::vector<unsigned char>		flags;
+	std::vector<unsigned char>		numOperands;
+} DisassembledFunction;
+
+#endif
\ No newline at end of file
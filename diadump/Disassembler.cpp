@@ -7,21 +7,27 @@ extern "C"
 #include <vector>
 #include <string>
 #include <sstream>
-#include <iomanip>
 #include <iostream>
+#include <algorithm>
+#include <string.h>
 
 #include "Disassembler.h"
+#include "Parallel.h"
+#include "Stats.h"
+#include "XedTables.h"
 
 using namespace std;
 
-xed_reg_enum_t	PDBRegToDisasReg(CV_HREG_e reg);
+// a run of this many identical fill bytes is padding or zeroed data, not code
+static const size_t MinFillRun = 8;
 
-Disassembler::Disassembler(const wchar_t* exeFilename)
-	: m_pe(exeFilename), m_pdb(exeFilename)
+Disassembler::Disassembler(const wchar_t* exeFilename, const wstring& symbolCacheDir)
+	: m_pe(exeFilename), m_pdb(m_pe, exeFilename, symbolCacheDir), m_registers(m_pe.Is64Bit()),
+	m_frameDataflow(m_registers, m_pe.Is64Bit()), m_recursiveDescent(m_pe), m_bRecursive(false), m_bOutputCFG(false), m_diag(&wcout)
 {
 	m_functions = m_pdb.GetFunctions();
 
-	xed_tables_init();
+	InitXedTables();
 
 	// The state of the machine -- required for decoding
     if (m_pe.Is64Bit()) {
@@ -34,579 +40,832 @@ Disassembler::Disassembler(const wchar_t* exeFilename)
     }
 }
 
-bool Disassembler::DisassembleFunctions()
+void Disassembler::SetRecursiveDescent(bool bRecursive)
 {
-	for(vector<Function>::const_iterator i = m_functions.begin(), i_end = m_functions.end();
-		i != i_end; ++i) {
-
-			DisassembledFunction currFunction;
-
-			unsigned long functionOffset = m_pe.getOffsetForRVA(i->address);
-			std::tr1::shared_ptr<const unsigned char> functionCode(m_pe.getSectionsBuf(), m_pe.getSectionsBuf().get() + functionOffset);
-
-			for(size_t offset = 0; offset < i->length;) {
-				DisassembledInstruction currInstr;
-
-				xed_error_enum_t	xed_error;
-				xed_decoded_inst_t	xedd;
-
-				xed_decoded_inst_zero(&xedd);
-				xed_decoded_inst_set_mode(&xedd, m_machineMode, m_stackAddrWidth);
-
-				xed_error = xed_decode(&xedd, 
-					XED_STATIC_CAST(const xed_uint8_t*, functionCode.get() + offset),
-					15);
-		
-				if(xed_error == XED_ERROR_NONE) {
-					xed_uint_t instrLen = xed_decoded_inst_get_length(&xedd);
-					
-					currInstr.instr = xedd;
-					currInstr.offsetFromFunctionStart = offset;
-					currInstr.bytes.resize(instrLen);
-					memcpy_s(&currInstr.bytes[0], instrLen, functionCode.get() + offset, instrLen);
-					currInstr.validInstruction = true;
-
-					offset += instrLen;
-				} else {
-					wcout	<< L"Invalid instruction:" << endl
-							<< i->compiland << endl
-							<< i->name << endl
-							<< "Offset: " << offset << endl
-							<< "Bytes:";
-
-					for(int byteNum = 0; byteNum < 15; ++byteNum)
-						wcout << L" " << hex << nouppercase << setw(2) << setfill(L'0') << *static_cast<const unsigned char*>(functionCode.get() + offset + byteNum);
-
-					wcout << endl << endl;
-
-					xed_decoded_inst_zero(&currInstr.instr);
-					currInstr.offsetFromFunctionStart = 0;
-					currInstr.validInstruction = false;
-
-					// try again at the next byte
-					++offset;
-				}
-
-				currFunction.instructions.push_back(currInstr);
-			}
+	m_bRecursive = bRecursive;
+}
+
+void Disassembler::SetOutputControlFlowGraph(bool bOutputCFG)
+{
+	m_bOutputCFG = bOutputCFG;
+}
+
+void Disassembler::SetDiagnosticStream(wostream& diag)
+{
+	m_diag = &diag;
+}
+
+void Disassembler::SelectFunctions(const FunctionFilter& filter)
+{
+	vector<size_t>			indices;
+	const vector<Function>&	functions = m_pdb.GetFunctions();
+
+	filter.Select(m_pdb, indices);
+
+	// anything already disassembled belonged to the old selection
+	m_functions.clear();
+	m_functions.reserve(indices.size());
+	m_disassembledFunctions.clear();
+
+	for(vector<size_t>::const_iterator i = indices.begin(), i_end = indices.end(); i != i_end; ++i)
+		m_functions.push_back(functions[*i]);
+}
+
+void Disassembler::AddFunctions(const vector<Function>& functions, const FunctionFilter& filter)
+{
+	m_disassembledFunctions.clear();
+
+	for(vector<Function>::const_iterator i = functions.begin(), i_end = functions.end(); i != i_end; ++i) {
+		if(filter.IsEmpty() || filter.Matches(*i))
+			m_functions.push_back(*i);
+	}
+}
 
-			m_disassembledFunctions.push_back(currFunction);
+bool Disassembler::DisassembleFunctions(unsigned int numJobs)
+{
+	m_disassembledFunctions.assign(m_functions.size(), DisassembledFunction());
+
+	// each function writes only its own slot, and decode problems
+	// are summed up in function order once everything is done
+	vector<DecodeDiagnostics> diagnostics(m_functions.size());
+
+	if(numJobs == 1) {
+		for(size_t i = 0, i_end = m_functions.size(); i < i_end; ++i)
+			DisassembleFunction(m_functions[i], m_disassembledFunctions[i], diagnostics[i]);
+	} else {
+		// hand out the biggest functions first so a single huge
+		// one doesn't end up being the last thing left running
+		vector<size_t> order(m_functions.size());
+
+		for(size_t i = 0, i_end = order.size(); i < i_end; ++i)
+			order[i] = i;
+
+		stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+			return m_functions[a].length > m_functions[b].length;
+		});
+
+		ParallelFor(order, numJobs, [this, &diagnostics](size_t funcNum) {
+			DisassembleFunction(m_functions[funcNum], m_disassembledFunctions[funcNum], diagnostics[funcNum]);
+		});
 	}
 
+	m_decodeSummary.Clear();
+
+	for(size_t i = 0, i_end = m_functions.size(); i < i_end; ++i)
+		m_decodeSummary.Add(m_functions[i], diagnostics[i]);
+
+	m_decodeSummary.Write(*m_diag);
+
 	return true;
 }
 
-bool Disassembler::OutputFunctionDisassembly(vector<Function>::const_iterator funcIter, wostream& out) const
+void Disassembler::DisassembleFunction(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const
 {
-	unsigned long long funcAddr = m_pe.getImageBase() + funcIter->address;
+	PhaseTimer timer(PhaseDecode);
 
-	vector<DisassembledFunction>::const_iterator disasFuncIter = m_disassembledFunctions.begin() + (funcIter - m_functions.begin());
+	ResetDecodeDiagnostics(diag);
 
-	out << endl
-		<< funcIter->compiland << endl
-		<< funcIter->name << endl
-		<< L"0x" << hex << uppercase << setw(16) << setfill(L'0') << funcAddr << L" - "
-		<< L"0x" << hex << uppercase << setw(16) << setfill(L'0') << funcAddr + funcIter->length - 1 << endl
-		<< endl;
+	if(m_bRecursive) {
+		m_recursiveDescent.DecodeFunction(func, disasFunc, diag);
+	} else {
+		DisassembleLinear(func, disasFunc, diag);
+	}
 
-	string instrDumpStr;
-	instrDumpStr.resize(256);
+	if(!IsStatsEnabled())
+		return;
 
-	for(vector<DisassembledInstruction>::const_iterator i = disasFuncIter->instructions.begin(), i_end = disasFuncIter->instructions.end();
-		i != i_end; ++i) {
+	unsigned long long numInstructions = 0;
 
-			unsigned long long instrAddr = funcAddr + i->offsetFromFunctionStart;
-			out << L"0x" << hex << uppercase << setw(16) << setfill(L'0') << right << instrAddr << L" ";
+	for(vector<unsigned char>::const_iterator i = disasFunc.flags.begin(), i_end = disasFunc.flags.end(); i != i_end; ++i) {
+		if(*i & InstrValid)
+			++numInstructions;
+	}
 
-			xed_decoded_inst_dump_intel_format(&i->instr, &instrDumpStr[0], 255, instrAddr);
+	AddStatsCounter(CounterFunctions, 1);
+	AddStatsCounter(CounterInstructions, numInstructions);
+	AddStatsCounter(CounterInvalidResyncs, diag.numInvalidRegions);
+}
 
-			wstring tmpWideStr(instrDumpStr.begin(), instrDumpStr.begin() + strlen(instrDumpStr.c_str()));
-			out << setfill(L' ') << setw(40) << left << tmpWideStr;
+void Disassembler::DisassembleLinear(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const
+{
+
+	// decode straight out of the mapped image, only
+	// as much of the function as is backed by the file
+	ByteSpan functionCode;
+
+	if(!m_pe.getRVARange(func.address, func.length, functionCode)) {
+		return;
+	}
 
-			wstringstream bytes;
+	disasFunc.code = functionCode;
 
-			for(size_t byteNum = 0, byteNum_end = i->bytes.length(); byteNum < byteNum_end; ++byteNum)
-						bytes << L" " << hex << nouppercase << setw(2) << setfill(L'0') << right << static_cast<const unsigned char>(i->bytes[byteNum]);
+	// start of the fill and undecodable bytes we're skipping over, if any;
+	// the data records cover both, the diagnostics only the undecodable runs
+	size_t	dataStart = functionCode.size;
+	bool	bInInvalidRun = false;
+
+	for(size_t offset = 0; offset < functionCode.size;) {
+		// fill runs are never worth decoding a byte at a time
+		size_t fillEnd = GetFillRunEnd(functionCode, offset);
+
+		if(fillEnd > offset) {
+			if(dataStart == functionCode.size)
+				dataStart = offset;
+
+			bInInvalidRun = false;
+			diag.paddingBytes += fillEnd - offset;
+			offset = fillEnd;
+			continue;
+		}
 
-			out << setw(45) << bytes.str();
+		xed_error_enum_t	xed_error;
+		xed_decoded_inst_t	xedd;
 
-			// if we hit a 'ret' instruction, don't read further
-			if(xed_decoded_inst_get_category(&i->instr) == XED_CATEGORY_RET) {
-				out << endl;
-				break;
+		xed_decoded_inst_zero(&xedd);
+		xed_decoded_inst_set_mode(&xedd, m_machineMode, m_stackAddrWidth);
+
+		size_t bytesLeft = functionCode.size - offset;
+
+		xed_error = xed_decode(&xedd, 
+			XED_STATIC_CAST(const xed_uint8_t*, functionCode.data + offset),
+			static_cast<unsigned int>(bytesLeft < 15 ? bytesLeft : 15));
+
+		if(xed_error != XED_ERROR_NONE) {
+			// the first bad byte opens a data region, or joins the fill
+			// before it, and starts an invalid run; then try the next byte
+			if(dataStart == functionCode.size)
+				dataStart = offset;
+
+			if(!bInInvalidRun) {
+				bInInvalidRun = true;
+				AddInvalidRegion(diag, functionCode.data, functionCode.size, offset, 0);
 			}
 
-			PrintOperands(*i, *funcIter, out);
+			++diag.invalidBytes;
+			++offset;
+			continue;
+		}
+
+		if(dataStart != functionCode.size) {
+			AddDataRecords(dataStart, offset, disasFunc);
+			dataStart = functionCode.size;
+			bInInvalidRun = false;
+		}
+
+		xed_uint_t		instrLen = xed_decoded_inst_get_length(&xedd);
+		unsigned char	instrFlags = InstrValid;
+		xed_uint_t		numMemOps = xed_decoded_inst_number_of_memory_operands(&xedd);
+
+		for(xed_uint_t memOp = 0; memOp < numMemOps; ++memOp) {
+			instrFlags |= InstrHasMemoryOperand;
 
-			out << endl;
+			if(xed_decoded_inst_get_index_reg(&xedd, memOp) != XED_REG_INVALID)
+				instrFlags |= InstrHasIndexRegister;
+		}
+
+		if(xed_decoded_inst_get_branch_displacement_width(&xedd))
+			instrFlags |= InstrRelativeBranch;
+
+		disasFunc.offsets.push_back(static_cast<unsigned int>(offset));
+		disasFunc.lengths.push_back(static_cast<unsigned char>(instrLen));
+		disasFunc.iclasses.push_back(static_cast<unsigned short>(xed_decoded_inst_get_iclass(&xedd)));
+		disasFunc.categories.push_back(static_cast<unsigned char>(xed_decoded_inst_get_category(&xedd)));
+		disasFunc.flags.push_back(instrFlags);
+		disasFunc.numOperands.push_back(static_cast<unsigned char>(xed_inst_noperands(xed_decoded_inst_inst(&xedd))));
+
+		offset += instrLen;
 	}
 
+	if(dataStart != functionCode.size)
+		AddDataRecords(dataStart, functionCode.size, disasFunc);
+}
+
+size_t Disassembler::GetFillRunEnd(const ByteSpan& code, size_t offset)
+{
+	unsigned char fill = code.data[offset];
+
+	// zero fill and int3 padding; a long enough run of either isn't code
+	if(fill != 0x00 && fill != 0xCC)
+		return offset;
+
+	size_t runEnd = offset + 1;
+
+	while(runEnd < code.size && code.data[runEnd] == fill)
+		++runEnd;
+
+	return runEnd - offset >= MinFillRun ? runEnd : offset;
+}
+
+void Disassembler::AddDataRecords(size_t start, size_t end, DisassembledFunction& disasFunc)
+{
+	for(size_t offset = start; offset < end; offset += DataChunkSize) {
+		size_t length = end - offset < DataChunkSize ? end - offset : DataChunkSize;
+
+		disasFunc.offsets.push_back(static_cast<unsigned int>(offset));
+		disasFunc.lengths.push_back(static_cast<unsigned char>(length));
+		disasFunc.iclasses.push_back(static_cast<unsigned short>(XED_ICLASS_INVALID));
+		disasFunc.categories.push_back(static_cast<unsigned char>(XED_CATEGORY_INVALID));
+		disasFunc.flags.push_back(InstrData);
+		disasFunc.numOperands.push_back(0);
+	}
+}
+
+bool Disassembler::DecodeInstruction(const DisassembledFunction& disasFunc, size_t instrNum, xed_decoded_inst_t& xedd) const
+{
+	if(instrNum >= disasFunc.offsets.size() || !(disasFunc.flags[instrNum] & InstrValid))
+		return false;
+
+	xed_decoded_inst_zero(&xedd);
+	xed_decoded_inst_set_mode(&xedd, m_machineMode, m_stackAddrWidth);
+
+	return xed_decode(&xedd,
+		XED_STATIC_CAST(const xed_uint8_t*, disasFunc.code.data + disasFunc.offsets[instrNum]),
+		disasFunc.lengths[instrNum]) == XED_ERROR_NONE;
+}
+
+bool Disassembler::DisassembleAndOutputFunctions(OutputFormatter& out, unsigned int numJobs)
+{
+	if(numJobs == 0)
+		numJobs = GetHardwareThreadCount();
+
+	// only a window of functions is ever held decoded at once, so
+	// memory is bounded by the largest functions rather than the image;
+	// the same workers decode ahead while earlier functions are written
+	size_t windowSize = numJobs == 1 ? 1 : numJobs * 4;
+
+	vector<DisassembledFunction>	window(windowSize);
+	vector<DecodeDiagnostics>		diagnostics(windowSize);
+
+	m_decodeSummary.Clear();
+
+	ParallelOrdered(m_functions.size(), numJobs, windowSize, [this, &window, &diagnostics, windowSize](size_t funcNum) {
+		DisassembleFunction(m_functions[funcNum], window[funcNum % windowSize], diagnostics[funcNum % windowSize]);
+	}, [this, &window, &diagnostics, &out, windowSize](size_t funcNum) {
+		size_t slot = funcNum % windowSize;
+
+		m_decodeSummary.Add(m_functions[funcNum], diagnostics[slot]);
+		OutputFunctionDisassembly(m_functions[funcNum], window[slot], out);
+
+		// free the decoded function rather than keep it until the slot is reused
+		window[slot] = DisassembledFunction();
+	});
+
+	m_decodeSummary.Write(*m_diag);
+
 	return true;
 }
 
-const vector<Function>& Disassembler::GetFunctions() const
+bool Disassembler::DisassembleAndOutputIncremental(OutputFormatter& out, const IncrementalCache& previous, IncrementalCache& next, unsigned int numJobs, size_t& numReused)
 {
-	return m_functions;
+	size_t						numFunctions = m_functions.size();
+	vector<unsigned long long>	hashes(numFunctions);
+	vector<ByteSpan>			reused(numFunctions);
+	vector<size_t>				changed;
+
+	numReused = 0;
+
+	for(size_t i = 0; i < numFunctions; ++i) {
+		ByteSpan code;
+
+		if(!m_pe.getRVARange(m_functions[i].address, m_functions[i].length, code)) {
+			code.data = 0;
+			code.size = 0;
+		}
+
+		hashes[i] = IncrementalCache::HashFunction(m_functions[i], code, m_pe.getImageBase(), (m_bRecursive ? 1 : 0) | (m_bOutputCFG ? 2 : 0));
+
+		if(previous.Find(hashes[i], reused[i])) {
+			++numReused;
+		} else {
+			changed.push_back(i);
+		}
+	}
+
+	stable_sort(changed.begin(), changed.end(), [this](size_t a, size_t b) {
+		return m_functions[a].length > m_functions[b].length;
+	});
+
+	// only the changed functions are decoded, each one straight to
+	// its text so nothing decoded is held past its own function
+	vector<string>				outputs(numFunctions);
+	vector<DecodeDiagnostics>	diagnostics(numFunctions);
+
+	ParallelFor(changed, numJobs, [this, &outputs, &diagnostics](size_t funcNum) {
+		DisassembledFunction	disasFunc;
+		ostringstream			text;
+
+		DisassembleFunction(m_functions[funcNum], disasFunc, diagnostics[funcNum]);
+
+		{
+			OutputFormatter funcOut(text, 1 << 12);
+			OutputFunctionDisassembly(m_functions[funcNum], disasFunc, funcOut);
+		}
+
+		outputs[funcNum] = text.str();
+	});
+
+	m_decodeSummary.Clear();
+
+	for(size_t i = 0; i < numFunctions; ++i) {
+		const char*	text;
+		size_t		length;
+
+		if(reused[i].data) {
+			text = reinterpret_cast<const char*>(reused[i].data);
+			length = reused[i].size;
+		} else {
+			m_decodeSummary.Add(m_functions[i], diagnostics[i]);
+
+			text = outputs[i].data();
+			length = outputs[i].length();
+		}
+
+		out.Append(text, length);
+		next.Add(hashes[i], text, length);
+	}
+
+	m_decodeSummary.Write(*m_diag);
+
+	return true;
 }
 
-const vector<DisassembledFunction>& Disassembler::GetDisassembledFunctions() const
+bool Disassembler::OutputFunctionDisassembly(vector<Function>::const_iterator funcIter, OutputFormatter& out) const
 {
-	return m_disassembledFunctions;
+	size_t funcNum = funcIter - m_functions.begin();
+
+	if(funcNum >= m_disassembledFunctions.size())
+		return false;
+
+	return OutputFunctionDisassembly(*funcIter, m_disassembledFunctions[funcNum], out);
 }
 
-void Disassembler::PrintOperands(const DisassembledInstruction& instr, const Function& func, std::wostream& out) const
+bool Disassembler::OutputFunctionDisassembly(const Function& func, const DisassembledFunction& disasFunc, OutputFormatter& out) const
 {
-	const xed_inst_t* xi = xed_decoded_inst_inst(&instr.instr);
-    const xed_operand_values_t* operandValues = xed_decoded_inst_operands_const(&instr.instr);
-    size_t numOperands = xed_inst_noperands(xi);
+	unsigned long long funcAddr = m_pe.getImageBase() + func.address;
 
-	for(size_t opNum = 0; opNum < numOperands; ++opNum) {
+	out.AppendLine();
+	out.Append(func.compiland);
+	out.AppendLine();
+	out.Append(func.name);
+	out.AppendLine();
+	out.Append("0x", 2);
+	out.AppendHex(funcAddr, 16, true);
+	out.Append(" - 0x", 5);
+	out.AppendHex(funcAddr + func.length - 1, 16, true);
+	out.AppendLine();
+	out.AppendLine();
+
+	char instrDumpStr[256];
+
+	xed_decoded_inst_t xedd;
+
+	PhaseTimer annotateTimer(PhaseAnnotate);
+
+	// built once per function so each operand is a single lookup
+	VariableIndex variables(func, m_registers);
+
+	// which registers point into the frame at the start of each block
+	ControlFlowGraph	cfg;
+	vector<FrameEffect>	effects;
+	vector<FrameState>	entryStates;
+	FrameState			frameState;
+
+	AnalyzeFrames(disasFunc, cfg, effects, entryStates);
+	FrameDataflow::ClearState(frameState);
+
+	annotateTimer.Stop();
+	PhaseTimer outputTimer(PhaseOutput);
+
+	for(size_t instrNum = 0, instrNum_end = disasFunc.offsets.size(); instrNum < instrNum_end; ++instrNum) {
+		unsigned long long	instrAddr = funcAddr + disasFunc.offsets[instrNum];
+		unsigned int		block = cfg.GetBlockOf(static_cast<unsigned int>(instrNum));
+
+		if(cfg.GetBlockStart(block) == instrNum)
+			frameState = entryStates[block];
+
+		out.Append("0x", 2);
+		out.AppendHex(instrAddr, 16, true);
+		out.Append(' ');
+
+		bool bValid = DecodeInstruction(disasFunc, instrNum, xedd);
+
+		if(disasFunc.flags[instrNum] & InstrData)
+			strcpy_s(instrDumpStr, sizeof(instrDumpStr), "(data)");
+		else if(!bValid || !xed_decoded_inst_dump_intel_format(&xedd, instrDumpStr, sizeof(instrDumpStr) - 1, instrAddr))
+			strcpy_s(instrDumpStr, sizeof(instrDumpStr), "(bad)");
+
+		unsigned long long fieldStart = out.GetPosition();
+		out.Append(instrDumpStr);
+		out.PadFrom(fieldStart, 40);
+
+		fieldStart = out.GetPosition();
+		const unsigned char* instrBytes = disasFunc.code.data + disasFunc.offsets[instrNum];
+
+		for(size_t byteNum = 0, byteNum_end = disasFunc.lengths[instrNum]; byteNum < byteNum_end; ++byteNum) {
+			out.Append(' ');
+			out.AppendHex(instrBytes[byteNum], 2, false);
+		}
+
+		out.PadFrom(fieldStart, 45);
+
+		// if we hit a 'ret' instruction, don't read further; recursive
+		// descent only lists what's reachable, so there it keeps going
+		if(!m_bRecursive && disasFunc.categories[instrNum] == XED_CATEGORY_RET) {
+			out.AppendLine();
+			break;
+		}
+
+		if(bValid)
+			PrintOperands(xedd, variables, &frameState, out);
+
+		m_frameDataflow.Apply(effects[instrNum], frameState);
+
+		out.AppendLine();
+	}
+
+	if(m_bOutputCFG)
+		OutputControlFlowGraph(func, disasFunc, cfg, out);
+
+	return true;
+}
+
+bool Disassembler::OutputFunctionColumnar(const Function& func, const DisassembledFunction& disasFunc, ColumnarWriter& out) const
+{
+	PhaseTimer			annotateTimer(PhaseAnnotate);
+	VariableIndex		variables(func, m_registers);
+	ControlFlowGraph	cfg;
+	vector<FrameEffect>	effects;
+	vector<FrameState>	entryStates;
+	FrameState			frameState;
+
+	AnalyzeFrames(disasFunc, cfg, effects, entryStates);
+	FrameDataflow::ClearState(frameState);
+
+	annotateTimer.Stop();
+	PhaseTimer outputTimer(PhaseOutput);
+
+	unsigned long firstVariable = out.BeginFunction(func);
+
+	xed_decoded_inst_t		xedd;
+	vector<ColumnarOperand>	operands;
+
+	for(size_t instrNum = 0, instrNum_end = disasFunc.offsets.size(); instrNum < instrNum_end; ++instrNum) {
+		unsigned int block = cfg.GetBlockOf(static_cast<unsigned int>(instrNum));
+
+		if(cfg.GetBlockStart(block) == instrNum)
+			frameState = entryStates[block];
+
+		ColumnarInstruction instr;
+		instr.rva = func.address + disasFunc.offsets[instrNum];
+		instr.length = disasFunc.lengths[instrNum];
+		instr.flags = disasFunc.flags[instrNum];
+		instr.iclass = disasFunc.iclasses[instrNum];
+		instr.variable = NoColumnarVariable;
+
+		operands.clear();
+
+		if(DecodeInstruction(disasFunc, instrNum, xedd)) {
+			GetColumnarOperands(xedd, instr.rva + instr.length, operands);
+
+			const Variable* var = FindAnnotatedVariable(xedd, variables, &frameState);
+
+			// parameters are numbered first, then locals
+			if(var && !func.parameters.empty() && var >= &func.parameters.front() && var <= &func.parameters.back())
+				instr.variable = firstVariable + static_cast<unsigned long>(var - &func.parameters.front());
+			else if(var && !func.localVariables.empty() && var >= &func.localVariables.front() && var <= &func.localVariables.back())
+				instr.variable = firstVariable + static_cast<unsigned long>(func.parameters.size() + (var - &func.localVariables.front()));
+		}
+
+		out.AddInstruction(instr, operands.empty() ? 0 : &operands[0], operands.size());
+
+		// the same instructions the text dump lists
+		if(!m_bRecursive && disasFunc.categories[instrNum] == XED_CATEGORY_RET)
+			break;
+
+		m_frameDataflow.Apply(effects[instrNum], frameState);
+	}
+
+	out.EndFunction();
+
+	return true;
+}
+
+void Disassembler::GetColumnarOperands(const xed_decoded_inst_t& xedd, unsigned long nextRVA, vector<ColumnarOperand>& operands) const
+{
+	const xed_inst_t*	xi = xed_decoded_inst_inst(&xedd);
+	unsigned int		memOp = 0;
+
+	for(unsigned int opNum = 0, opNum_end = xed_inst_noperands(xi); opNum < opNum_end; ++opNum) {
 		const xed_operand_t*	op = xed_inst_operand(xi, opNum);
-		xed_operand_type_enum_t opType = xed_operand_type(op);
 		xed_operand_enum_t		opName = xed_operand_name(op);
 
-		if(opType == XED_OPERAND_TYPE_REG || XED_OPERAND_TYPE_NT_LOOKUP_FN) {
-			xed_reg_enum_t reg = xed_decoded_inst_get_reg(&instr.instr, opName);
+		if(xed_operand_operand_visibility(op) != XED_OPVIS_EXPLICIT)
+			continue;
+
+		ColumnarOperand operand;
+		memset(&operand, 0, sizeof(operand));
+
+		if(xed_operand_is_register(opName)) {
+			operand.kind = OperandRegister;
+			operand.reg = static_cast<unsigned short>(xed_decoded_inst_get_reg(&xedd, opName));
+		} else if(opName == XED_OPERAND_MEM0 || opName == XED_OPERAND_MEM1 || opName == XED_OPERAND_AGEN) {
+			operand.kind = OperandMemory;
+			operand.reg = static_cast<unsigned short>(xed_decoded_inst_get_base_reg(&xedd, memOp));
+			operand.indexReg = static_cast<unsigned short>(xed_decoded_inst_get_index_reg(&xedd, memOp));
+			operand.scale = static_cast<unsigned char>(xed_decoded_inst_get_scale(&xedd, memOp));
+			operand.value = xed_decoded_inst_get_memory_displacement(&xedd, memOp);
+			++memOp;
+		} else if(opName == XED_OPERAND_IMM0) {
+			operand.kind = OperandImmediate;
+
+			if(xed_decoded_inst_get_immediate_is_signed(&xedd))
+				operand.value = xed_decoded_inst_get_signed_immediate(&xedd);
+			else
+				operand.value = static_cast<long long>(xed_decoded_inst_get_unsigned_immediate(&xedd));
+		} else if(opName == XED_OPERAND_RELBR) {
+			operand.kind = OperandBranch;
+			operand.value = static_cast<long long>(nextRVA) + xed_decoded_inst_get_branch_displacement(&xedd);
+		} else {
+			continue;
+		}
 
-			for(vector<Variable>::const_iterator var = func.localVariables.begin(), var_end = func.localVariables.end();
-				var != var_end; ++var) {
+		operands.push_back(operand);
+	}
+}
 
-					if(var->location == ValueInRegister && PDBRegToDisasReg(var->eRegister) == reg) {
-						out << " " << xed_reg_enum_t2str(reg) << " = " << var->name << " ";
-						break;
-					}
-			}
-		} /*else if(opType == XED_OPERAND_TYPE_IMM || opType == XED_OPERAND_TYPE_IMM_CONST) {
-			xed_uint32_t opValue = xed_operand_imm(op);
+const Variable* Disassembler::FindAnnotatedVariable(const xed_decoded_inst_t& xedd, const VariableIndex& variables, const FrameState* frameState) const
+{
+	// a variable in memory wins over one held in a register
+	for(size_t i = 0, memops = xed_decoded_inst_number_of_memory_operands(&xedd); i < memops; ++i) {
+		xed_reg_enum_t	baseReg = xed_decoded_inst_get_base_reg(&xedd, i);
+		long long		displacement = xed_decoded_inst_get_memory_displacement(&xedd, i);
 
-			for(vector<Variable>::const_iterator var = func.localVariables.begin(), var_end = func.localVariables.end();
-				var != var_end; ++var) {
+		if(baseReg == XED_REG_INVALID)
+			continue;
 
-					if(var->location == Constant && var->value == opValue) {
-						break;
-					}
-			}
-		}*/
+		if(frameState)
+			m_frameDataflow.Resolve(*frameState, baseReg, displacement, baseReg, displacement);
+
+		const Variable* var = variables.FindStackVariable(baseReg, displacement);
+
+		if(var)
+			return var;
 	}
 
-	size_t memops = xed_decoded_inst_number_of_memory_operands(&instr.instr);
+	const xed_inst_t* xi = xed_decoded_inst_inst(&xedd);
 
-	for(size_t i = 0; i < memops; ++i) {
-		// for now, not handling this case as it involves
-		// paying attention to data flow
-		if(	xed_decoded_inst_get_index_reg(&instr.instr,i) != XED_REG_INVALID ||
-			!xed_decoded_inst_get_memory_displacement_width(&instr.instr,i))
-				continue;
-
-		xed_reg_enum_t baseReg = xed_decoded_inst_get_base_reg(&instr.instr,i);
-		long long displacement = xed_decoded_inst_get_memory_displacement(&instr.instr,i);
-
-		bool foundVar = false;
-		
-		for(vector<Variable>::const_iterator var = func.localVariables.begin(), var_end = func.localVariables.end();
-			var != var_end; ++var) {
-
-				if(var->location == RegisterRelative && PDBRegToDisasReg(var->eRegister) == baseReg && var->offset == displacement) {
-					foundVar = true;
-					out << " " << xed_reg_enum_t2str(baseReg);
-
-					if(displacement >= 0) {
-						out << " + " << hex << nouppercase << "0x" << displacement << " = " << var->name << " ";
-					} else {
-						out << " - " << hex << nouppercase << "0x" << -displacement << " = " << var->name << " ";
-					}
-
-					break;
-				}
+	for(unsigned int opNum = 0, opNum_end = xed_inst_noperands(xi); opNum < opNum_end; ++opNum) {
+		const xed_operand_t*	op = xed_inst_operand(xi, opNum);
+		xed_operand_type_enum_t	opType = xed_operand_type(op);
+
+		if(opType != XED_OPERAND_TYPE_REG && opType != XED_OPERAND_TYPE_NT_LOOKUP_FN)
+			continue;
+
+		const Variable* var = variables.FindRegisterVariable(xed_decoded_inst_get_reg(&xedd, xed_operand_name(op)));
+
+		if(var)
+			return var;
+	}
+
+	return 0;
+}
+
+void Disassembler::AnalyzeFrames(const DisassembledFunction& disasFunc, ControlFlowGraph& cfg, vector<FrameEffect>& effects, vector<FrameState>& entryStates) const
+{
+	xed_decoded_inst_t xedd;
+
+	BuildControlFlowGraph(disasFunc, cfg);
+	effects.resize(disasFunc.offsets.size());
+
+	for(size_t instrNum = 0, instrNum_end = disasFunc.offsets.size(); instrNum < instrNum_end; ++instrNum) {
+		if(DecodeInstruction(disasFunc, instrNum, xedd)) {
+			m_frameDataflow.GetEffect(xedd, effects[instrNum]);
+		} else {
+			memset(&effects[instrNum], 0, sizeof(FrameEffect));
 		}
+	}
 
-		if(foundVar)
-			break;
+	m_frameDataflow.Solve(cfg, effects, entryStates);
+}
 
-		for(vector<Variable>::const_iterator var = func.parameters.begin(), var_end = func.parameters.end();
-			var != var_end; ++var) {
+void Disassembler::BuildControlFlowGraph(const DisassembledFunction& disasFunc, ControlFlowGraph& cfg) const
+{
+	vector<unsigned int>	branchTargets(disasFunc.offsets.size(), ControlFlowGraph::NoTarget);
+	xed_decoded_inst_t		xedd;
+
+	// only the relative branches need decoding again to find their targets
+	for(size_t instrNum = 0, instrNum_end = disasFunc.offsets.size(); instrNum < instrNum_end; ++instrNum) {
+		if(!(disasFunc.flags[instrNum] & InstrRelativeBranch) || !DecodeInstruction(disasFunc, instrNum, xedd))
+			continue;
+
+		long long target =	static_cast<long long>(disasFunc.offsets[instrNum]) + disasFunc.lengths[instrNum] +
+							xed_decoded_inst_get_branch_displacement(&xedd);
+
+		if(target >= 0 && static_cast<unsigned long long>(target) < disasFunc.code.size)
+			branchTargets[instrNum] = static_cast<unsigned int>(target);
+	}
+
+	cfg.Build(disasFunc, branchTargets);
+}
+
+void Disassembler::OutputControlFlowGraph(const Function& func, const DisassembledFunction& disasFunc, const ControlFlowGraph& cfg, OutputFormatter& out) const
+{
+	unsigned long long funcAddr = m_pe.getImageBase() + func.address;
+
+	out.AppendLine();
+	out.Append("Control flow graph:");
+	out.AppendLine();
+
+	for(size_t block = 0, block_end = cfg.GetNumBlocks(); block < block_end; ++block) {
+		unsigned int	first = cfg.GetBlockStart(block);
+		unsigned int	last = cfg.GetBlockEnd(block) - 1;
+
+		out.Append("  block ", 8);
+		out.AppendDecimal(block);
+		out.Append(": 0x", 4);
+		out.AppendHex(funcAddr + disasFunc.offsets[first], 16, true);
+		out.Append(" - 0x", 5);
+		out.AppendHex(funcAddr + disasFunc.offsets[last] + disasFunc.lengths[last] - 1, 16, true);
+
+		size_t				count;
+		const unsigned int*	edges = cfg.GetSuccessors(block, count);
+
+		out.Append("  succ:", 7);
+
+		for(size_t i = 0; i < count; ++i) {
+			out.Append(' ');
+			out.AppendDecimal(edges[i]);
+		}
 
-				if(var->location == RegisterRelative && PDBRegToDisasReg(var->eRegister) == baseReg && var->offset == displacement) {
-					out << " " << xed_reg_enum_t2str(baseReg);
+		edges = cfg.GetPredecessors(block, count);
 
-					if(displacement >= 0) {
-						out << " + " << hex << nouppercase << "0x" << displacement << " = " << var->name << " ";
-					} else {
-						out << " - " << hex << nouppercase << "0x" << -displacement << " = " << var->name << " ";
-					}
+		out.Append("  pred:", 7);
 
-					foundVar = true;
-					break;
-				}
+		for(size_t i = 0; i < count; ++i) {
+			out.Append(' ');
+			out.AppendDecimal(edges[i]);
 		}
 
-		if(foundVar)
+		out.AppendLine();
+	}
+}
+
+const vector<Function>& Disassembler::GetFunctions() const
+{
+	return m_functions;
+}
+
+const PE& Disassembler::GetPE() const
+{
+	return m_pe;
+}
+
+const PDB& Disassembler::GetPDB() const
+{
+	return m_pdb;
+}
+
+bool Disassembler::DescribeAddress(unsigned long long rva, const Function* func, AddressInfo& info) const
+{
+	info.bFoundFunction = info.bFoundInstruction = info.bFoundVariable = false;
+	info.functionRVA = info.instructionRVA = 0;
+	info.functionName.clear();
+	info.instruction.clear();
+	info.variableName.clear();
+
+	// func is what the caller already looked up for rva, if anything
+	if(!func)
+		func = m_pdb.FindFunction(rva);
+
+	if(!func)
+		return false;
+
+	info.bFoundFunction = true;
+	info.functionRVA = func->address;
+	info.functionName = func->name;
+
+	ByteSpan code;
+
+	if(!m_pe.getRVARange(func->address, func->length, code))
+		return true;
+
+	// walk from the start of the function to the instruction covering rva
+	size_t				target = static_cast<size_t>(rva - func->address);
+	xed_decoded_inst_t	xedd;
+
+	for(size_t offset = 0; offset < code.size;) {
+		size_t bytesLeft = code.size - offset;
+
+		xed_decoded_inst_zero(&xedd);
+		xed_decoded_inst_set_mode(&xedd, m_machineMode, m_stackAddrWidth);
+
+		size_t instrLen = 1;
+		bool bValid = xed_decode(&xedd,
+			XED_STATIC_CAST(const xed_uint8_t*, code.data + offset),
+			static_cast<unsigned int>(bytesLeft < 15 ? bytesLeft : 15)) == XED_ERROR_NONE;
+
+		if(bValid)
+			instrLen = xed_decoded_inst_get_length(&xedd);
+
+		if(target < offset + instrLen) {
+			if(!bValid)
+				return true;
+
+			char instrDumpStr[256];
+			unsigned long long instrAddr = m_pe.getImageBase() + func->address + offset;
+
+			if(xed_decoded_inst_dump_intel_format(&xedd, instrDumpStr, sizeof(instrDumpStr) - 1, instrAddr))
+				info.instruction = instrDumpStr;
+
+			info.bFoundInstruction = true;
+			info.instructionRVA = static_cast<unsigned long>(func->address + offset);
 			break;
+		}
+
+		offset += instrLen;
+	}
+
+	if(!info.bFoundInstruction)
+		return true;
+
+	VariableIndex	variables(*func, m_registers);
+	const Variable*	var = FindAnnotatedVariable(xedd, variables, 0);
+
+	if(var) {
+		info.bFoundVariable = true;
+		info.variableName = var->name;
 	}
 
+	return true;
+}
 
-	;
+const vector<DisassembledFunction>& Disassembler::GetDisassembledFunctions() const
+{
+	return m_disassembledFunctions;
 }
 
-xed_reg_enum_t	PDBRegToDisasReg(CV_HREG_e reg)
+void Disassembler::PrintOperands(const xed_decoded_inst_t& xedd, const VariableIndex& variables, const FrameState* frameState, OutputFormatter& out) const
 {
-	if(reg == CV_AMD64_BPL) {
-		return XED_REG_BPL;
-	} if(reg == CV_AMD64_CR8) {
-		return XED_REG_CR8;
-	} if(reg == CV_AMD64_DIL) {
-		return XED_REG_DIL;
-	} if(reg == CV_AMD64_DR10) {
-		return XED_REG_DR10;
-	} if(reg == CV_AMD64_DR11) {
-		return XED_REG_DR11;
-	} if(reg == CV_AMD64_DR12) {
-		return XED_REG_DR12;
-	} if(reg == CV_AMD64_DR13) {
-		return XED_REG_DR13;
-	} if(reg == CV_AMD64_DR14) {
-		return XED_REG_DR14;
-	} if(reg == CV_AMD64_DR15) {
-		return XED_REG_DR15;
-	} if(reg == CV_AMD64_DR8) {
-		return XED_REG_DR8;
-	} if(reg == CV_AMD64_DR9) {
-		return XED_REG_DR9;
-	} if(reg == CV_AMD64_EFLAGS) {
-		return XED_REG_EFLAGS;
-	} if(reg == CV_AMD64_FLAGS) {
-		return XED_REG_RFLAGS;
-	} if(reg == CV_AMD64_R10) {
-		return XED_REG_R10;
-	} if(reg == CV_AMD64_R10B) {
-		return XED_REG_R10B;
-	} if(reg == CV_AMD64_R10D) {
-		return XED_REG_R10D;
-	} if(reg == CV_AMD64_R10W) {
-		return XED_REG_R10W;
-	} if(reg == CV_AMD64_R11) {
-		return XED_REG_R11;
-	} if(reg == CV_AMD64_R11B) {
-		return XED_REG_R11B;
-	} if(reg == CV_AMD64_R11D) {
-		return XED_REG_R11D;
-	} if(reg == CV_AMD64_R11W) {
-		return XED_REG_R11W;
-	} if(reg == CV_AMD64_R12) {
-		return XED_REG_R12;
-	} if(reg == CV_AMD64_R12B) {
-		return XED_REG_R12B;
-	} if(reg == CV_AMD64_R12D) {
-		return XED_REG_R12D;
-	} if(reg == CV_AMD64_R12W) {
-		return XED_REG_R12W;
-	} if(reg == CV_AMD64_R13) {
-		return XED_REG_R13;
-	} if(reg == CV_AMD64_R13B) {
-		return XED_REG_R13B;
-	} if(reg == CV_AMD64_R13D) {
-		return XED_REG_R13D;
-	} if(reg == CV_AMD64_R13W) {
-		return XED_REG_R13W;
-	} if(reg == CV_AMD64_R14) {
-		return XED_REG_R14;
-	} if(reg == CV_AMD64_R14B) {
-		return XED_REG_R14B;
-	} if(reg == CV_AMD64_R14D) {
-		return XED_REG_R14D;
-	} if(reg == CV_AMD64_R14W) {
-		return XED_REG_R14W;
-	} if(reg == CV_AMD64_R15) {
-		return XED_REG_R15;
-	} if(reg == CV_AMD64_R15B) {
-		return XED_REG_R15B;
-	} if(reg == CV_AMD64_R15D) {
-		return XED_REG_R15D;
-	} if(reg == CV_AMD64_R15W) {
-		return XED_REG_R15W;
-	} if(reg == CV_AMD64_R8) {
-		return XED_REG_R8;
-	} if(reg == CV_AMD64_R8B) {
-		return XED_REG_R8B;
-	} if(reg == CV_AMD64_R8D) {
-		return XED_REG_R8D;
-	} if(reg == CV_AMD64_R8W) {
-		return XED_REG_R8W;
-	} if(reg == CV_AMD64_R9) {
-		return XED_REG_R9;
-	} if(reg == CV_AMD64_R9B) {
-		return XED_REG_R9B;
-	} if(reg == CV_AMD64_R9D) {
-		return XED_REG_R9D;
-	} if(reg == CV_AMD64_R9W) {
-		return XED_REG_R9W;
-	} if(reg == CV_AMD64_RAX) {
-		return XED_REG_RAX;
-	} if(reg == CV_AMD64_RBP) {
-		return XED_REG_RBP;
-	} if(reg == CV_AMD64_RBX) {
-		return XED_REG_RBX;
-	} if(reg == CV_AMD64_RCX) {
-		return XED_REG_RCX;
-	} if(reg == CV_AMD64_RDI) {
-		return XED_REG_RDI;
-	} if(reg == CV_AMD64_RDX) {
-		return XED_REG_RDX;
-	} if(reg == CV_AMD64_RIP) {
-		return XED_REG_RIP;
-	} if(reg == CV_AMD64_RSI) {
-		return XED_REG_RSI;
-	} if(reg == CV_AMD64_RSP) {
-		return XED_REG_RSP;
-	} if(reg == CV_AMD64_SIL) {
-		return XED_REG_SIL;
-	} if(reg == CV_AMD64_SPL) {
-		return XED_REG_SPL;
-	} if(reg == CV_AMD64_XMM14) {
-		return XED_REG_XMM14;
-	} if(reg == CV_AMD64_XMM15) {
-		return XED_REG_XMM15;
-	} if(reg == CV_AMD64_XMM8) {
-		return XED_REG_XMM8;
-	} if(reg == CV_AMD64_XMM9) {
-		return XED_REG_XMM9;
-	} if(reg == CV_AMD64_YMM10) {
-		return XED_REG_YMM10;
-	} if(reg == CV_AMD64_YMM11) {
-		return XED_REG_YMM11;
-	} if(reg == CV_AMD64_YMM12) {
-		return XED_REG_YMM12;
-	} if(reg == CV_AMD64_YMM13) {
-		return XED_REG_YMM13;
-	} if(reg == CV_AMD64_YMM14) {
-		return XED_REG_YMM14;
-	} if(reg == CV_AMD64_YMM15) {
-		return XED_REG_YMM15;
-	} if(reg == CV_AMD64_YMM8) {
-		return XED_REG_YMM8;
-	} if(reg == CV_AMD64_YMM9) {
-		return XED_REG_YMM9;
-	} if(reg == CV_REG_AH) {
-		return XED_REG_AH;
-	} if(reg == CV_REG_AL) {
-		return XED_REG_AL;
-	} if(reg == CV_REG_AX) {
-		return XED_REG_AX;
-	} if(reg == CV_REG_BH) {
-		return XED_REG_BH;
-	} if(reg == CV_REG_BL) {
-		return XED_REG_BL;
-	} if(reg == CV_REG_BP) {
-		return XED_REG_BP;
-	} if(reg == CV_REG_BX) {
-		return XED_REG_BX;
-	} if(reg == CV_REG_CH) {
-		return XED_REG_CH;
-	} if(reg == CV_REG_CL) {
-		return XED_REG_CL;
-	} if(reg == CV_REG_CR0) {
-		return XED_REG_CR0;
-	} if(reg == CV_REG_CR1) {
-		return XED_REG_CR1;
-	} if(reg == CV_REG_CR2) {
-		return XED_REG_CR2;
-	} if(reg == CV_REG_CR3) {
-		return XED_REG_CR3;
-	} if(reg == CV_REG_CR4) {
-		return XED_REG_CR4;
-	} if(reg == CV_REG_CS) {
-		return XED_REG_CS;
-	} if(reg == CV_REG_CX) {
-		return XED_REG_CX;
-	} if(reg == CV_REG_DH) {
-		return XED_REG_DH;
-	} if(reg == CV_REG_DI) {
-		return XED_REG_DI;
-	} if(reg == CV_REG_DL) {
-		return XED_REG_DL;
-	} if(reg == CV_REG_DR0) {
-		return XED_REG_DR0;
-	} if(reg == CV_REG_DR1) {
-		return XED_REG_DR1;
-	} if(reg == CV_REG_DR2) {
-		return XED_REG_DR2;
-	} if(reg == CV_REG_DR3) {
-		return XED_REG_DR3;
-	} if(reg == CV_REG_DR4) {
-		return XED_REG_DR4;
-	} if(reg == CV_REG_DR5) {
-		return XED_REG_DR5;
-	} if(reg == CV_REG_DR6) {
-		return XED_REG_DR6;
-	} if(reg == CV_REG_DR7) {
-		return XED_REG_DR7;
-	} if(reg == CV_REG_DS) {
-		return XED_REG_DS;
-	} if(reg == CV_REG_DX) {
-		return XED_REG_DX;
-	} if(reg == CV_REG_EAX) {
-		return XED_REG_EAX;
-	} if(reg == CV_REG_EBP) {
-		return XED_REG_EBP;
-	} if(reg == CV_REG_EBX) {
-		return XED_REG_EBX;
-	} if(reg == CV_REG_ECX) {
-		return XED_REG_ECX;
-	} if(reg == CV_REG_EDI) {
-		return XED_REG_EDI;
-	} if(reg == CV_REG_EDX) {
-		return XED_REG_EDX;
-	} if(reg == CV_REG_EFLAGS) {
-		return XED_REG_EFLAGS;
-	} if(reg == CV_REG_EIP) {
-		return XED_REG_EIP;
-	} if(reg == CV_REG_ES) {
-		return XED_REG_ES;
-	} if(reg == CV_REG_ESI) {
-		return XED_REG_ESI;
-	} if(reg == CV_REG_ESP) {
-		return XED_REG_ESP;
-	} if(reg == CV_REG_FLAGS) {
-		return XED_REG_FLAGS;
-	} if(reg == CV_REG_FS) {
-		return XED_REG_FS;
-	} if(reg == CV_REG_GDTR) {
-		return XED_REG_GDTR;
-	} if(reg == CV_REG_GS) {
-		return XED_REG_GS;
-	} if(reg == CV_REG_IDTR) {
-		return XED_REG_IDTR;
-	} if(reg == CV_REG_IP) {
-		return XED_REG_IP;
-	} if(reg == CV_REG_LDTR) {
-		return XED_REG_LDTR;
-	} if(reg == CV_REG_MXCSR) {
-		return XED_REG_MXCSR;
-	} if(reg == CV_REG_SI) {
-		return XED_REG_SI;
-	} if(reg == CV_REG_SP) {
-		return XED_REG_SP;
-	} if(reg == CV_REG_SS) {
-		return XED_REG_SS;
-	} if(reg == CV_REG_ST0) {
-		return XED_REG_ST0;
-	} if(reg == CV_REG_ST1) {
-		return XED_REG_ST1;
-	} if(reg == CV_REG_ST2) {
-		return XED_REG_ST2;
-	} if(reg == CV_REG_ST3) {
-		return XED_REG_ST3;
-	} if(reg == CV_REG_ST4) {
-		return XED_REG_ST4;
-	} if(reg == CV_REG_ST5) {
-		return XED_REG_ST5;
-	} if(reg == CV_REG_ST6) {
-		return XED_REG_ST6;
-	} if(reg == CV_REG_ST7) {
-		return XED_REG_ST7;
-	} if(reg == CV_REG_TR) {
-		return XED_REG_TR;
-	} if(reg == CV_REG_XMM0) {
-		return XED_REG_XMM0;
-	} if(reg == CV_REG_XMM1) {
-		return XED_REG_XMM1;
-	} if(reg == CV_REG_XMM10) {
-		return XED_REG_XMM10;
-	} if(reg == CV_REG_XMM11) {
-		return XED_REG_XMM11;
-	} if(reg == CV_REG_XMM12) {
-		return XED_REG_XMM12;
-	} if(reg == CV_REG_XMM13) {
-		return XED_REG_XMM13;
-	} if(reg == CV_REG_XMM2) {
-		return XED_REG_XMM2;
-	} if(reg == CV_REG_XMM3) {
-		return XED_REG_XMM3;
-	} if(reg == CV_REG_XMM4) {
-		return XED_REG_XMM4;
-	} if(reg == CV_REG_XMM5) {
-		return XED_REG_XMM5;
-	} if(reg == CV_REG_XMM6) {
-		return XED_REG_XMM6;
-	} if(reg == CV_REG_XMM7) {
-		return XED_REG_XMM7;
-	} if(reg == CV_REG_YMM0) {
-		return XED_REG_YMM0;
-	} if(reg == CV_REG_YMM1) {
-		return XED_REG_YMM1;
-	} if(reg == CV_REG_YMM2) {
-		return XED_REG_YMM2;
-	} if(reg == CV_REG_YMM3) {
-		return XED_REG_YMM3;
-	} if(reg == CV_REG_YMM4) {
-		return XED_REG_YMM4;
-	} if(reg == CV_REG_YMM5) {
-		return XED_REG_YMM5;
-	} if(reg == CV_REG_YMM6) {
-		return XED_REG_YMM6;
-	} if(reg == CV_REG_YMM7) {
-		return XED_REG_YMM7;
-	} 
-	
-	return XED_REG_INVALID;
-
-	/* UNMAPPED CV_HREG_e's
-	*
-	*		XED_REG_CR5
-	*		XED_REG_CR6
-	*		XED_REG_CR7
-	*		XED_REG_CR9
-	*		XED_REG_CR10
-	*		XED_REG_CR11
-	*		XED_REG_CR12
-	*		XED_REG_CR13
-	*		XED_REG_CR14
-	*		XED_REG_CR15
-	*		XED_REG_ERROR
-	*		XED_REG_MMX0
-	*		XED_REG_MMX1
-	*		XED_REG_MMX2
-	*		XED_REG_MMX3
-	*		XED_REG_MMX4
-	*		XED_REG_MMX5
-	*		XED_REG_MMX6
-	*		XED_REG_MMX7
-	*		XED_REG_STACKPUSH
-	*		XED_REG_STACKPOP
-	*		XED_REG_TSC
-	*		XED_REG_TSCAUX
-	*		XED_REG_MSRS
-	*		XED_REG_FSBASE
-	*		XED_REG_GSBASE
-	*		XED_REG_X87CONTROL
-	*		XED_REG_X87STATUS
-	*		XED_REG_X87TAG
-	*		XED_REG_X87PUSH
-	*		XED_REG_X87POP
-	*		XED_REG_X87POP2
-	*		XED_REG_X87OPCODE
-	*		XED_REG_X87LASTCS
-	*		XED_REG_X87LASTIP
-	*		XED_REG_X87LASTDS
-	*		XED_REG_X87LASTDP
-	*		XED_REG_TMP0
-	*		XED_REG_TMP1
-	*		XED_REG_TMP2
-	*		XED_REG_TMP3
-	*		XED_REG_TMP4
-	*		XED_REG_TMP5
-	*		XED_REG_TMP6
-	*		XED_REG_TMP7
-	*		XED_REG_TMP8
-	*		XED_REG_TMP9
-	*		XED_REG_TMP10
-	*		XED_REG_TMP11
-	*		XED_REG_TMP12
-	*		XED_REG_TMP13
-	*		XED_REG_TMP14
-	*		XED_REG_TMP15
-	*		XED_REG_XCR0
-	*		
-	*
-	*/
+	const xed_inst_t* xi = xed_decoded_inst_inst(&xedd);
+    size_t numOperands = xed_inst_noperands(xi);
+
+	for(size_t opNum = 0; opNum < numOperands; ++opNum) {
+		const xed_operand_t*	op = xed_inst_operand(xi, opNum);
+		xed_operand_type_enum_t opType = xed_operand_type(op);
+		xed_operand_enum_t		opName = xed_operand_name(op);
+
+		if(opType == XED_OPERAND_TYPE_REG || opType == XED_OPERAND_TYPE_NT_LOOKUP_FN) {
+			xed_reg_enum_t	reg = xed_decoded_inst_get_reg(&xedd, opName);
+			const Variable*	var = variables.FindRegisterVariable(reg);
+
+			if(var) {
+				out.Append(' ');
+				out.Append(xed_reg_enum_t2str(reg));
+				out.Append(" = ", 3);
+				out.Append(var->name);
+				out.Append(' ');
+			}
+		}
+	}
+
+	size_t memops = xed_decoded_inst_number_of_memory_operands(&xedd);
+
+	for(size_t i = 0; i < memops; ++i) {
+		xed_reg_enum_t	baseReg = xed_decoded_inst_get_base_reg(&xedd,i);
+		long long		displacement = xed_decoded_inst_get_memory_displacement(&xedd,i);
+
+		if(baseReg == XED_REG_INVALID)
+			continue;
+
+		// a base register the dataflow pass knows points into the frame
+		// is rewritten as frame register + offset; with an index register
+		// the base + displacement part still names the variable indexed into
+		if(frameState)
+			m_frameDataflow.Resolve(*frameState, baseReg, displacement, baseReg, displacement);
+
+		const Variable*	var = variables.FindStackVariable(baseReg, displacement);
+
+		if(var) {
+			PrintStackVariable(baseReg, displacement, *var, out);
+			break;
+		}
+	}
+}
+
+void Disassembler::PrintStackVariable(xed_reg_enum_t baseReg, long long displacement, const Variable& var, OutputFormatter& out) const
+{
+	out.Append(' ');
+	out.Append(xed_reg_enum_t2str(baseReg));
+
+	if(displacement >= 0) {
+		out.Append(" + 0x", 5);
+		out.AppendHex(static_cast<unsigned long long>(displacement), 1, false);
+	} else {
+		out.Append(" - 0x", 5);
+		out.AppendHex(static_cast<unsigned long long>(-displacement), 1, false);
+	}
+
+	out.Append(" = ", 3);
+	out.Append(var.name);
+	out.Append(' ');
 }
\ No newline at end of file
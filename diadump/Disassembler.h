@@ -10,36 +10,80 @@ extern "C"
 #include <string>
 #include <vector>
 
+#include "ColumnarFile.h"
+#include "ControlFlowGraph.h"
+#include "DecodeDiagnostics.h"
+#include "DisassembledFunction.h"
+#include "FrameDataflow.h"
+#include "FunctionFilter.h"
+#include "IncrementalCache.h"
+#include "OutputFormatter.h"
 #include "PE.h"
 #include "PDB.h"
+#include "RecursiveDescent.h"
+#include "RegisterMap.h"
+#include "VariableIndex.h"
 
+// what's at one address: its function, instruction and the variable it touches
 typedef struct
 {
-	size_t				offsetFromFunctionStart;
-	std::string			bytes;
-	xed_decoded_inst_t	instr;
-	bool				validInstruction;
-} DisassembledInstruction;
-
-typedef struct
-{
-	std::vector<DisassembledInstruction>	instructions;
-} DisassembledFunction;
+	bool					bFoundFunction;
+	bool					bFoundInstruction;
+	bool					bFoundVariable;
+	unsigned long			functionRVA;
+	unsigned long			instructionRVA;
+	std::wstring			functionName;
+	std::string				instruction;
+	std::wstring			variableName;
+} AddressInfo;
 
 class Disassembler
 {
 public:
-	Disassembler(const wchar_t* exeFilename);
+	Disassembler(const wchar_t* exeFilename, const std::wstring& symbolCacheDir = std::wstring());
 
-	bool										DisassembleFunctions();
-	bool										OutputFunctionDisassembly(std::vector<Function>::const_iterator funcIter, std::wostream& out) const;
+	void										SetRecursiveDescent(bool bRecursive);
+	void										SetOutputControlFlowGraph(bool bOutputCFG);
+	void										SetDiagnosticStream(std::wostream& diag);
+	void										SelectFunctions(const FunctionFilter& filter);
+	void										AddFunctions(const std::vector<Function>& functions, const FunctionFilter& filter);
+	bool										DisassembleFunctions(unsigned int numJobs = 1);
+	bool										DisassembleAndOutputFunctions(OutputFormatter& out, unsigned int numJobs = 1);
+	bool										DisassembleAndOutputIncremental(OutputFormatter& out, const IncrementalCache& previous, IncrementalCache& next, unsigned int numJobs, size_t& numReused);
+	bool										OutputFunctionDisassembly(std::vector<Function>::const_iterator funcIter, OutputFormatter& out) const;
+	bool										OutputFunctionDisassembly(const Function& func, const DisassembledFunction& disasFunc, OutputFormatter& out) const;
+	bool										OutputFunctionColumnar(const Function& func, const DisassembledFunction& disasFunc, ColumnarWriter& out) const;
 	const std::vector<Function>&				GetFunctions() const;
+	const PE&									GetPE() const;
+	const PDB&									GetPDB() const;
+	bool										DescribeAddress(unsigned long long rva, const Function* func, AddressInfo& info) const;
 	const std::vector<DisassembledFunction>&	GetDisassembledFunctions() const;
-	void										PrintOperands(const DisassembledInstruction& instr, const Function& func, std::wostream& out) const;
+	bool										DecodeInstruction(const DisassembledFunction& disasFunc, size_t instrNum, xed_decoded_inst_t& xedd) const;
+	void										BuildControlFlowGraph(const DisassembledFunction& disasFunc, ControlFlowGraph& cfg) const;
+	void										OutputControlFlowGraph(const Function& func, const DisassembledFunction& disasFunc, const ControlFlowGraph& cfg, OutputFormatter& out) const;
+	void										PrintOperands(const xed_decoded_inst_t& xedd, const VariableIndex& variables, const FrameState* frameState, OutputFormatter& out) const;
 
 private:
+	void									DisassembleFunction(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const;
+	void									DisassembleLinear(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const;
+	static size_t							GetFillRunEnd(const ByteSpan& code, size_t offset);
+	static void								AddDataRecords(size_t start, size_t end, DisassembledFunction& disasFunc);
+	void									AnalyzeFrames(const DisassembledFunction& disasFunc, ControlFlowGraph& cfg, std::vector<FrameEffect>& effects, std::vector<FrameState>& entryStates) const;
+	void									GetColumnarOperands(const xed_decoded_inst_t& xedd, unsigned long nextRVA, std::vector<ColumnarOperand>& operands) const;
+	const Variable*							FindAnnotatedVariable(const xed_decoded_inst_t& xedd, const VariableIndex& variables, const FrameState* frameState) const;
+	void									PrintStackVariable(xed_reg_enum_t baseReg, long long displacement, const Variable& var, OutputFormatter& out) const;
+
 	PE										m_pe;
 	PDB										m_pdb;
+	RegisterMap								m_registers;
+	FrameDataflow							m_frameDataflow;
+	RecursiveDescent						m_recursiveDescent;
+	bool									m_bRecursive;
+	bool									m_bOutputCFG;
+
+	// where the decode summary for each run goes, wcout unless told otherwise
+	std::wostream*							m_diag;
+	DecodeSummary							m_decodeSummary;
 
 	xed_machine_mode_enum_t					m_machineMode;
     xed_address_width_enum_t				m_stackAddrWidth;
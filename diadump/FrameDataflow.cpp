@@ -0,0 +1,262 @@
+#include <string.h>
+#include "FrameDataflow.h"
+
+using namespace std;
+
+FrameDataflow::FrameDataflow(const RegisterMap& registers, bool bIs64Bit)
+	: m_registers(registers), m_slotOfRegister(XED_REG_LAST, -1), m_frameMask(0), m_callKillMask(0)
+{
+	if(bIs64Bit) {
+		xed_reg_enum_t gprs[] = {
+			XED_REG_RAX, XED_REG_RCX, XED_REG_RDX, XED_REG_RBX, XED_REG_RSP, XED_REG_RBP, XED_REG_RSI, XED_REG_RDI,
+			XED_REG_R8, XED_REG_R9, XED_REG_R10, XED_REG_R11, XED_REG_R12, XED_REG_R13, XED_REG_R14, XED_REG_R15
+		};
+
+		m_slotRegisters.assign(gprs, gprs + sizeof(gprs) / sizeof(gprs[0]));
+
+		// volatile across calls in the x64 calling convention
+		m_callKillMask = (1 << 0) | (1 << 1) | (1 << 2) | (1 << 8) | (1 << 9) | (1 << 10) | (1 << 11);
+	} else {
+		xed_reg_enum_t gprs[] = {
+			XED_REG_EAX, XED_REG_ECX, XED_REG_EDX, XED_REG_EBX, XED_REG_ESP, XED_REG_EBP, XED_REG_ESI, XED_REG_EDI
+		};
+
+		m_slotRegisters.assign(gprs, gprs + sizeof(gprs) / sizeof(gprs[0]));
+		m_callKillMask = (1 << 0) | (1 << 1) | (1 << 2);
+	}
+
+	for(size_t slot = 0, slot_end = m_slotRegisters.size(); slot < slot_end; ++slot)
+		m_slotOfRegister[m_slotRegisters[slot]] = static_cast<signed char>(slot);
+
+	// [e|r]sp and [e|r]bp
+	m_frameMask = (1 << 4) | (1 << 5);
+}
+
+void FrameDataflow::ClearState(FrameState& state)
+{
+	memset(&state, 0, sizeof(state));
+}
+
+int FrameDataflow::GetSlot(xed_reg_enum_t reg) const
+{
+	if(reg <= XED_REG_INVALID || reg >= XED_REG_LAST)
+		return -1;
+
+	return m_slotOfRegister[reg];
+}
+
+void FrameDataflow::GetEffect(const xed_decoded_inst_t& xedd, FrameEffect& effect) const
+{
+	effect.kind = EffectNone;
+	effect.dest = 0;
+	effect.source = 0;
+	effect.imm = 0;
+	effect.killMask = 0;
+
+	const xed_inst_t*	xi = xed_decoded_inst_inst(&xedd);
+	xed_iclass_enum_t	iclass = xed_decoded_inst_get_iclass(&xedd);
+
+	// every register written is clobbered unless the cases below say otherwise
+	for(unsigned int opNum = 0, opNum_end = xed_inst_noperands(xi); opNum < opNum_end; ++opNum) {
+		const xed_operand_t*	op = xed_inst_operand(xi, opNum);
+		xed_operand_type_enum_t	opType = xed_operand_type(op);
+
+		if(!xed_operand_written(op) || (opType != XED_OPERAND_TYPE_REG && opType != XED_OPERAND_TYPE_NT_LOOKUP_FN))
+			continue;
+
+		int slot = GetSlot(m_registers.GetFullRegister(xed_decoded_inst_get_reg(&xedd, xed_operand_name(op))));
+
+		if(slot >= 0)
+			effect.killMask |= 1 << slot;
+	}
+
+	if(xed_decoded_inst_get_category(&xedd) == XED_CATEGORY_CALL)
+		effect.killMask |= m_callKillMask;
+
+	// only full width destinations can hold an address
+	xed_reg_enum_t	destReg = xed_decoded_inst_get_reg(&xedd, XED_OPERAND_REG0);
+	int				destSlot = destReg == m_registers.GetFullRegister(destReg) ? GetSlot(destReg) : -1;
+
+	if(destSlot < 0)
+		return;
+
+	if(iclass == XED_ICLASS_LEA && xed_decoded_inst_get_index_reg(&xedd, 0) == XED_REG_INVALID) {
+		int sourceSlot = GetSlot(m_registers.GetFullRegister(xed_decoded_inst_get_base_reg(&xedd, 0)));
+
+		if(sourceSlot >= 0) {
+			effect.kind = EffectAddress;
+			effect.source = static_cast<unsigned char>(sourceSlot);
+			effect.imm = xed_decoded_inst_get_memory_displacement(&xedd, 0);
+		}
+	} else if(iclass == XED_ICLASS_MOV && xed_decoded_inst_number_of_memory_operands(&xedd) == 0) {
+		xed_reg_enum_t	sourceReg = xed_decoded_inst_get_reg(&xedd, XED_OPERAND_REG1);
+		int				sourceSlot = sourceReg == m_registers.GetFullRegister(sourceReg) ? GetSlot(sourceReg) : -1;
+
+		if(sourceSlot >= 0) {
+			effect.kind = EffectAddress;
+			effect.source = static_cast<unsigned char>(sourceSlot);
+		}
+	} else if((iclass == XED_ICLASS_ADD || iclass == XED_ICLASS_SUB) &&
+		xed_decoded_inst_number_of_memory_operands(&xedd) == 0 && xed_decoded_inst_get_immediate_width(&xedd)) {
+
+			long long imm = xed_decoded_inst_get_signed_immediate(&xedd);
+
+			effect.kind = EffectAdd;
+			effect.imm = iclass == XED_ICLASS_ADD ? imm : -imm;
+	}
+
+	if(effect.kind != EffectNone)
+		effect.dest = static_cast<unsigned char>(destSlot);
+}
+
+bool FrameDataflow::GetValue(const FrameState& state, unsigned int slot, unsigned char& base, long long& offset) const
+{
+	if(m_frameMask & (1 << slot)) {
+		base = static_cast<unsigned char>(slot);
+		offset = 0;
+		return true;
+	}
+
+	if(!(state.known & (1 << slot)))
+		return false;
+
+	base = state.base[slot];
+	offset = state.offset[slot];
+	return true;
+}
+
+void FrameDataflow::Apply(const FrameEffect& effect, FrameState& state) const
+{
+	unsigned char	base = 0;
+	long long		offset = 0;
+	bool			bKnown = false;
+
+	// read the inputs before anything written is clobbered
+	if(effect.kind == EffectAddress) {
+		bKnown = GetValue(state, effect.source, base, offset);
+	} else if(effect.kind == EffectAdd) {
+		bKnown = GetValue(state, effect.dest, base, offset);
+	}
+
+	offset += effect.imm;
+
+	state.known &= ~effect.killMask;
+
+	// moving a frame register invalidates everything measured from it
+	for(unsigned int frameKills = effect.killMask & m_frameMask; frameKills; frameKills &= frameKills - 1) {
+		unsigned int frameSlot = 0;
+
+		while(!(frameKills & (1 << frameSlot)))
+			++frameSlot;
+
+		for(size_t slot = 0, slot_end = m_slotRegisters.size(); slot < slot_end; ++slot) {
+			if((state.known & (1 << slot)) && state.base[slot] == frameSlot)
+				state.known &= ~(1 << slot);
+		}
+	}
+
+	if(bKnown && effect.kind != EffectNone && !(m_frameMask & (1 << effect.dest))) {
+		state.known |= 1 << effect.dest;
+		state.base[effect.dest] = base;
+		state.offset[effect.dest] = offset;
+	}
+}
+
+void FrameDataflow::Meet(FrameState& into, const FrameState& other) const
+{
+	unsigned int known = into.known & other.known;
+
+	for(size_t slot = 0, slot_end = m_slotRegisters.size(); slot < slot_end; ++slot) {
+		if((known & (1 << slot)) && (into.base[slot] != other.base[slot] || into.offset[slot] != other.offset[slot]))
+			known &= ~(1 << slot);
+	}
+
+	into.known = known;
+}
+
+bool FrameDataflow::SameState(const FrameState& a, const FrameState& b) const
+{
+	if(a.known != b.known)
+		return false;
+
+	for(size_t slot = 0, slot_end = m_slotRegisters.size(); slot < slot_end; ++slot) {
+		if((a.known & (1 << slot)) && (a.base[slot] != b.base[slot] || a.offset[slot] != b.offset[slot]))
+			return false;
+	}
+
+	return true;
+}
+
+void FrameDataflow::Solve(const ControlFlowGraph& cfg, const vector<FrameEffect>& effects, vector<FrameState>& entryStates) const
+{
+	size_t numBlocks = cfg.GetNumBlocks();
+
+	FrameState empty;
+	ClearState(empty);
+
+	entryStates.assign(numBlocks, empty);
+
+	if(!numBlocks)
+		return;
+
+	// blocks nothing reaches (only via an indirect jump, say) keep the empty state
+	vector<unsigned char>	bReached(numBlocks, 0);
+	vector<unsigned char>	bQueued(numBlocks, 0);
+	vector<size_t>			worklist;
+
+	bReached[0] = 1;
+	bQueued[0] = 1;
+	worklist.push_back(0);
+
+	while(!worklist.empty()) {
+		size_t block = worklist.back();
+		worklist.pop_back();
+		bQueued[block] = 0;
+
+		FrameState state = entryStates[block];
+
+		for(unsigned int instrNum = cfg.GetBlockStart(block), instrNum_end = cfg.GetBlockEnd(block); instrNum < instrNum_end; ++instrNum)
+			Apply(effects[instrNum], state);
+
+		size_t				numSuccs;
+		const unsigned int*	succs = cfg.GetSuccessors(block, numSuccs);
+
+		for(size_t i = 0; i < numSuccs; ++i) {
+			unsigned int succ = succs[i];
+
+			if(bReached[succ]) {
+				FrameState merged = entryStates[succ];
+				Meet(merged, state);
+
+				if(SameState(merged, entryStates[succ]))
+					continue;
+
+				entryStates[succ] = merged;
+			} else {
+				entryStates[succ] = state;
+				bReached[succ] = 1;
+			}
+
+			if(!bQueued[succ]) {
+				bQueued[succ] = 1;
+				worklist.push_back(succ);
+			}
+		}
+	}
+}
+
+bool FrameDataflow::Resolve(const FrameState& state, xed_reg_enum_t baseReg, long long displacement,
+	xed_reg_enum_t& frameReg, long long& frameOffset) const
+{
+	int slot = GetSlot(m_registers.GetFullRegister(baseReg));
+
+	unsigned char	base;
+	long long		offset;
+
+	if(slot < 0 || !GetValue(state, static_cast<unsigned int>(slot), base, offset))
+		return false;
+
+	frameReg = m_slotRegisters[base];
+	frameOffset = offset + displacement;
+	return true;
+}
\ No newline at end of file
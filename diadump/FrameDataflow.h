@@ -0,0 +1,84 @@
+#ifndef __FRAMEDATAFLOW_H__
+#define __FRAMEDATAFLOW_H__
+
+extern "C"
+{
+	#include <xed-interface.h>
+}
+
+#include <vector>
+
+#include "ControlFlowGraph.h"
+#include "RegisterMap.h"
+
+// general purpose registers tracked, 16 on x64 and 8 on x86
+static const size_t MaxTrackedRegisters = 16;
+
+//
+//	Which general purpose registers hold a known offset from one of
+//	the frame registers (RSP/RBP, or ESP/EBP on x86). One bit per
+//	register says whether it's known; only then do base and offset
+//	mean anything. The frame registers themselves are always their
+//	own base with offset 0 and are never marked known.
+//
+typedef struct
+{
+	unsigned int	known;
+	unsigned char	base[MaxTrackedRegisters];
+	long long		offset[MaxTrackedRegisters];
+} FrameState;
+
+enum FrameEffectKind
+{
+	EffectNone,
+	EffectAddress,		// dest = source + imm (lea, or mov reg, reg with imm 0)
+	EffectAdd			// dest += imm
+};
+
+// what one instruction does to the FrameState, taken from its decode once
+typedef struct
+{
+	unsigned char	kind;
+	unsigned char	dest;
+	unsigned char	source;
+	long long		imm;
+	unsigned int	killMask;
+} FrameEffect;
+
+//
+//	Forward dataflow over a function's CFG finding which registers
+//	point into the stack frame, so memory operands based on them can
+//	be matched to stack variables. The lattice per register is just
+//	unknown / one frame offset, so each block is revisited at most a
+//	couple of times per register and the pass stays linear in practice.
+//
+class FrameDataflow
+{
+public:
+	FrameDataflow(const RegisterMap& registers, bool bIs64Bit);
+
+	void						GetEffect(const xed_decoded_inst_t& xedd, FrameEffect& effect) const;
+	void						Solve(const ControlFlowGraph& cfg, const std::vector<FrameEffect>& effects, std::vector<FrameState>& entryStates) const;
+	void						Apply(const FrameEffect& effect, FrameState& state) const;
+
+	// turns base + displacement into frame register + offset, if the base is known
+	bool						Resolve(const FrameState& state, xed_reg_enum_t baseReg, long long displacement,
+									xed_reg_enum_t& frameReg, long long& frameOffset) const;
+
+	static void					ClearState(FrameState& state);
+
+private:
+	int							GetSlot(xed_reg_enum_t reg) const;
+	bool						GetValue(const FrameState& state, unsigned int slot, unsigned char& base, long long& offset) const;
+	void						Meet(FrameState& into, const FrameState& other) const;
+	bool						SameState(const FrameState& a, const FrameState& b) const;
+
+	const RegisterMap&			m_registers;
+
+	std::vector<xed_reg_enum_t>	m_slotRegisters;
+	std::vector<signed char>	m_slotOfRegister;
+	unsigned int				m_frameMask;
+	unsigned int				m_callKillMask;
+};
+
+#endif
\ No newline at end of file
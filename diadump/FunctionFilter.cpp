@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+
+#include "Utility.h"
+#include "FunctionFilter.h"
+
+using namespace std;
+
+static const wchar_t RegexSpecialChars[] = L"\\^$.|?*+()[]{}";
+
+FunctionFilter::FunctionFilter()
+	: m_minSize(0)
+{
+}
+
+void FunctionFilter::AddNamePattern(const wstring& glob)
+{
+	m_namePatterns.push_back(glob);
+}
+
+void FunctionFilter::AddNameRegex(const wstring& expression)
+{
+	NameRegex nameRegex;
+
+	nameRegex.expression = expression;
+
+	try {
+		nameRegex.regex.assign(expression);
+	} catch(const regex_error&) {
+		throw runtime_error("Invalid function name regex " + WideToUtf8(expression) + ".");
+	}
+
+	// "^literal..." can still use the name index as long as nothing
+	// after the literal run makes it optional
+	nameRegex.bAnchored = !expression.empty() && expression[0] == L'^' && expression.find(L'|') == wstring::npos;
+
+	if(nameRegex.bAnchored) {
+		size_t length = wcscspn(expression.c_str() + 1, RegexSpecialChars);
+
+		if(length && 1 + length < expression.length() && wcschr(L"?*{", expression[1 + length]))
+			--length;
+
+		nameRegex.prefix = expression.substr(1, length);
+	}
+
+	m_nameRegexes.push_back(nameRegex);
+}
+
+void FunctionFilter::AddCompiland(const wstring& glob)
+{
+	m_compilands.push_back(glob);
+}
+
+void FunctionFilter::AddRange(unsigned long long start, unsigned long long end)
+{
+	m_ranges.push_back(make_pair(start, end));
+}
+
+void FunctionFilter::SetMinSize(unsigned long long minSize)
+{
+	m_minSize = minSize;
+}
+
+bool FunctionFilter::IsEmpty() const
+{
+	return m_namePatterns.empty() && m_nameRegexes.empty() && m_compilands.empty() && m_ranges.empty() && !m_minSize;
+}
+
+void FunctionFilter::Select(const PDB& pdb, vector<size_t>& indices) const
+{
+	const vector<Function>& functions = pdb.GetFunctions();
+	vector<size_t>			candidates;
+
+	GetCandidates(pdb, candidates);
+
+	sort(candidates.begin(), candidates.end());
+	candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+
+	indices.clear();
+
+	for(vector<size_t>::const_iterator i = candidates.begin(), i_end = candidates.end(); i != i_end; ++i) {
+		if(Matches(functions[*i]))
+			indices.push_back(*i);
+	}
+}
+
+bool FunctionFilter::GlobMatch(const wstring& pattern, const wstring& str)
+{
+	size_t	p = 0;
+	size_t	s = 0;
+	size_t	starP = wstring::npos;
+	size_t	starS = 0;
+
+	// on a mismatch, let the last * swallow one more character and retry
+	while(s < str.length()) {
+		if(p < pattern.length() && (pattern[p] == L'?' || pattern[p] == str[s])) {
+			++p;
+			++s;
+		} else if(p < pattern.length() && pattern[p] == L'*') {
+			starP = p++;
+			starS = s;
+		} else if(starP != wstring::npos) {
+			p = starP + 1;
+			s = ++starS;
+		} else {
+			return false;
+		}
+	}
+
+	while(p < pattern.length() && pattern[p] == L'*')
+		++p;
+
+	return p == pattern.length();
+}
+
+void FunctionFilter::GetCandidates(const PDB& pdb, vector<size_t>& candidates) const
+{
+	const vector<Function>& functions = pdb.GetFunctions();
+
+	// a name criterion is only narrowed if every pattern has a literal prefix
+	bool bNamesIndexed = !m_namePatterns.empty() || !m_nameRegexes.empty();
+
+	for(vector<wstring>::const_iterator i = m_namePatterns.begin(), i_end = m_namePatterns.end(); i != i_end; ++i) {
+		if(i->empty() || (*i)[0] == L'*' || (*i)[0] == L'?')
+			bNamesIndexed = false;
+	}
+
+	for(vector<NameRegex>::const_iterator i = m_nameRegexes.begin(), i_end = m_nameRegexes.end(); i != i_end; ++i) {
+		if(!i->bAnchored || i->prefix.empty())
+			bNamesIndexed = false;
+	}
+
+	if(bNamesIndexed) {
+		for(vector<wstring>::const_iterator i = m_namePatterns.begin(), i_end = m_namePatterns.end(); i != i_end; ++i)
+			pdb.FindFunctionsByPrefix(i->substr(0, i->find_first_of(L"*?")), candidates);
+
+		for(vector<NameRegex>::const_iterator i = m_nameRegexes.begin(), i_end = m_nameRegexes.end(); i != i_end; ++i)
+			pdb.FindFunctionsByPrefix(i->prefix, candidates);
+
+		return;
+	}
+
+	if(!m_ranges.empty()) {
+		for(vector<pair<unsigned long long, unsigned long long>>::const_iterator i = m_ranges.begin(), i_end = m_ranges.end(); i != i_end; ++i)
+			pdb.FindFunctionsInRange(i->first, i->second, candidates);
+
+		return;
+	}
+
+	candidates.resize(functions.size());
+
+	for(size_t i = 0, i_end = candidates.size(); i < i_end; ++i)
+		candidates[i] = i;
+}
+
+bool FunctionFilter::MatchesName(const wstring& name) const
+{
+	for(vector<wstring>::const_iterator i = m_namePatterns.begin(), i_end = m_namePatterns.end(); i != i_end; ++i) {
+		if(GlobMatch(*i, name))
+			return true;
+	}
+
+	for(vector<NameRegex>::const_iterator i = m_nameRegexes.begin(), i_end = m_nameRegexes.end(); i != i_end; ++i) {
+		if(regex_search(name, i->regex))
+			return true;
+	}
+
+	return false;
+}
+
+bool FunctionFilter::Matches(const Function& func) const
+{
+	if(func.length < m_minSize)
+		return false;
+
+	if((!m_namePatterns.empty() || !m_nameRegexes.empty()) && !MatchesName(func.name))
+		return false;
+
+	if(!m_compilands.empty()) {
+		bool bFound = false;
+
+		for(vector<wstring>::const_iterator i = m_compilands.begin(), i_end = m_compilands.end(); i != i_end && !bFound; ++i)
+			bFound = GlobMatch(*i, func.compiland);
+
+		if(!bFound)
+			return false;
+	}
+
+	if(!m_ranges.empty()) {
+		bool				bFound = false;
+		unsigned long long	funcEnd = static_cast<unsigned long long>(func.address) + func.length;
+
+		for(vector<pair<unsigned long long, unsigned long long>>::const_iterator i = m_ranges.begin(), i_end = m_ranges.end(); i != i_end && !bFound; ++i)
+			bFound = func.address < i->second && funcEnd > i->first;
+
+		if(!bFound)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
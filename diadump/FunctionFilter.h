@@ -0,0 +1,60 @@
+#ifndef __FUNCTION_FILTER_H__
+#define __FUNCTION_FILTER_H__
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "PDB.h"
+
+//
+//	Picks which of a PDB's functions get disassembled, before any of
+//	them are decoded. Each kind of criterion matches if any of its
+//	values match (names, compilands, ranges); a function is selected
+//	when every kind that was given matches. Name patterns are looked
+//	up through the PDB's name index using their literal prefix, and
+//	address ranges through its address index, so picking a handful of
+//	functions out of a big image never walks the whole function list.
+//
+
+class FunctionFilter
+{
+public:
+	FunctionFilter();
+
+	// globs use * and ? and match the whole name
+	void			AddNamePattern(const std::wstring& glob);
+	void			AddNameRegex(const std::wstring& expression);
+	void			AddCompiland(const std::wstring& glob);
+	// [start, end) in RVAs, matches any function overlapping it
+	void			AddRange(unsigned long long start, unsigned long long end);
+	void			SetMinSize(unsigned long long minSize);
+
+	bool			IsEmpty() const;
+
+	// indices into pdb.GetFunctions(), sorted and unique
+	void			Select(const PDB& pdb, std::vector<size_t>& indices) const;
+	bool			Matches(const Function& func) const;
+
+	static bool		GlobMatch(const std::wstring& pattern, const std::wstring& str);
+
+private:
+	typedef struct
+	{
+		std::wstring	expression;
+		std::wregex		regex;
+		std::wstring	prefix;
+		bool			bAnchored;
+	} NameRegex;
+
+	void			GetCandidates(const PDB& pdb, std::vector<size_t>& candidates) const;
+	bool			MatchesName(const std::wstring& name) const;
+
+	std::vector<std::wstring>								m_namePatterns;
+	std::vector<NameRegex>									m_nameRegexes;
+	std::vector<std::wstring>								m_compilands;
+	std::vector<std::pair<unsigned long long, unsigned long long>>	m_ranges;
+	unsigned long long										m_minSize;
+};
+
+#endif
\ No newline at end of file
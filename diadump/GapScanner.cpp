@@ -0,0 +1,316 @@
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define GAPSCANNER_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <string.h>
+
+#include "GapScanner.h"
+
+using namespace std;
+
+// padding in the middle of a gap shorter than this is taken to be part
+// of the code, unless what follows it looks like the start of a function
+static const size_t MinInteriorPadding = 4;
+
+typedef struct
+{
+	bool			bIs64Bit;
+	size_t			length;
+	unsigned char	bytes[5];
+} ProloguePattern;
+
+// the ways MSVC functions usually begin; a gap starting with one of these is worth decoding
+static const ProloguePattern ProloguePatterns[] =
+{
+	{ true,		4, { 0x55, 0x48, 0x8B, 0xEC } },	// push rbp; mov rbp, rsp
+	{ true,		4, { 0x55, 0x48, 0x89, 0xE5 } },
+	{ true,		3, { 0x48, 0x89, 0x5C } },			// mov [rsp + n], rbx
+	{ true,		3, { 0x48, 0x89, 0x4C } },			// mov [rsp + n], rcx
+	{ true,		3, { 0x48, 0x89, 0x54 } },			// mov [rsp + n], rdx
+	{ true,		3, { 0x48, 0x89, 0x74 } },			// mov [rsp + n], rsi
+	{ true,		3, { 0x48, 0x89, 0x7C } },			// mov [rsp + n], rdi
+	{ true,		3, { 0x4C, 0x89, 0x44 } },			// mov [rsp + n], r8
+	{ true,		3, { 0x4C, 0x89, 0x4C } },			// mov [rsp + n], r9
+	{ true,		3, { 0x48, 0x83, 0xEC } },			// sub rsp, imm8
+	{ true,		3, { 0x48, 0x81, 0xEC } },			// sub rsp, imm32
+	{ true,		3, { 0x48, 0x8B, 0xC4 } },			// mov rax, rsp
+	{ true,		3, { 0x4C, 0x8B, 0xDC } },			// mov r11, rsp
+	{ true,		2, { 0x40, 0x53 } },				// push rbx
+	{ true,		2, { 0x40, 0x55 } },				// push rbp
+	{ true,		2, { 0x40, 0x56 } },				// push rsi
+	{ true,		2, { 0x40, 0x57 } },				// push rdi
+	{ true,		2, { 0x41, 0x54 } },				// push r12
+	{ true,		2, { 0x41, 0x55 } },				// push r13
+	{ true,		2, { 0x41, 0x56 } },				// push r14
+	{ true,		2, { 0x41, 0x57 } },				// push r15
+	{ false,	5, { 0x8B, 0xFF, 0x55, 0x8B, 0xEC } },	// mov edi, edi; push ebp; mov ebp, esp
+	{ false,	3, { 0x55, 0x8B, 0xEC } },			// push ebp; mov ebp, esp
+	{ false,	3, { 0x55, 0x89, 0xE5 } },
+	{ false,	2, { 0x83, 0xEC } },				// sub esp, imm8
+	{ false,	2, { 0x81, 0xEC } },				// sub esp, imm32
+	{ false,	2, { 0x53, 0x56 } },				// push ebx; push esi
+	{ false,	2, { 0x56, 0x57 } }					// push esi; push edi
+};
+
+static inline bool IsPadding(unsigned char value)
+{
+	return value == 0xCC || value == 0x90;
+}
+
+static size_t FindScalar(const unsigned char* data, size_t size, bool bPadding)
+{
+	for(size_t offset = 0; offset < size; ++offset) {
+		if(IsPadding(data[offset]) == bPadding)
+			return offset;
+	}
+
+	return size;
+}
+
+#ifdef GAPSCANNER_SIMD
+static inline unsigned int CountTrailingZeros(unsigned int mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+// every compare makes a byte mask of int3 or nop, movemask packs it
+// into one bit per byte and the first set (or clear) bit is the answer
+TARGET_SSE2 static size_t FindSSE2(const unsigned char* data, size_t size, bool bPadding)
+{
+	const __m128i	int3 = _mm_set1_epi8(static_cast<char>(0xCC));
+	const __m128i	nop = _mm_set1_epi8(static_cast<char>(0x90));
+	unsigned int	flip = bPadding ? 0 : 0xFFFF;
+	size_t			offset = 0;
+
+	for(; offset + 16 <= size; offset += 16) {
+		__m128i			bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+		unsigned int	mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, int3), _mm_cmpeq_epi8(bytes, nop)))) ^ flip;
+
+		if(mask)
+			return offset + CountTrailingZeros(mask);
+	}
+
+	return offset + FindScalar(data + offset, size - offset, bPadding);
+}
+
+TARGET_AVX2 static size_t FindAVX2(const unsigned char* data, size_t size, bool bPadding)
+{
+	const __m256i	int3 = _mm256_set1_epi8(static_cast<char>(0xCC));
+	const __m256i	nop = _mm256_set1_epi8(static_cast<char>(0x90));
+	unsigned int	flip = bPadding ? 0 : 0xFFFFFFFF;
+	size_t			offset = 0;
+
+	for(; offset + 32 <= size; offset += 32) {
+		__m256i			bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+		unsigned int	mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, int3), _mm256_cmpeq_epi8(bytes, nop)))) ^ flip;
+
+		if(mask)
+			return offset + CountTrailingZeros(mask);
+	}
+
+	return offset + FindScalar(data + offset, size - offset, bPadding);
+}
+
+static bool HasSSE2()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2") != 0;
+#endif
+}
+
+static bool HasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+
+	__cpuid(info, 0);
+
+	if(info[0] < 7)
+		return false;
+
+	// the OS also has to be saving the upper halves of the YMM registers
+	__cpuid(info, 1);
+
+	if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+GapScanner::GapScanner(const PE& pe, const PDB& pdb)
+	: m_pe(pe), m_pdb(pdb), m_find(FindScalar), m_implementationName("scalar")
+{
+#ifdef GAPSCANNER_SIMD
+	if(HasAVX2()) {
+		m_find = FindAVX2;
+		m_implementationName = "avx2";
+	} else if(HasSSE2()) {
+		m_find = FindSSE2;
+		m_implementationName = "sse2";
+	}
+#endif
+}
+
+void GapScanner::Scan(vector<SectionGap>& gaps) const
+{
+	const vector<PESection>&	sections = m_pe.getSections();
+	const vector<Function>&		functions = m_pdb.GetFunctions();
+
+	gaps.clear();
+
+	for(size_t sectionNum = 0, sectionNum_end = sections.size(); sectionNum < sectionNum_end; ++sectionNum) {
+		const IMAGE_SECTION_HEADER&	header = sections[sectionNum].getSectionHeader();
+		ByteSpan					data;
+
+		if(!(header.Characteristics & IMAGE_SCN_MEM_EXECUTE) || !m_pe.getSectionData(sectionNum, data))
+			continue;
+
+		// the raw data is padded out to the file alignment with zeros
+		size_t size = data.size;
+
+		if(header.Misc.VirtualSize && header.Misc.VirtualSize < size)
+			size = header.Misc.VirtualSize;
+
+		vector<size_t> covering;
+		m_pdb.FindFunctionsInRange(header.VirtualAddress, header.VirtualAddress + static_cast<unsigned long long>(size), covering);
+
+		sort(covering.begin(), covering.end(), [&functions](size_t a, size_t b) {
+			return functions[a].address < functions[b].address;
+		});
+
+		// everything between the end of the furthest reaching function so far and the next one
+		size_t covered = 0;
+
+		for(vector<size_t>::const_iterator i = covering.begin(), i_end = covering.end(); i != i_end; ++i) {
+			const Function& func = functions[*i];
+
+			size_t funcStart = func.address > header.VirtualAddress ? func.address - header.VirtualAddress : 0;
+			size_t funcEnd = static_cast<size_t>(min<unsigned long long>(func.address + func.length - header.VirtualAddress, size));
+
+			if(funcStart > covered)
+				ScanRange(data.data, header.VirtualAddress, covered, funcStart, gaps);
+
+			if(funcEnd > covered)
+				covered = funcEnd;
+		}
+
+		if(covered < size)
+			ScanRange(data.data, header.VirtualAddress, covered, size, gaps);
+	}
+}
+
+const char* GapScanner::GetImplementationName() const
+{
+	return m_implementationName;
+}
+
+void GapScanner::GetCandidateFunctions(const vector<SectionGap>& gaps, vector<Function>& functions)
+{
+	for(vector<SectionGap>::const_iterator i = gaps.begin(), i_end = gaps.end(); i != i_end; ++i) {
+		if(i->kind != GapCandidate)
+			continue;
+
+		wostringstream name;
+		name << L"sub_" << hex << uppercase << i->rva;
+
+		Function func;
+		func.name = name.str();
+		func.address = i->rva;
+		func.length = i->length;
+
+		functions.push_back(func);
+	}
+}
+
+void GapScanner::WriteGapSummary(const vector<SectionGap>& gaps, wostream& out)
+{
+	unsigned long long count[3] = { 0, 0, 0 };
+	unsigned long long bytes[3] = { 0, 0, 0 };
+
+	for(vector<SectionGap>::const_iterator i = gaps.begin(), i_end = gaps.end(); i != i_end; ++i) {
+		++count[i->kind];
+		bytes[i->kind] += i->length;
+	}
+
+	out << L"Padding: " << count[GapPadding] << L" runs, " << bytes[GapPadding] << L" bytes" << endl;
+	out << L"Uncovered: " << count[GapUnknown] << L" gaps, " << bytes[GapUnknown] << L" bytes" << endl;
+	out << L"Candidate functions: " << count[GapCandidate] << L", " << bytes[GapCandidate] << L" bytes" << endl;
+}
+
+void GapScanner::ScanRange(const unsigned char* data, unsigned long rva, size_t start, size_t end, vector<SectionGap>& gaps) const
+{
+	size_t chunkStart = start;
+
+	for(size_t offset = start; offset < end;) {
+		size_t padStart = offset + m_find(data + offset, end - offset, true);
+
+		if(padStart >= end)
+			break;
+
+		size_t padEnd = padStart + m_find(data + padStart, end - padStart, false);
+
+		// alignment fill at either end of the gap is always padding,
+		// a nop or two inside it is more likely just an instruction
+		if(padStart == start || padEnd == end || padEnd - padStart >= MinInteriorPadding ||
+			LooksLikePrologue(data + padEnd, end - padEnd)) {
+			if(padStart > chunkStart) {
+				SectionGap gap = { LooksLikePrologue(data + chunkStart, padStart - chunkStart) ? GapCandidate : GapUnknown,
+					rva + static_cast<unsigned long>(chunkStart), static_cast<unsigned long>(padStart - chunkStart) };
+				gaps.push_back(gap);
+			}
+
+			SectionGap padding = { GapPadding, rva + static_cast<unsigned long>(padStart), static_cast<unsigned long>(padEnd - padStart) };
+			gaps.push_back(padding);
+
+			chunkStart = padEnd;
+		}
+
+		offset = padEnd;
+	}
+
+	if(chunkStart < end) {
+		SectionGap gap = { LooksLikePrologue(data + chunkStart, end - chunkStart) ? GapCandidate : GapUnknown,
+			rva + static_cast<unsigned long>(chunkStart), static_cast<unsigned long>(end - chunkStart) };
+		gaps.push_back(gap);
+	}
+}
+
+bool GapScanner::LooksLikePrologue(const unsigned char* data, size_t size) const
+{
+	for(size_t i = 0; i < sizeof(ProloguePatterns) / sizeof(ProloguePatterns[0]); ++i) {
+		const ProloguePattern& pattern = ProloguePatterns[i];
+
+		if(pattern.bIs64Bit == m_pe.Is64Bit() && pattern.length < size && memcmp(data, pattern.bytes, pattern.length) == 0)
+			return true;
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#ifndef __GAPSCANNER_H__
+#define __GAPSCANNER_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PDB.h"
+#include "PE.h"
+
+enum SectionGapKind
+{
+	GapPadding,		// int3/nop fill
+	GapUnknown,		// not covered by any function, doesn't look like code
+	GapCandidate	// not covered by any function, starts like a prologue
+};
+
+typedef struct
+{
+	SectionGapKind		kind;
+	unsigned long		rva;
+	unsigned long		length;
+} SectionGap;
+
+//
+//	Walks every executable section looking for the bytes no PDB
+//	function covers. Uncovered bytes are split into int3/nop padding
+//	runs and gaps; a gap that starts with a usual prologue is likely
+//	a function the PDB doesn't know about and is reported as a
+//	candidate. Padding is found 16 or 32 bytes at a time with SSE2 or
+//	AVX2, picked once from what the CPU supports.
+//
+class GapScanner
+{
+public:
+	GapScanner(const PE& pe, const PDB& pdb);
+
+	// gaps come out in RVA order
+	void					Scan(std::vector<SectionGap>& gaps) const;
+
+	// what the padding search ended up using: "avx2", "sse2" or "scalar"
+	const char*				GetImplementationName() const;
+
+	// a Function for each candidate gap, named sub_<RVA>
+	static void				GetCandidateFunctions(const std::vector<SectionGap>& gaps, std::vector<Function>& functions);
+	static void				WriteGapSummary(const std::vector<SectionGap>& gaps, std::wostream& out);
+
+private:
+	// index of the first byte whose padding-ness is bPadding, or size
+	typedef size_t			(*FindFunc)(const unsigned char* data, size_t size, bool bPadding);
+
+	void					ScanRange(const unsigned char* data, unsigned long rva, size_t start, size_t end, std::vector<SectionGap>& gaps) const;
+	bool					LooksLikePrologue(const unsigned char* data, size_t size) const;
+
+	const PE&				m_pe;
+	const PDB&				m_pdb;
+
+	FindFunc				m_find;
+	const char*				m_implementationName;
+};
+
+#endif
\ No newline at end of file
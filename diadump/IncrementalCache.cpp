@@ -0,0 +1,201 @@
+#include <fstream>
+#include <stdexcept>
+#include "BinaryReader.h"
+#include "Utility.h"
+#include "IncrementalCache.h"
+
+using namespace std;
+
+//
+//	File layout, all little-endian:
+//
+//	header		magic, version, number of entries
+//	entries		hash, text length, then the text itself
+//	trailer		magic again, so a half-written file is never used
+//
+//	Bump the version whenever the dump format changes, so text
+//	written by an older diadump isn't spliced into a newer dump.
+//
+
+static const unsigned int IncrementalMagic = 0x43494444;	// "DDIC"
+static const unsigned int IncrementalVersion = 3;
+
+static const unsigned long long FNVOffsetBasis = 14695981039346656037ULL;
+static const unsigned long long FNVPrime = 1099511628211ULL;
+
+static void HashBytes(unsigned long long& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for(size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= FNVPrime;
+	}
+}
+
+template<typename T>
+static void HashValue(unsigned long long& hash, T value)
+{
+	HashBytes(hash, &value, sizeof(value));
+}
+
+static void HashString(unsigned long long& hash, const wstring& str)
+{
+	string utf8 = WideToUtf8(str);
+
+	// include the terminator so "ab","c" and "a","bc" differ
+	HashBytes(hash, utf8.c_str(), utf8.length() + 1);
+}
+
+static void HashVariables(unsigned long long& hash, const vector<Variable>& variables)
+{
+	HashValue<unsigned int>(hash, static_cast<unsigned int>(variables.size()));
+
+	for(vector<Variable>::const_iterator var = variables.begin(), var_end = variables.end();
+		var != var_end; ++var) {
+
+			HashValue<unsigned int>(hash, var->location);
+			HashValue<long long>(hash, var->offset);
+			HashValue<unsigned int>(hash, var->section);
+			HashValue<unsigned int>(hash, var->eRegister);
+			HashString(hash, var->name);
+	}
+}
+
+IncrementalCache::IncrementalCache()
+{
+}
+
+unsigned long long IncrementalCache::HashFunction(const Function& func, const ByteSpan& code, unsigned long long imageBase, unsigned int dumpOptions)
+{
+	unsigned long long hash = FNVOffsetBasis;
+
+	HashValue<unsigned int>(hash, dumpOptions);
+	HashValue<unsigned long long>(hash, imageBase);
+	HashValue<unsigned int>(hash, func.address);
+	HashValue<unsigned long long>(hash, func.length);
+	HashString(hash, func.compiland);
+	HashString(hash, func.name);
+	HashVariables(hash, func.parameters);
+	HashVariables(hash, func.localVariables);
+
+	HashValue<unsigned long long>(hash, code.size);
+	HashBytes(hash, code.data, code.size);
+
+	return hash;
+}
+
+bool IncrementalCache::Load(const wstring& filename)
+{
+	Clear();
+
+	shared_ptr<MappedFile> file;
+
+	try {
+		file = shared_ptr<MappedFile>(new MappedFile(filename));
+	} catch(const runtime_error&) {
+		return false;
+	}
+
+	// a bad file is treated like no file, everything gets decoded
+	try {
+		BinaryReader reader(file->GetData(), file->GetSize());
+
+		if(reader.Read<unsigned int>() != IncrementalMagic || reader.Read<unsigned int>() != IncrementalVersion)
+			return false;
+
+		unsigned int numEntries = reader.Read<unsigned int>();
+
+		if(numEntries > reader.Remaining() / (sizeof(unsigned long long) + sizeof(unsigned int)))
+			return false;
+
+		unordered_map<unsigned long long, ByteSpan> entries;
+		vector<unsigned long long> order;
+
+		for(unsigned int entryNum = 0; entryNum < numEntries; ++entryNum) {
+			unsigned long long	hash = reader.Read<unsigned long long>();
+			ByteSpan			output;
+
+			output.size = reader.Read<unsigned int>();
+			output.data = reader.Current();
+			reader.Skip(output.size);
+
+			if(entries.insert(make_pair(hash, output)).second)
+				order.push_back(hash);
+		}
+
+		if(reader.Read<unsigned int>() != IncrementalMagic)
+			return false;
+
+		m_file = file;
+		m_entries.swap(entries);
+		m_order.swap(order);
+	} catch(const runtime_error&) {
+		return false;
+	}
+
+	return true;
+}
+
+bool IncrementalCache::Save(const wstring& filename) const
+{
+	ofstream outFile(NativePath(filename).c_str(), ios::out | ios::binary | ios::trunc);
+
+	if(!outFile)
+		return false;
+
+	unsigned int header[] = { IncrementalMagic, IncrementalVersion, static_cast<unsigned int>(m_order.size()) };
+	outFile.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	for(vector<unsigned long long>::const_iterator i = m_order.begin(), i_end = m_order.end(); i != i_end; ++i) {
+		const ByteSpan& output = m_entries.find(*i)->second;
+		unsigned int	length = static_cast<unsigned int>(output.size);
+
+		outFile.write(reinterpret_cast<const char*>(&*i), sizeof(*i));
+		outFile.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		outFile.write(reinterpret_cast<const char*>(output.data), output.size);
+	}
+
+	outFile.write(reinterpret_cast<const char*>(&IncrementalMagic), sizeof(IncrementalMagic));
+
+	return outFile.good();
+}
+
+void IncrementalCache::Clear()
+{
+	m_entries.clear();
+	m_order.clear();
+	m_addedOutputs.clear();
+	m_file.reset();
+}
+
+bool IncrementalCache::Find(unsigned long long hash, ByteSpan& output) const
+{
+	unordered_map<unsigned long long, ByteSpan>::const_iterator found = m_entries.find(hash);
+
+	if(found == m_entries.end())
+		return false;
+
+	output = found->second;
+	return true;
+}
+
+void IncrementalCache::Add(unsigned long long hash, const char* output, size_t length)
+{
+	if(m_entries.find(hash) != m_entries.end())
+		return;
+
+	m_addedOutputs.push_back(string(output, length));
+
+	ByteSpan span;
+	span.data = reinterpret_cast<const unsigned char*>(m_addedOutputs.back().data());
+	span.size = length;
+
+	m_entries.insert(make_pair(hash, span));
+	m_order.push_back(hash);
+}
+
+size_t IncrementalCache::GetNumEntries() const
+{
+	return m_entries.size();
+}
\ No newline at end of file
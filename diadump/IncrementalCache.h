@@ -0,0 +1,45 @@
+#ifndef __INCREMENTALCACHE_H__
+#define __INCREMENTALCACHE_H__
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "PDB.h"
+
+//
+//	The text each function produced on a previous run, keyed by a
+//	hash of everything that goes into that text: the code bytes, the
+//	function's address and symbol information, the image base and
+//	the options that change how the dump is produced.
+//	A function whose hash is found doesn't need to be decoded again.
+//
+class IncrementalCache
+{
+public:
+	IncrementalCache();
+
+	bool								Load(const std::wstring& filename);
+	bool								Save(const std::wstring& filename) const;
+	void								Clear();
+
+	bool								Find(unsigned long long hash, ByteSpan& output) const;
+	void								Add(unsigned long long hash, const char* output, size_t length);
+	size_t								GetNumEntries() const;
+
+	static unsigned long long			HashFunction(const Function& func, const ByteSpan& code, unsigned long long imageBase, unsigned int dumpOptions);
+
+private:
+	// the file loaded from, entries point into it
+	std::shared_ptr<MappedFile>	m_file;
+
+	// text added this run, a deque so the strings never move
+	std::deque<std::string>				m_addedOutputs;
+
+	std::unordered_map<unsigned long long, ByteSpan>	m_entries;
+	std::vector<unsigned long long>						m_order;
+};
+
+#endif
\ No newline at end of file
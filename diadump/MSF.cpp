@@ -0,0 +1,140 @@
+#include <stdexcept>
+#include <string.h>
+#include "BinaryReader.h"
+#include "Utility.h"
+#include "MSF.h"
+
+using namespace std;
+
+static const char			MSFMagic[] = "Microsoft C/C++ MSF 7.00\r\n\x1a" "DS\0\0";
+static const unsigned long	NilStreamSize = 0xFFFFFFFF;
+
+typedef struct
+{
+	char			magic[32];
+	unsigned int	blockSize;
+	unsigned int	freeBlockMapBlock;
+	unsigned int	numBlocks;
+	unsigned int	numDirectoryBytes;
+	unsigned int	unknown;
+	unsigned int	blockMapAddr;
+} MSFSuperBlock;
+
+MSF::MSF(const wstring& filename)
+	: m_file(NativePath(filename).c_str(), ios::in | ios::binary)
+{
+	if(!m_file) {
+		throw runtime_error("Unable to open PDB file");
+	}
+
+	MSFSuperBlock superBlock;
+	m_file.read(reinterpret_cast<char*>(&superBlock), sizeof(superBlock));
+
+	if(!m_file || memcmp(superBlock.magic, MSFMagic, sizeof(superBlock.magic)) != 0)
+		throw runtime_error("Invalid PDB file. MSF 7.0 signature invalid.");
+
+	if(superBlock.blockSize == 0 || superBlock.blockSize % 512 != 0)
+		throw runtime_error("Invalid PDB file. Bad MSF block size.");
+
+	m_blockSize = superBlock.blockSize;
+	m_numBlocks = superBlock.numBlocks;
+
+	// the block map holds the list of blocks making up the stream directory
+	unsigned long numDirectoryBlocks = (superBlock.numDirectoryBytes + m_blockSize - 1) / m_blockSize;
+	vector<unsigned long> directoryBlocks(numDirectoryBlocks);
+
+	if(superBlock.blockMapAddr >= m_numBlocks)
+		throw runtime_error("Invalid PDB file. Block map out of range.");
+
+	m_file.seekg(static_cast<streamoff>(superBlock.blockMapAddr) * m_blockSize, ios::beg);
+
+	for(unsigned long i = 0; i < numDirectoryBlocks; ++i) {
+		unsigned int block;
+		m_file.read(reinterpret_cast<char*>(&block), sizeof(block));
+		directoryBlocks[i] = block;
+	}
+
+	if(!m_file)
+		throw runtime_error("Invalid PDB file. Unable to read block map.");
+
+	vector<unsigned char> directory;
+	ReadBlocks(directoryBlocks, superBlock.numDirectoryBytes, directory);
+
+	BinaryReader reader(directory.empty() ? 0 : &directory[0], directory.size());
+
+	unsigned long numStreams = reader.Read<unsigned int>();
+
+	m_streamSizes.resize(numStreams);
+	m_streamBlocks.resize(numStreams);
+
+	for(unsigned long i = 0; i < numStreams; ++i) {
+		m_streamSizes[i] = reader.Read<unsigned int>();
+	}
+
+	for(unsigned long i = 0; i < numStreams; ++i) {
+		if(m_streamSizes[i] == NilStreamSize)
+			continue;
+
+		unsigned long numStreamBlocks = (m_streamSizes[i] + m_blockSize - 1) / m_blockSize;
+		m_streamBlocks[i].resize(numStreamBlocks);
+
+		for(unsigned long block = 0; block < numStreamBlocks; ++block)
+			m_streamBlocks[i][block] = reader.Read<unsigned int>();
+	}
+}
+
+size_t MSF::GetNumStreams() const
+{
+	return m_streamSizes.size();
+}
+
+unsigned long MSF::GetStreamSize(size_t streamIndex) const
+{
+	if(streamIndex >= m_streamSizes.size() || m_streamSizes[streamIndex] == NilStreamSize)
+		return 0;
+
+	return m_streamSizes[streamIndex];
+}
+
+bool MSF::ReadStream(size_t streamIndex, vector<unsigned char>& data) const
+{
+	if(streamIndex >= m_streamSizes.size() || m_streamSizes[streamIndex] == NilStreamSize) {
+		data.clear();
+		return false;
+	}
+
+	ReadBlocks(m_streamBlocks[streamIndex], m_streamSizes[streamIndex], data);
+	return true;
+}
+
+void MSF::ReadBlocks(const vector<unsigned long>& blocks, unsigned long size, vector<unsigned char>& data) const
+{
+	data.resize(size);
+
+	unsigned long bytesRead = 0;
+
+	for(size_t i = 0, i_end = blocks.size(); i < i_end && bytesRead < size;) {
+		if(blocks[i] >= m_numBlocks)
+			throw runtime_error("Invalid PDB file. Stream block out of range.");
+
+		// coalesce runs of consecutive blocks into a single read
+		size_t runEnd = i + 1;
+
+		while(runEnd < i_end && blocks[runEnd] == blocks[runEnd - 1] + 1)
+			++runEnd;
+
+		unsigned long runBytes = static_cast<unsigned long>(runEnd - i) * m_blockSize;
+
+		if(runBytes > size - bytesRead)
+			runBytes = size - bytesRead;
+
+		m_file.seekg(static_cast<streamoff>(blocks[i]) * m_blockSize, ios::beg);
+		m_file.read(reinterpret_cast<char*>(&data[bytesRead]), runBytes);
+
+		if(!m_file)
+			throw runtime_error("Invalid PDB file. Unable to read stream data.");
+
+		bytesRead += runBytes;
+		i = runEnd;
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef __MSF_H__
+#define __MSF_H__
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+//
+//	Reader for the MSF 7.0 multi-stream container that PDB files are
+//	stored in. Each stream is a list of fixed size blocks scattered
+//	through the file; ReadStream stitches them back together.
+//
+class MSF
+{
+public:
+	explicit MSF(const std::wstring& filename);
+
+	size_t							GetNumStreams() const;
+	unsigned long					GetStreamSize(size_t streamIndex) const;
+	bool							ReadStream(size_t streamIndex, std::vector<unsigned char>& data) const;
+
+private:
+	void							ReadBlocks(const std::vector<unsigned long>& blocks, unsigned long size, std::vector<unsigned char>& data) const;
+
+	mutable std::ifstream						m_file;
+	unsigned long								m_blockSize;
+	unsigned long								m_numBlocks;
+
+	std::vector<unsigned long>					m_streamSizes;
+	std::vector<std::vector<unsigned long>>		m_streamBlocks;
+};
+
+#endif
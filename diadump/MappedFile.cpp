@@ -0,0 +1,127 @@
+#include <stdexcept>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Utility.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const wstring& filename)
+	: m_file(INVALID_HANDLE_VALUE), m_mapping(NULL), m_data(NULL), m_size(0)
+{
+	m_file = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if(m_file == INVALID_HANDLE_VALUE) {
+		throw runtime_error("Unable to open file for mapping");
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if(!GetFileSizeEx(m_file, &fileSize)) {
+		CloseHandle(m_file);
+		throw runtime_error("Unable to get size of file for mapping");
+	}
+
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+
+	// an empty file can't be mapped, leave the view empty
+	if(!m_size)
+		return;
+
+	m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(!m_mapping) {
+		CloseHandle(m_file);
+		throw runtime_error("Unable to create file mapping");
+	}
+
+	m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if(!m_data) {
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+		throw runtime_error("Unable to map view of file");
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if(m_data)
+		UnmapViewOfFile(m_data);
+
+	if(m_mapping)
+		CloseHandle(m_mapping);
+
+	if(m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+
+#else
+
+MappedFile::MappedFile(const wstring& filename)
+	: m_data(NULL), m_size(0)
+{
+	int fd = open(WideToUtf8(filename).c_str(), O_RDONLY);
+
+	if(fd < 0) {
+		throw runtime_error("Unable to open file for mapping");
+	}
+
+	struct stat fileStat;
+
+	if(fstat(fd, &fileStat) != 0) {
+		close(fd);
+		throw runtime_error("Unable to get size of file for mapping");
+	}
+
+	m_size = static_cast<size_t>(fileStat.st_size);
+
+	if(m_size) {
+		void* view = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if(view == MAP_FAILED) {
+			close(fd);
+			throw runtime_error("Unable to map view of file");
+		}
+
+		m_data = static_cast<const unsigned char*>(view);
+	}
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+	if(m_data)
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+#endif
+
+const unsigned char* MappedFile::GetData() const
+{
+	return m_data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_size;
+}
+
+ByteSpan MappedFile::GetSpan() const
+{
+	ByteSpan span;
+	span.data = m_data;
+	span.size = m_size;
+	return span;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __MAPPEDFILE_H__
+#define __MAPPEDFILE_H__
+
+#include <string>
+
+// a read-only view of some bytes owned by someone else
+typedef struct
+{
+	const unsigned char*	data;
+	size_t					size;
+} ByteSpan;
+
+//
+//	Maps a whole file read-only into memory. The bytes are served
+//	straight from the page cache, nothing is copied up front.
+//
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::wstring& filename);
+	~MappedFile();
+
+	const unsigned char*	GetData() const;
+	size_t					GetSize() const;
+	ByteSpan				GetSpan() const;
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+#ifdef _WIN32
+	void*					m_file;
+	void*					m_mapping;
+#endif
+	const unsigned char*	m_data;
+	size_t					m_size;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include <string.h>
+#include "OutputFormatter.h"
+
+using namespace std;
+
+static const char UpperHexDigits[] = "0123456789ABCDEF";
+static const char LowerHexDigits[] = "0123456789abcdef";
+
+OutputFormatter::OutputFormatter(ostream& out, size_t bufferSize)
+	: m_out(out), m_buffer(bufferSize < 64 ? 64 : bufferSize), m_used(0), m_bytesFlushed(0)
+{
+}
+
+OutputFormatter::~OutputFormatter()
+{
+	Flush();
+}
+
+void OutputFormatter::Append(char c)
+{
+	Reserve(1);
+	m_buffer[m_used++] = c;
+}
+
+void OutputFormatter::Append(const char* str)
+{
+	Append(str, strlen(str));
+}
+
+void OutputFormatter::Append(const char* str, size_t length)
+{
+	// anything bigger than the buffer goes straight through
+	if(length > m_buffer.size()) {
+		Flush();
+		m_out.write(str, length);
+		m_bytesFlushed += length;
+		return;
+	}
+
+	Reserve(length);
+	memcpy(&m_buffer[m_used], str, length);
+	m_used += length;
+}
+
+void OutputFormatter::Append(const wstring& str)
+{
+	for(size_t i = 0, i_end = str.length(); i < i_end; ++i) {
+		unsigned long codePoint = static_cast<unsigned long>(str[i]);
+
+		if(codePoint < 0x80) {
+			Append(static_cast<char>(codePoint));
+			continue;
+		}
+
+		// recombine UTF-16 surrogate pairs
+		if(codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < i_end) {
+			unsigned long low = static_cast<unsigned long>(str[i + 1]);
+
+			if(low >= 0xDC00 && low < 0xE000) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				++i;
+			}
+		}
+
+		Reserve(4);
+
+		if(codePoint < 0x800) {
+			m_buffer[m_used++] = static_cast<char>(0xC0 | (codePoint >> 6));
+		} else if(codePoint < 0x10000) {
+			m_buffer[m_used++] = static_cast<char>(0xE0 | (codePoint >> 12));
+			m_buffer[m_used++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		} else {
+			m_buffer[m_used++] = static_cast<char>(0xF0 | (codePoint >> 18));
+			m_buffer[m_used++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			m_buffer[m_used++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+		}
+
+		m_buffer[m_used++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+	}
+}
+
+void OutputFormatter::AppendHex(unsigned long long value, unsigned int minDigits, bool bUppercase)
+{
+	const char* digits = bUppercase ? UpperHexDigits : LowerHexDigits;
+
+	// fill from the right in a scratch buffer, 16 digits covers any 64-bit value
+	char			scratch[16];
+	unsigned int	numDigits = 0;
+
+	do {
+		scratch[15 - numDigits++] = digits[value & 0xF];
+		value >>= 4;
+	} while(value);
+
+	if(minDigits > 16)
+		minDigits = 16;
+
+	while(numDigits < minDigits)
+		scratch[15 - numDigits++] = '0';
+
+	Append(scratch + 16 - numDigits, numDigits);
+}
+
+void OutputFormatter::AppendDecimal(unsigned long long value)
+{
+	// 20 digits covers any 64-bit value
+	char			scratch[20];
+	unsigned int	numDigits = 0;
+
+	do {
+		scratch[19 - numDigits++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while(value);
+
+	Append(scratch + 20 - numDigits, numDigits);
+}
+
+void OutputFormatter::AppendLine()
+{
+	// the stream is binary, so write the line ending a text-mode stream would have
+#ifdef _WIN32
+	Append("\r\n", 2);
+#else
+	Append('\n');
+#endif
+}
+
+unsigned long long OutputFormatter::GetPosition() const
+{
+	return m_bytesFlushed + m_used;
+}
+
+void OutputFormatter::PadFrom(unsigned long long fieldStart, size_t width)
+{
+	unsigned long long fieldLength = GetPosition() - fieldStart;
+
+	if(fieldLength >= width)
+		return;
+
+	size_t padding = static_cast<size_t>(width - fieldLength);
+
+	Reserve(padding);
+	memset(&m_buffer[m_used], ' ', padding);
+	m_used += padding;
+}
+
+void OutputFormatter::Flush()
+{
+	if(!m_used)
+		return;
+
+	m_out.write(&m_buffer[0], m_used);
+	m_bytesFlushed += m_used;
+	m_used = 0;
+}
+
+unsigned long long OutputFormatter::GetBytesWritten() const
+{
+	return m_bytesFlushed + m_used;
+}
+
+void OutputFormatter::Reserve(size_t length)
+{
+	if(m_buffer.size() - m_used < length)
+		Flush();
+
+	// a single padding run can still be wider than the buffer
+	if(m_buffer.size() < length)
+		m_buffer.resize(length);
+}
\ No newline at end of file
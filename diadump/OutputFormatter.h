@@ -0,0 +1,46 @@
+#ifndef __OUTPUTFORMATTER_H__
+#define __OUTPUTFORMATTER_H__
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+//
+//	Writes the text dump as UTF-8 through one large reusable buffer,
+//	flushing it to the underlying stream in big blocks. Numbers are
+//	formatted by hand instead of going through stream manipulators.
+//
+class OutputFormatter
+{
+public:
+	explicit OutputFormatter(std::ostream& out, size_t bufferSize = 1 << 20);
+	~OutputFormatter();
+
+	void					Append(char c);
+	void					Append(const char* str);
+	void					Append(const char* str, size_t length);
+	void					Append(const std::wstring& str);
+	void					AppendHex(unsigned long long value, unsigned int minDigits, bool bUppercase);
+	void					AppendDecimal(unsigned long long value);
+	void					AppendLine();
+
+	// column padding: remember where a field starts, write it, then pad it out
+	unsigned long long		GetPosition() const;
+	void					PadFrom(unsigned long long fieldStart, size_t width);
+
+	void					Flush();
+	unsigned long long		GetBytesWritten() const;
+
+private:
+	OutputFormatter(const OutputFormatter&);
+	OutputFormatter& operator=(const OutputFormatter&);
+
+	void					Reserve(size_t length);
+
+	std::ostream&			m_out;
+	std::vector<char>		m_buffer;
+	size_t					m_used;
+	unsigned long long		m_bytesFlushed;
+};
+
+#endif
\ No newline at end of file
@@ -1,282 +1,640 @@
-#include <atlbase.h>
+#include <algorithm>
 #include <string>
-#include <dia2.h>
+#include <vector>
 #include <stdexcept>
+#include <string.h>
+#include "BinaryReader.h"
+#include "CodeView.h"
+#include "MSF.h"
+#include "SymbolCache.h"
+#include "Stats.h"
+#include "TypeStream.h"
+#include "Utility.h"
 #include "PDB.h"
 
 using namespace std;
-using namespace std::tr1;
+using namespace CodeView;
 
-PDB::PDB(const wchar_t* exeFilename)
+typedef struct
 {
-	DWORD	tmpDwordValue;
-	LONG	tmpLongValue;
+	int				versionSignature;
+	unsigned int	versionHeader;
+	unsigned int	age;
+	unsigned short	globalStreamIndex;
+	unsigned short	buildNumber;
+	unsigned short	publicStreamIndex;
+	unsigned short	pdbDllVersion;
+	unsigned short	symRecordStream;
+	unsigned short	pdbDllRbld;
+	int				modInfoSize;
+	int				sectionContributionSize;
+	int				sectionMapSize;
+	int				sourceInfoSize;
+	int				typeServerMapSize;
+	unsigned int	mfcTypeServerIndex;
+	int				optionalDbgHeaderSize;
+	int				ecSubstreamSize;
+	unsigned short	flags;
+	unsigned short	machine;
+	unsigned int	padding;
+} DBIHeader;
+
+static const unsigned short NoModuleStream = 0xFFFF;
+
+static shared_ptr<MSF>	OpenMatchingPDB(const CodeViewInfo& cvInfo, const wchar_t* exeFilename);
+static unsigned long	GetProcParamCount(const TypeStream& tpi, const TypeStream& ipi, unsigned long typeIndex, bool bIdRecord);
+static CV_HREG_e		DecodeFrameRegister(unsigned long encodedReg, bool bIs64Bit);
+static Variable			MakeVariable(TypeTable& types, unsigned long typeIndex, const string& name);
+
+PDB::PDB(const PE& pe, const wchar_t* exeFilename, const wstring& cacheDir)
+	: m_bNameIndexBuilt(false)
+{
+	PhaseTimer timer(PhasePDBLoad);
 
-	HRESULT hr = CoInitialize(NULL);
+	CodeViewInfo cvInfo;
 
-	if(hr != S_OK) {
-		throw runtime_error("Unable to initialize COM interface.");
+	if(!pe.getCodeViewInfo(cvInfo)) {
+		throw runtime_error("Unable to find PDB information in given EXE.");
 	}
 
-	CComPtr<IDiaDataSource> dataSrc;
-
-	hr = CoCreateInstance(CLSID_DiaSource,
-					NULL,
-					CLSCTX_INPROC_SERVER,
-					__uuidof(IDiaDataSource),
-					(void**)&dataSrc);
-	
-	if(hr != S_OK) {
-		throw runtime_error("Unable to create IDiaDataSource interface.");
-	}
+	if(cacheDir.empty()) {
+		ReadPDB(pe, cvInfo, exeFilename);
+	} else {
+		SymbolCache cache(cacheDir, cvInfo, pe.getTimeDateStamp());
 
-	hr = dataSrc->loadDataForExe(exeFilename, NULL, NULL);
+		if(!cache.Load(m_functions, m_types)) {
+			ReadPDB(pe, cvInfo, exeFilename);
 
-	if(hr != S_OK) {
-		throw runtime_error("Unable to load PDB for given EXE.");
+			// if the cache can't be written the next run just reads the PDB again
+			cache.Save(m_functions, *m_types);
+		}
 	}
 
-	CComPtr<IDiaSession> session;
+	BuildAddressIndex();
+}
 
-	hr = dataSrc->openSession(&session);
+void PDB::ReadPDB(const PE& pe, const CodeViewInfo& cvInfo, const wchar_t* exeFilename)
+{
+	shared_ptr<MSF> msf = OpenMatchingPDB(cvInfo, exeFilename);
 
-	if(hr != S_OK) {
-		throw runtime_error("Unable to create IDiaSession.");
+	if(!msf) {
+		throw runtime_error("Unable to load PDB for given EXE.");
 	}
 
-	CComPtr<IDiaSymbol> globalScope;
+	// the type table keeps the TPI stream so types can be read later
+	shared_ptr<TypeStream> tpi(new TypeStream(*msf, TPIStream));
+	TypeStream ipi(*msf, IPIStream);
 
-	hr = session->get_globalScope(&globalScope);
+	m_types = shared_ptr<TypeTable>(new TypeTable(tpi));
 
-	if(hr != S_OK) {
-		throw runtime_error("Unable to get PDB's global scope.");
-	}
+	vector<unsigned char> dbi;
 
-	CComPtr<IDiaEnumSymbols> compilands;
+	if(!msf->ReadStream(DBIStream, dbi) || dbi.size() < sizeof(DBIHeader)) {
+		throw runtime_error("Unable to find PDB's compilands.");
+	}
 
-	hr = globalScope->findChildren(SymTagCompiland, NULL, NULL, &compilands);
+	DBIHeader dbiHeader;
+	memcpy(&dbiHeader, &dbi[0], sizeof(dbiHeader));
 
-	if(hr != S_OK) {
+	if(dbiHeader.versionSignature != -1 || dbiHeader.modInfoSize < 0 ||
+		static_cast<size_t>(dbiHeader.modInfoSize) > dbi.size() - sizeof(DBIHeader)) {
 		throw runtime_error("Unable to find PDB's compilands.");
 	}
 
-	CComPtr<IDiaSymbol> currCompiland;
-	DWORD numSymbolsFetched;
+	BinaryReader modInfo(&dbi[0] + sizeof(DBIHeader), dbiHeader.modInfoSize);
+	vector<unsigned char> symbols;
 
-	for(HRESULT moreChildren = compilands->Next(1, &currCompiland, &numSymbolsFetched);
-		moreChildren == S_OK; moreChildren = compilands->Next(1, &currCompiland, &numSymbolsFetched))	{
+	while(modInfo.Remaining() >= 64) {
+		// unused field, section contribution and module flags
+		modInfo.Skip(4 + 28 + 2);
 
-			BSTR pName;
-			hr = currCompiland->get_name(&pName);
+		unsigned short	moduleSymStream	= modInfo.Read<unsigned short>();
+		unsigned long	symByteSize		= modInfo.Read<unsigned int>();
 
-			wstring compilandName;
+		// C11/C13 line info sizes, source file count and name indices
+		modInfo.Skip(4 + 4 + 2 + 2 + 4 + 4 + 4);
 
-			if(hr == S_OK) {
-				compilandName = pName;
-				SysFreeString(pName);
-			} else {
-				compilandName = L"UnnamedCompiland";
-			}
+		string moduleName = modInfo.ReadCString();
+		modInfo.ReadCString();
+		modInfo.Align(4);
 
-			CComPtr<IDiaEnumSymbols>	functions;
-			CComPtr<IDiaSymbol>			currFunction;
+		wstring compilandName;
 
-			hr = currCompiland->findChildren(SymTagFunction, NULL, NULL, &functions);
+		if(!moduleName.empty()) {
+			compilandName = Utf8ToWide(moduleName);
+		} else {
+			compilandName = L"UnnamedCompiland";
+		}
 
-			if(hr != S_OK) {
-				currCompiland.Release();
-				continue;
-			}
+		if(moduleSymStream == NoModuleStream || !msf->ReadStream(moduleSymStream, symbols)) {
+			continue;
+		}
+
+		if(symByteSize > symbols.size())
+			symByteSize = static_cast<unsigned long>(symbols.size());
 
-			for(HRESULT moreFuncs = functions->Next(1, &currFunction, &numSymbolsFetched);
-				moreFuncs == S_OK; moreFuncs = functions->Next(1, &currFunction, &numSymbolsFetched)) {
+		if(symByteSize < sizeof(unsigned int))
+			continue;
 
-					Function stCurrFunction;
+		BinaryReader reader(&symbols[0], symByteSize);
 
-					stCurrFunction.compiland = compilandName;
+		if(reader.Read<unsigned int>() != ModuleSymbolSignature)
+			continue;
 
-					hr = currFunction->get_name(&pName);
+		ReadModuleSymbols(reader, compilandName, pe, *tpi, ipi);
+	}
+}
 
-					if(hr == S_OK) {
-						stCurrFunction.name = pName;
-						SysFreeString(pName);
+void PDB::ReadModuleSymbols(BinaryReader& reader, const wstring& compilandName, const PE& pe, const TypeStream& tpi, const TypeStream& ipi)
+{
+	vector<unsigned short>	scopes;
+	size_t					procScopeDepth = 0;
+	bool					bInFunction = false;
+	Function				stCurrFunction;
+
+	unsigned long			paramsRemaining = 0;
+	CV_HREG_e				localFrameReg = CV_REG_NONE;
+	CV_HREG_e				paramFrameReg = CV_REG_NONE;
+
+	Variable				pendingLocal;
+	bool					bHavePendingLocal = false;
+	bool					bPendingIsParam = false;
+
+	while(reader.Remaining() >= 2 * sizeof(unsigned short)) {
+		unsigned short recordLength = reader.Read<unsigned short>();
+
+		if(recordLength < sizeof(unsigned short) || recordLength > reader.Remaining())
+			break;
+
+		BinaryReader record(reader.Current(), recordLength);
+		reader.Skip(recordLength);
+
+		unsigned short kind = record.Read<unsigned short>();
+
+		// an S_LOCAL's location comes from the S_DEFRANGE records right after it
+		if(bHavePendingLocal && (kind < S_DEFRANGE || kind > S_DEFRANGE_REGISTER_REL)) {
+			if(pendingLocal.location != UnknownLocation) {
+				if(bPendingIsParam) {
+					stCurrFunction.parameters.push_back(pendingLocal);
+				} else {
+					stCurrFunction.localVariables.push_back(pendingLocal);
+				}
+			}
+
+			bHavePendingLocal = false;
+		}
+
+		switch(kind) {
+			case S_GPROC32:
+			case S_LPROC32:
+			case S_GPROC32_ID:
+			case S_LPROC32_ID:
+			case S_LPROC32_DPC:
+			case S_LPROC32_DPC_ID: {
+				scopes.push_back(kind);
+
+				if(bInFunction)
+					break;
+
+				// parent, end and next pointers
+				record.Skip(3 * sizeof(unsigned int));
+
+				unsigned long	length = record.Read<unsigned int>();
+				record.Skip(2 * sizeof(unsigned int));
+				unsigned long	typeIndex = record.Read<unsigned int>();
+				unsigned long	offset = record.Read<unsigned int>();
+				unsigned short	section = record.Read<unsigned short>();
+				record.Skip(sizeof(unsigned char));
+				string			name = record.ReadCString();
+
+				unsigned long rva;
+
+				// if we can't get the function's address,
+				// then we can't use it.
+				if(!pe.getRVAForSectionOffset(section, offset, rva))
+					break;
+
+				stCurrFunction = Function();
+				stCurrFunction.compiland = compilandName;
+				stCurrFunction.address = rva;
+				stCurrFunction.length = length;
+
+				if(!name.empty()) {
+					stCurrFunction.name = Utf8ToWide(name);
+				} else {
+					stCurrFunction.name = L"UnnamedFunction";
+				}
+
+				bool bIdRecord = kind == S_GPROC32_ID || kind == S_LPROC32_ID || kind == S_LPROC32_DPC_ID;
+
+				paramsRemaining = GetProcParamCount(tpi, ipi, typeIndex, bIdRecord);
+				localFrameReg = paramFrameReg = CV_REG_NONE;
+				procScopeDepth = scopes.size();
+				bInFunction = true;
+				break;
+			}
+			case S_THUNK32:
+			case S_BLOCK32:
+			case S_WITH32:
+			case S_SEPCODE:
+			case S_INLINESITE:
+				scopes.push_back(kind);
+				break;
+			case S_END:
+			case S_PROC_ID_END:
+			case S_INLINESITE_END:
+				if(scopes.empty())
+					break;
+
+				if(bInFunction && scopes.size() == procScopeDepth) {
+					m_functions.push_back(stCurrFunction);
+					bInFunction = false;
+				}
+
+				scopes.pop_back();
+				break;
+			default: {
+				// only data directly in the function's scope,
+				// not nested blocks or inlined call sites
+				if(!bInFunction || scopes.size() != procScopeDepth)
+					break;
+
+				Variable	currVar;
+				bool		bIsParam = false;
+
+				if(kind == S_FRAMEPROC) {
+					record.Skip(5 * sizeof(unsigned int) + sizeof(unsigned short));
+
+					unsigned long flags = record.Read<unsigned int>();
+
+					localFrameReg = DecodeFrameRegister((flags >> 14) & 3, pe.Is64Bit());
+					paramFrameReg = DecodeFrameRegister((flags >> 16) & 3, pe.Is64Bit());
+					break;
+				} else if(kind == S_BPREL32) {
+					long			offset = record.Read<int>();
+					unsigned long	typeIndex = record.Read<unsigned int>();
+
+					currVar = MakeVariable(*m_types, typeIndex, record.ReadCString());
+					currVar.location = RegisterRelative;
+					currVar.eRegister = pe.Is64Bit() ? CV_AMD64_RBP : CV_REG_EBP;
+					currVar.offset = static_cast<long long>(offset);
+				} else if(kind == S_REGREL32) {
+					long			offset = record.Read<int>();
+					unsigned long	typeIndex = record.Read<unsigned int>();
+					unsigned short	reg = record.Read<unsigned short>();
+
+					currVar = MakeVariable(*m_types, typeIndex, record.ReadCString());
+					currVar.location = RegisterRelative;
+					currVar.eRegister = static_cast<CV_HREG_e>(reg);
+					currVar.offset = static_cast<long long>(offset);
+				} else if(kind == S_REGISTER) {
+					unsigned long	typeIndex = record.Read<unsigned int>();
+					unsigned short	reg = record.Read<unsigned short>();
+
+					currVar = MakeVariable(*m_types, typeIndex, record.ReadCString());
+					currVar.location = ValueInRegister;
+					currVar.eRegister = static_cast<CV_HREG_e>(reg);
+				} else if(kind == S_LDATA32 || kind == S_GDATA32) {
+					unsigned long	typeIndex = record.Read<unsigned int>();
+					unsigned long	offset = record.Read<unsigned int>();
+					unsigned short	section = record.Read<unsigned short>();
+					unsigned long	rva;
+
+					currVar = MakeVariable(*m_types, typeIndex, record.ReadCString());
+
+					if(pe.getRVAForSectionOffset(section, offset, rva)) {
+						currVar.location = StaticRVA;
+						currVar.offset = static_cast<long long>(rva);
 					} else {
-						stCurrFunction.name = L"UnnamedFunction";
-					}					
-
-					hr = currFunction->get_relativeVirtualAddress(&stCurrFunction.address);
-
-					// if we can't get the function's address,
-					// then we can't use it.
-					// Of course its possible it has a different
-					// location type stored for it, which
-					// can be looked into later. But one way or
-					// another we need an address.
-					if(hr != S_OK) {
-						currFunction.Release();
-						continue;
+						currVar.location = StaticSectionOffset;
+						currVar.offset = static_cast<long long>(offset);
+						currVar.section = section;
 					}
 
-					hr = currFunction->get_length(&stCurrFunction.length);
-
-					if(hr != S_OK) {
-						currFunction.Release();
-						continue;
+					// static locals are never parameters
+					stCurrFunction.localVariables.push_back(currVar);
+					break;
+				} else if(kind == S_LOCAL) {
+					unsigned long	typeIndex = record.Read<unsigned int>();
+					unsigned short	flags = record.Read<unsigned short>();
+
+					if(flags & LocalIsOptimizedOut)
+						break;
+
+					pendingLocal = MakeVariable(*m_types, typeIndex, record.ReadCString());
+					bPendingIsParam = (flags & LocalIsParam) != 0;
+					bHavePendingLocal = true;
+					break;
+				} else if(kind >= S_DEFRANGE && kind <= S_DEFRANGE_REGISTER_REL) {
+					// the first range describing the local is the one we report
+					if(!bHavePendingLocal || pendingLocal.location != UnknownLocation)
+						break;
+
+					if(kind == S_DEFRANGE_REGISTER) {
+						pendingLocal.location = ValueInRegister;
+						pendingLocal.eRegister = static_cast<CV_HREG_e>(record.Read<unsigned short>());
+					} else if(kind == S_DEFRANGE_REGISTER_REL) {
+						pendingLocal.eRegister = static_cast<CV_HREG_e>(record.Read<unsigned short>());
+						record.Skip(sizeof(unsigned short));
+						pendingLocal.offset = static_cast<long long>(record.Read<int>());
+						pendingLocal.location = RegisterRelative;
+					} else if(	kind == S_DEFRANGE_FRAMEPOINTER_REL ||
+								kind == S_DEFRANGE_FRAMEPOINTER_REL_FULL_SCOPE) {
+						CV_HREG_e frameReg = bPendingIsParam ? paramFrameReg : localFrameReg;
+
+						if(frameReg != CV_REG_NONE) {
+							pendingLocal.eRegister = frameReg;
+							pendingLocal.offset = static_cast<long long>(record.Read<int>());
+							pendingLocal.location = RegisterRelative;
+						}
 					}
+					break;
+				} else {
+					break;
+				}
+
+				// the function type gives us how many of the
+				// leading data records are its parameters
+				if(paramsRemaining) {
+					bIsParam = true;
+					--paramsRemaining;
+				}
+
+				if(bIsParam) {
+					stCurrFunction.parameters.push_back(currVar);
+				} else {
+					stCurrFunction.localVariables.push_back(currVar);
+				}
+				break;
+			}
+		}
+	}
+}
 
-					CComPtr<IDiaEnumSymbols>	funcData;
-					CComPtr<IDiaSymbol>			currFuncDatum;
+bool PDB::FindFunction(unsigned long long address, Function &func) const
+{
+	const Function* found = FindFunction(address);
 
-					hr = currFunction->findChildren(SymTagData, NULL, NULL, &funcData);
+	if(!found)
+		return false;
 
-					if(hr != S_OK) {
-						currFunction.Release();
-						continue;
-					}
+	func = *found;
+	return true;
+}
 
-					for(HRESULT moreData = funcData->Next(1, &currFuncDatum, &numSymbolsFetched);
-						moreData == S_OK; moreData = funcData->Next(1, &currFuncDatum, &numSymbolsFetched)) {
+const Function* PDB::FindFunction(unsigned long long address) const
+{
+	size_t numFunctions = m_sortedStarts.size();
 
-							Variable currVar;
+	if(!numFunctions || address < m_sortedStarts[0])
+		return 0;
 
-							currVar.location = UnknownLocation;
-							currVar.offset = 0;
-							currVar.section = 0;
-							currVar.szSize = 0;
-							currVar.eRegister = CV_REG_NONE;
+	// branchless binary search for the last start <= address,
+	// the ternary compiles down to a conditional move
+	const unsigned long* base = &m_sortedStarts[0];
 
-							hr = currFuncDatum->get_name(&pName);
+	while(numFunctions > 1) {
+		size_t half = numFunctions / 2;
+		base = (base[half] <= address) ? base + half : base;
+		numFunctions -= half;
+	}
 
-							if(hr == S_OK && pName && *pName) {
-								currVar.name = pName;
-								SysFreeString(pName);
-							} else {
-								currVar.name = L"NoName";
-							}
+	size_t index = base - &m_sortedStarts[0];
 
-							CComPtr<IDiaSymbol> datumType;
-							hr = currFuncDatum->get_type(&datumType);
-				
-							if(hr == S_OK)
-								currVar.type = shared_ptr<Type>(new Type(datumType));
-							else
-								currVar.type = 0;
+	if(address >= m_sortedEnds[index])
+		return 0;
 
-							enum LocationType locType;
-							hr = currFuncDatum->get_locationType(&tmpDwordValue);
+	return &m_functions[m_sortedFunctions[index]];
+}
 
-							if(hr == S_OK) { 
-								locType = *((LocationType*)&tmpDwordValue);
-							} else {
-								locType = LocIsNull;
-							}
+void PDB::FindFunctions(const vector<unsigned long long>& sortedAddresses, vector<const Function*>& results) const
+{
+	results.assign(sortedAddresses.size(), static_cast<const Function*>(0));
 
-							currVar.location = UnknownLocation;
+	size_t numFunctions = m_sortedStarts.size();
 
-							if(locType == LocIsRegRel) {
-								if(	currFuncDatum->get_registerId(&tmpDwordValue) == S_OK &&
-									currFuncDatum->get_offset(&tmpLongValue) == S_OK ) {
+	if(!numFunctions)
+		return;
 
-										currVar.location = RegisterRelative;
-										currVar.eRegister = static_cast<CV_HREG_e>(tmpDwordValue);
-										currVar.offset = static_cast<long long>(tmpLongValue);
+	// walk both sorted lists together, so the whole batch
+	// costs one pass over the addresses and the index
+	size_t index = 0;
 
-								}
-							} else if(locType == LocIsStatic) {
-								if(			currFuncDatum->get_relativeVirtualAddress(&tmpDwordValue) == S_OK) {
+	for(size_t i = 0, i_end = sortedAddresses.size(); i < i_end; ++i) {
+		unsigned long long address = sortedAddresses[i];
 
-												currVar.offset = static_cast<long long>(tmpDwordValue);
-												currVar.location = StaticRVA;
+		while(index + 1 < numFunctions && m_sortedStarts[index + 1] <= address)
+			++index;
 
-								} else if(	currFuncDatum->get_addressOffset(&tmpDwordValue) == S_OK &&
-											currFuncDatum->get_addressSection(&currVar.section) == S_OK) {
+		if(m_sortedStarts[index] <= address && address < m_sortedEnds[index])
+			results[i] = &m_functions[m_sortedFunctions[index]];
+	}
+}
 
-												currVar.offset = static_cast<long long>(tmpDwordValue);
-												currVar.location = StaticSectionOffset;
+const std::vector<Function>& PDB::GetFunctions() const
+{
+	return m_functions;
+}
 
-								}
-							} else if(locType == LocIsThisRel) {
+void PDB::FindFunctionsByPrefix(const wstring& prefix, vector<size_t>& indices) const
+{
+	{
+		lock_guard<mutex> lock(m_nameIndexLock);
 
-								if(currFuncDatum->get_offset(&tmpLongValue) == S_OK) {
-									currVar.offset = static_cast<long long>(tmpLongValue);
-									currVar.location = MemberVariable;
-								}
-							} else if(locType == LocIsEnregistered) {
+		if(!m_bNameIndexBuilt) {
+			m_sortedNames.resize(m_functions.size());
 
-								if(currFuncDatum->get_registerId(&tmpDwordValue) == S_OK) {
-									currVar.location = ValueInRegister;
-									currVar.eRegister = static_cast<CV_HREG_e>(tmpDwordValue);
-								}
-							} else if(locType == LocIsBitField) {
+			for(size_t i = 0, i_end = m_sortedNames.size(); i < i_end; ++i)
+				m_sortedNames[i] = i;
 
-								if(	currFuncDatum->get_offset(&tmpLongValue)			== S_OK &&
-									currFuncDatum->get_bitPosition(&currVar.section)	== S_OK &&
-									currFuncDatum->get_length(&currVar.szSize)			== S_OK ) {
+			sort(m_sortedNames.begin(), m_sortedNames.end(), [this](size_t a, size_t b) {
+				return m_functions[a].name < m_functions[b].name;
+			});
 
-										currVar.location = InBitfield;
-										currVar.offset = static_cast<long long>(tmpLongValue);
-										
-								}
-							}
+			m_bNameIndexBuilt = true;
+		}
+	}
 
-							if(currVar.location == UnknownLocation) {
-								continue;
-							}
+	// every name with the prefix sorts at or after it, and they're all together
+	vector<size_t>::const_iterator i = lower_bound(m_sortedNames.begin(), m_sortedNames.end(), prefix, [this](size_t funcNum, const wstring& key) {
+		return m_functions[funcNum].name < key;
+	});
 
-							enum DataKind funcDatumKind;
-							hr = currFuncDatum->get_dataKind(&tmpDwordValue);
-							funcDatumKind = static_cast<DataKind>(tmpDwordValue);
+	for(vector<size_t>::const_iterator i_end = m_sortedNames.end(); i != i_end; ++i) {
+		if(m_functions[*i].name.compare(0, prefix.length(), prefix) != 0)
+			break;
 
-							if(hr == S_OK) {
+		indices.push_back(*i);
+	}
+}
 
-								if(funcDatumKind == DataIsParam) {	
-									
-									stCurrFunction.parameters.push_back(currVar);
+void PDB::FindFunctionsInRange(unsigned long long start, unsigned long long end, vector<size_t>& indices) const
+{
+	// functions starting before the range can still run into it
+	size_t index = lower_bound(m_sortedStarts.begin(), m_sortedStarts.end(), start) - m_sortedStarts.begin();
 
-								} else if(	funcDatumKind == DataIsLocal ||
-											funcDatumKind == DataIsStaticLocal	) {
+	while(index && m_sortedEnds[index - 1] > start)
+		--index;
 
-									stCurrFunction.localVariables.push_back(currVar);
-
-								} else {
-									continue;
-								}
-							} else {
-								continue;
-							}
+	for(size_t index_end = m_sortedStarts.size(); index < index_end && m_sortedStarts[index] < end; ++index) {
+		if(m_sortedEnds[index] > start)
+			indices.push_back(m_sortedFunctions[index]);
+	}
+}
 
-							currFuncDatum.Release();
-					}
+const TypeTable& PDB::GetTypes() const
+{
+	return *m_types;
+}
 
-					m_functions.push_back(stCurrFunction);
-					currFunction.Release();
-			}
+void PDB::BuildAddressIndex()
+{
+	vector<pair<unsigned long long, size_t>> order;
+	order.reserve(m_functions.size());
 
-			functions.Release();
-			currCompiland.Release();
-	}
+	// ties on the start address put the longest function last,
+	// which is the one the search lands on
+	for(size_t i = 0, i_end = m_functions.size(); i < i_end; ++i)
+		order.push_back(make_pair((static_cast<unsigned long long>(m_functions[i].address) << 32) | (m_functions[i].length & 0xFFFFFFFF), i));
 
-	compilands.Release();
-	globalScope.Release();
-	session.Release();
-	dataSrc.Release();
+	sort(order.begin(), order.end());
+
+	m_sortedStarts.resize(order.size());
+	m_sortedEnds.resize(order.size());
+	m_sortedFunctions.resize(order.size());
+
+	for(size_t i = 0, i_end = order.size(); i < i_end; ++i) {
+		const Function& func = m_functions[order[i].second];
+
+		m_sortedStarts[i] = func.address;
+		m_sortedEnds[i] = static_cast<unsigned long long>(func.address) + func.length;
+		m_sortedFunctions[i] = order[i].second;
+	}
 }
 
-bool PDB::FindFunction(unsigned long long address, Function &func)
+static shared_ptr<MSF> OpenMatchingPDB(const CodeViewInfo& cvInfo, const wchar_t* exeFilename)
 {
-	for(vector<Function>::const_iterator i = m_functions.begin(), i_end = m_functions.end();
+	vector<wstring> candidates;
+
+	wstring pdbPath = Utf8ToWide(cvInfo.pdbPath);
+	candidates.push_back(pdbPath);
+
+	// like DIA, fall back to looking next to the EXE
+	wstring exePath(exeFilename);
+	size_t exeDirEnd = exePath.find_last_of(L"\\/");
+	size_t pdbNameStart = pdbPath.find_last_of(L"\\/");
+
+	wstring pdbName = pdbNameStart == wstring::npos ? pdbPath : pdbPath.substr(pdbNameStart + 1);
+
+	if(exeDirEnd == wstring::npos) {
+		candidates.push_back(pdbName);
+	} else {
+		candidates.push_back(exePath.substr(0, exeDirEnd + 1) + pdbName);
+	}
+
+	vector<unsigned char> pdbInfo;
+
+	for(vector<wstring>::const_iterator i = candidates.begin(), i_end = candidates.end();
 		i != i_end; ++i) {
-			
-			if(i->address <= address && address <= i->address + i->length) {
-				func = *i;
-				return true;
+
+			shared_ptr<MSF> msf;
+
+			try {
+				msf = shared_ptr<MSF>(new MSF(*i));
+			} catch(const runtime_error&) {
+				continue;
 			}
+
+			// version, signature, age and GUID
+			if(!msf->ReadStream(PDBStream, pdbInfo) || pdbInfo.size() < 28)
+				continue;
+
+			unsigned int age;
+			memcpy(&age, &pdbInfo[8], sizeof(age));
+
+			if(age == cvInfo.age && memcmp(&pdbInfo[12], cvInfo.guid, sizeof(cvInfo.guid)) == 0)
+				return msf;
 	}
 
-	return false;
+	return shared_ptr<MSF>();
 }
 
-const std::vector<Function>& PDB::GetFunctions() const
+static unsigned long GetProcParamCount(const TypeStream& tpi, const TypeStream& ipi, unsigned long typeIndex, bool bIdRecord)
 {
-	return m_functions;
+	unsigned short	kind;
+	BinaryReader	reader;
+
+	// the _ID flavors of the proc records point into the IPI stream
+	if(bIdRecord) {
+		if(!ipi.GetRecord(typeIndex, kind, reader) || (kind != LF_FUNC_ID && kind != LF_MFUNC_ID))
+			return 0;
+
+		reader.Skip(sizeof(unsigned int));
+		typeIndex = reader.Read<unsigned int>();
+	}
+
+	if(!tpi.GetRecord(typeIndex, kind, reader))
+		return 0;
+
+	if(kind == LF_PROCEDURE) {
+		// return type, calling convention and attributes
+		reader.Skip(sizeof(unsigned int) + 2);
+		return reader.Read<unsigned short>();
+	} else if(kind == LF_MFUNCTION) {
+		// return type and class type
+		reader.Skip(2 * sizeof(unsigned int));
+
+		unsigned long thisType = reader.Read<unsigned int>();
+		reader.Skip(2);
+
+		return reader.Read<unsigned short>() + (thisType ? 1 : 0);
+	}
+
+	return 0;
+}
+
+static CV_HREG_e DecodeFrameRegister(unsigned long encodedReg, bool bIs64Bit)
+{
+	if(bIs64Bit) {
+		if(encodedReg == 1) {
+			return CV_AMD64_RSP;
+		} else if(encodedReg == 2) {
+			return CV_AMD64_RBP;
+		} else if(encodedReg == 3) {
+			return CV_AMD64_R13;
+		}
+	} else {
+		// 1 is the virtual frame, which has no real register
+		if(encodedReg == 2) {
+			return CV_REG_EBP;
+		} else if(encodedReg == 3) {
+			return CV_REG_EBX;
+		}
+	}
+
+	return CV_REG_NONE;
+}
+
+static Variable MakeVariable(TypeTable& types, unsigned long typeIndex, const string& name)
+{
+	Variable currVar;
+
+	currVar.location = UnknownLocation;
+	currVar.offset = 0;
+	currVar.section = 0;
+	currVar.szSize = 0;
+	currVar.eRegister = CV_REG_NONE;
+
+	if(!name.empty()) {
+		currVar.name = Utf8ToWide(name);
+	} else {
+		currVar.name = L"NoName";
+	}
+
+	if(typeIndex)
+		currVar.type = types.Intern(typeIndex);
+	else
+		currVar.type = InvalidTypeId;
+
+	return currVar;
 }
\ No newline at end of file
@@ -2,10 +2,15 @@
 #define __PDB_H__
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
-#include "Type.h"
+#include "PE.h"
+#include "TypeTable.h"
+
+class BinaryReader;
+class TypeStream;
 
 enum VariableLocation
 {
@@ -27,7 +32,7 @@ typedef struct
 	unsigned long long			szSize;
 	//VARIANT*					value;
 	CV_HREG_e					eRegister;
-	std::tr1::shared_ptr<Type>	type;
+	TypeId						type;
 	std::wstring				name;
 } Variable;
 
@@ -46,14 +51,37 @@ typedef struct
 class PDB
 {
 public:
-	PDB(const wchar_t* exeFilename);
+	PDB(const PE& pe, const wchar_t* exeFilename, const std::wstring& cacheDir = std::wstring());
 
-	bool							FindFunction(unsigned long long address, Function& func);
-	bool							FindFunction(unsigned long long address, const Function& func) const;
+	bool							FindFunction(unsigned long long address, Function& func) const;
+	const Function*					FindFunction(unsigned long long address) const;
+	void							FindFunctions(const std::vector<unsigned long long>& sortedAddresses, std::vector<const Function*>& results) const;
 	const std::vector<Function>&	GetFunctions() const;
+	const TypeTable&				GetTypes() const;
+
+	// both append indices into GetFunctions(); the name lookup
+	// builds a sorted name index the first time it's asked
+	void							FindFunctionsByPrefix(const std::wstring& prefix, std::vector<size_t>& indices) const;
+	void							FindFunctionsInRange(unsigned long long start, unsigned long long end, std::vector<size_t>& indices) const;
 
 private:
+	void							ReadPDB(const PE& pe, const CodeViewInfo& cvInfo, const wchar_t* exeFilename);
+	void							ReadModuleSymbols(BinaryReader& reader, const std::wstring& compilandName, const PE& pe, const TypeStream& tpi, const TypeStream& ipi);
+	void							BuildAddressIndex();
+
 	std::vector<Function>			m_functions;
+	std::shared_ptr<TypeTable>	m_types;
+
+	// functions ordered by RVA, kept as packed parallel arrays
+	// so the lookup only ever touches the start addresses
+	std::vector<unsigned long>		m_sortedStarts;
+	std::vector<unsigned long long>	m_sortedEnds;
+	std::vector<size_t>				m_sortedFunctions;
+
+	// functions ordered by name, only built for name lookups
+	mutable std::mutex				m_nameIndexLock;
+	mutable bool					m_bNameIndexBuilt;
+	mutable std::vector<size_t>		m_sortedNames;
 };
 
 #endif
\ No newline at end of file
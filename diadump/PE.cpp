@@ -1,36 +1,41 @@
+#include <algorithm>
 #include <memory>
-#include <fstream>
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <WinNT.h>
 #include <stdexcept>
+#include <string.h>
+#include "BinaryReader.h"
+#include "Stats.h"
 #include "Utility.h"
 #include "PE.h"
 
 using namespace std;
 
+static bool SectionRangeLess(const SectionRange& a, const SectionRange& b)
+{
+	return a.rvaStart < b.rvaStart;
+}
+
 PE::PE(const wstring& peFilename)
+	: m_lastSectionHit(0), m_image(new MappedFile(peFilename))
 {
-	ifstream fp(peFilename.c_str(), ios::in | ios::binary);
+	PhaseTimer timer(PhasePELoad);
 
-	if(!fp) {
-		throw runtime_error("Unable to open PE file");
-	}
+	BinaryReader fp(m_image->GetData(), m_image->GetSize());
 
-	fp.read(reinterpret_cast<char*>(&m_dosHeader), sizeof(IMAGE_DOS_HEADER));
+	fp.ReadBytes(&m_dosHeader, sizeof(IMAGE_DOS_HEADER));
 
 	if(m_dosHeader.e_magic != IMAGE_DOS_SIGNATURE)
 		throw runtime_error("Invalid PE file. DOS Header signature invalid.");
 
-	fp.seekg(m_dosHeader.e_lfanew, ios::beg);
+	fp.Seek(m_dosHeader.e_lfanew);
 	
-	DWORD	dwPESignature;
-	fp.read(reinterpret_cast<char*>(&dwPESignature), sizeof(DWORD));
+	DWORD	dwPESignature = fp.Read<DWORD>();
 	
 	if(dwPESignature != IMAGE_NT_SIGNATURE)
 		throw runtime_error("Invalid PE file. PE signature invalid.");
 
-	fp.read(reinterpret_cast<char*>(&m_fileHeader), sizeof(IMAGE_FILE_HEADER));
+	fp.ReadBytes(&m_fileHeader, sizeof(IMAGE_FILE_HEADER));
+
+	size_t optionalHeaderOffset = fp.Tell();
 
 	if(m_fileHeader.Machine != IMAGE_FILE_MACHINE_AMD64 &&
 		m_fileHeader.Machine != IMAGE_FILE_MACHINE_I386) {
@@ -40,10 +45,10 @@ PE::PE(const wstring& peFilename)
 	m_bIs64Bit = m_fileHeader.Machine == IMAGE_FILE_MACHINE_AMD64;
 
 	if(m_fileHeader.SizeOfOptionalHeader == sizeof(IMAGE_OPTIONAL_HEADER64)) {
-		fp.read(reinterpret_cast<char*>(&m_optionalHeader), sizeof(IMAGE_OPTIONAL_HEADER64));
+		fp.ReadBytes(&m_optionalHeader, sizeof(IMAGE_OPTIONAL_HEADER64));
 	} else {
 		IMAGE_OPTIONAL_HEADER32 tmpOptionalHeader32;
-		fp.read(reinterpret_cast<char*>(&tmpOptionalHeader32), sizeof(IMAGE_OPTIONAL_HEADER32));
+		fp.ReadBytes(&tmpOptionalHeader32, sizeof(IMAGE_OPTIONAL_HEADER32));
 
 		// move over all of the optional header fields to the 64-bit version
 		m_optionalHeader.Magic							= tmpOptionalHeader32.Magic;
@@ -80,54 +85,224 @@ PE::PE(const wstring& peFilename)
 				reinterpret_cast<void*>(&tmpOptionalHeader32.DataDirectory), sizeof(tmpOptionalHeader32.DataDirectory));
 	}
 
+	// section headers follow the optional header, whatever size it claims to be
+	fp.Seek(optionalHeaderOffset + m_fileHeader.SizeOfOptionalHeader);
+
 	IMAGE_SECTION_HEADER peSectionHeader;
 
 	for(WORD sectionNum = 0; sectionNum < m_fileHeader.NumberOfSections; ++sectionNum) {
-		fp.read(reinterpret_cast<char*>(&peSectionHeader), sizeof(peSectionHeader));
+		fp.ReadBytes(&peSectionHeader, sizeof(peSectionHeader));
 		m_sections.push_back(PESection(peSectionHeader));
 	}
 
-	m_startOfSectionsOffset = fp.tellg();
-	fp.seekg(0, ios::end);
-	std::streamoff endOfSectionsOffset = fp.tellg();
+	BuildSectionMap();
+}
+
+void PE::BuildSectionMap()
+{
+	size_t imageSize = m_image->GetSize();
+
+	for(size_t sectionIndex = 0, sectionIndex_end = m_sections.size(); sectionIndex < sectionIndex_end; ++sectionIndex) {
+		const IMAGE_SECTION_HEADER& sectHeader = m_sections[sectionIndex].getSectionHeader();
+
+		SectionRange range;
+
+		// some linkers leave VirtualSize zeroed, the raw size is all we have then
+		unsigned long virtualSize = sectHeader.Misc.VirtualSize ? sectHeader.Misc.VirtualSize : sectHeader.SizeOfRawData;
+
+		range.rvaStart = sectHeader.VirtualAddress;
+		range.rvaEnd = range.rvaStart + virtualSize;
+		range.rawOffset = sectHeader.PointerToRawData;
+		range.rawSize = 0;
+		range.sectionIndex = sectionIndex;
+
+		if(sectHeader.PointerToRawData && sectHeader.PointerToRawData < imageSize) {
+			range.rawSize = sectHeader.SizeOfRawData;
+
+			if(range.rawSize > imageSize - sectHeader.PointerToRawData)
+				range.rawSize = static_cast<unsigned long>(imageSize - sectHeader.PointerToRawData);
+
+			if(range.rawSize > virtualSize)
+				range.rawSize = virtualSize;
+		}
+
+		if(range.rvaEnd > range.rvaStart)
+			m_sectionMap.push_back(range);
+	}
+
+	sort(m_sectionMap.begin(), m_sectionMap.end(), SectionRangeLess);
+}
+
+const SectionRange* PE::FindSectionRange(unsigned long long rva) const
+{
+	if(m_sectionMap.empty())
+		return 0;
+
+	size_t lastHit = m_lastSectionHit.load(memory_order_relaxed);
+	const SectionRange& cached = m_sectionMap[lastHit];
+
+	if(cached.rvaStart <= rva && rva < cached.rvaEnd)
+		return &cached;
 
-	m_sectionsBuf = shared_ptr<unsigned char>(new unsigned char [endOfSectionsOffset - m_startOfSectionsOffset + 1], DeleteBuffer<unsigned char>);
+	// last section starting at or before the RVA
+	SectionRange key;
+	key.rvaStart = rva;
 
-	fp.seekg(m_startOfSectionsOffset, ios::beg);
-	fp.read((char*)m_sectionsBuf.get(), endOfSectionsOffset - m_startOfSectionsOffset + 1);
+	vector<SectionRange>::const_iterator i = upper_bound(m_sectionMap.begin(), m_sectionMap.end(), key, SectionRangeLess);
+
+	if(i == m_sectionMap.begin())
+		return 0;
+
+	--i;
+
+	if(rva >= i->rvaEnd)
+		return 0;
+
+	m_lastSectionHit.store(i - m_sectionMap.begin(), memory_order_relaxed);
+	return &*i;
 }
 
-unsigned long PE::getOffsetForRVA(const unsigned long long rva) const
+bool PE::getOffsetForRVA(const unsigned long long rva, unsigned long& offset) const
 {
-	for(std::vector<PESection>::const_iterator i = m_sections.begin(), i_end = m_sections.end();
-		i != i_end; ++i) {
-			const IMAGE_SECTION_HEADER& sectHeader = i->getSectionHeader();
+	const SectionRange* range = FindSectionRange(rva);
 
-			if(sectHeader.VirtualAddress <= rva && rva <= sectHeader.VirtualAddress + sectHeader.Misc.VirtualSize) {
-				if(sectHeader.PointerToRawData) {
-					return sectHeader.PointerToRawData + (rva - sectHeader.VirtualAddress) - m_startOfSectionsOffset;
-				} else {
-					return 0;
-				}
-			}
+	// uninitialized data has no bytes in the file to point at
+	if(!range || rva - range->rvaStart >= range->rawSize) {
+		offset = InvalidOffset;
+		return false;
 	}
 
-	return 0;
+	offset = static_cast<unsigned long>(range->rawOffset + (rva - range->rvaStart));
+	return true;
 }
 
-std::tr1::shared_ptr<const unsigned char> PE::getSectionsBuf() const
+size_t PE::getOffsetsForRVAs(const vector<unsigned long long>& rvas, vector<unsigned long>& offsets) const
 {
-	return m_sectionsBuf;
+	offsets.resize(rvas.size());
+
+	size_t				numTranslated = 0;
+	const SectionRange*	range = 0;
+
+	for(size_t i = 0, i_end = rvas.size(); i < i_end; ++i) {
+		unsigned long long rva = rvas[i];
+
+		// neighbouring RVAs nearly always share a section, only
+		// go back to the map when we walk out of the current one
+		if(!range || rva < range->rvaStart || rva >= range->rvaEnd)
+			range = FindSectionRange(rva);
+
+		if(!range || rva - range->rvaStart >= range->rawSize) {
+			offsets[i] = InvalidOffset;
+			continue;
+		}
+
+		offsets[i] = static_cast<unsigned long>(range->rawOffset + (rva - range->rvaStart));
+		++numTranslated;
+	}
+
+	return numTranslated;
 }
 
-std::tr1::shared_ptr<unsigned char> PE::getSectionsBuf()
+bool PE::getRVAForSectionOffset(unsigned short section, unsigned long offset, unsigned long& rva) const
 {
-	return m_sectionsBuf;
+	// CodeView section numbers are 1-based
+	if(section == 0 || section > m_sections.size())
+		return false;
+
+	rva = m_sections[section - 1].getSectionHeader().VirtualAddress + offset;
+	return true;
 }
 
-std::streamoff	PE::getStartOfSectionsOffset() const
+bool PE::getCodeViewInfo(CodeViewInfo& info) const
 {
-	return m_startOfSectionsOffset;
+	const IMAGE_DATA_DIRECTORY& debugDir = m_optionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
+
+	if(!debugDir.VirtualAddress || !debugDir.Size)
+		return false;
+
+	unsigned long debugDirOffset;
+
+	if(!getOffsetForRVA(debugDir.VirtualAddress, debugDirOffset) || debugDirOffset + debugDir.Size > m_image->GetSize())
+		return false;
+
+	const unsigned char* image = m_image->GetData();
+
+	for(unsigned long entryOffset = 0; entryOffset + sizeof(IMAGE_DEBUG_DIRECTORY) <= debugDir.Size; entryOffset += sizeof(IMAGE_DEBUG_DIRECTORY)) {
+		IMAGE_DEBUG_DIRECTORY entry;
+		memcpy_s(&entry, sizeof(entry), image + debugDirOffset + entryOffset, sizeof(entry));
+
+		if(entry.Type != IMAGE_DEBUG_TYPE_CODEVIEW)
+			continue;
+
+		// 'RSDS' + GUID + age + at least a terminating null
+		if(entry.SizeOfData < 25 || static_cast<unsigned long long>(entry.PointerToRawData) + entry.SizeOfData > m_image->GetSize())
+			continue;
+
+		const unsigned char* record = image + entry.PointerToRawData;
+
+		if(memcmp(record, "RSDS", 4) != 0)
+			continue;
+
+		memcpy_s(info.guid, sizeof(info.guid), record + 4, sizeof(info.guid));
+
+		unsigned int age;
+		memcpy_s(&age, sizeof(age), record + 20, sizeof(age));
+		info.age = age;
+
+		const char* path = reinterpret_cast<const char*>(record + 24);
+		info.pdbPath.assign(path, strnlen(path, entry.SizeOfData - 24));
+
+		return true;
+	}
+
+	return false;
+}
+
+ByteSpan PE::getImageData() const
+{
+	return m_image->GetSpan();
+}
+
+bool PE::getSectionData(size_t sectionIndex, ByteSpan& span) const
+{
+	if(sectionIndex >= m_sections.size())
+		return false;
+
+	const IMAGE_SECTION_HEADER& sectHeader = m_sections[sectionIndex].getSectionHeader();
+
+	// uninitialized data has nothing backing it in the file
+	if(!sectHeader.PointerToRawData || sectHeader.PointerToRawData >= m_image->GetSize())
+		return false;
+
+	span.data = m_image->GetData() + sectHeader.PointerToRawData;
+	span.size = m_image->GetSize() - sectHeader.PointerToRawData;
+
+	if(span.size > sectHeader.SizeOfRawData)
+		span.size = sectHeader.SizeOfRawData;
+
+	return span.size != 0;
+}
+
+bool PE::getRVARange(unsigned long long rva, unsigned long long length, ByteSpan& span) const
+{
+	const SectionRange* range = FindSectionRange(rva);
+
+	if(!range || rva - range->rvaStart >= range->rawSize)
+		return false;
+
+	// hand back whatever part of the range is actually in the file
+	span.data = m_image->GetData() + range->rawOffset + (rva - range->rvaStart);
+	span.size = static_cast<size_t>(range->rawSize - (rva - range->rvaStart));
+
+	if(span.size > length)
+		span.size = static_cast<size_t>(length);
+
+	return span.size != 0;
+}
+
+const vector<PESection>& PE::getSections() const
+{
+	return m_sections;
 }
 
 bool PE::Is64Bit() const
@@ -143,4 +318,9 @@ unsigned long PE::getEntryPoint() const
 unsigned long long PE::getImageBase() const
 {
 	return m_optionalHeader.ImageBase;
+}
+
+unsigned long PE::getTimeDateStamp() const
+{
+	return m_fileHeader.TimeDateStamp;
 }
\ No newline at end of file
@@ -1,33 +1,67 @@
 #ifndef __PE_H__
 #define __PE_H__
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "MappedFile.h"
 #include "PESection.h"
 
+// contents of the RSDS CodeView debug record pointing at the PDB
+typedef struct
+{
+	unsigned char		guid[16];
+	unsigned long		age;
+	std::string			pdbPath;
+} CodeViewInfo;
+
+// one section's RVA range and where its initialized bytes live in the file
+typedef struct
+{
+	unsigned long long	rvaStart;
+	unsigned long long	rvaEnd;
+	unsigned long		rawOffset;
+	unsigned long		rawSize;
+	size_t				sectionIndex;
+} SectionRange;
+
 class PE
 {
 public:
 	PE(const std::wstring& peFilename);
 
+	static const unsigned long					InvalidOffset = 0xFFFFFFFF;
+
 	unsigned long								getEntryPoint() const;
-	unsigned long								getOffsetForRVA(const unsigned long long rva) const;
-	std::streamoff								getStartOfSectionsOffset() const;
+	bool										getOffsetForRVA(const unsigned long long rva, unsigned long& offset) const;
+	size_t										getOffsetsForRVAs(const std::vector<unsigned long long>& rvas, std::vector<unsigned long>& offsets) const;
+	bool										getRVAForSectionOffset(unsigned short section, unsigned long offset, unsigned long& rva) const;
+	bool										getCodeViewInfo(CodeViewInfo& info) const;
 
-	std::tr1::shared_ptr<const unsigned char>	getSectionsBuf() const;
-	std::tr1::shared_ptr<unsigned char>			getSectionsBuf();
+	ByteSpan									getImageData() const;
+	bool										getSectionData(size_t sectionIndex, ByteSpan& span) const;
+	bool										getRVARange(unsigned long long rva, unsigned long long length, ByteSpan& span) const;
+	const std::vector<PESection>&				getSections() const;
 	
 	unsigned long long							getImageBase() const;
+	unsigned long								getTimeDateStamp() const;
 	bool										Is64Bit() const;
 
 private:
+	void								BuildSectionMap();
+	const SectionRange*					FindSectionRange(unsigned long long rva) const;
+
 	std::vector<std::wstring>			m_dllImports;
 	std::vector<PESection>				m_sections;
 
-	std::tr1::shared_ptr<unsigned char>	m_sectionsBuf;
-	std::streamoff						m_startOfSectionsOffset;
+	// sections sorted by RVA, plus the last one a lookup landed in
+	// since callers tend to ask about the same section over and over
+	std::vector<SectionRange>			m_sectionMap;
+	mutable std::atomic<size_t>			m_lastSectionHit;
+
+	std::shared_ptr<MappedFile>	m_image;
 
 	IMAGE_DOS_HEADER					m_dosHeader;
 	IMAGE_FILE_HEADER					m_fileHeader;
@@ -0,0 +1,218 @@
+#ifndef __PEFORMAT_H__
+#define __PEFORMAT_H__
+
+//
+//	The PE header layouts and constants. On Windows these come from
+//	WinNT.h; elsewhere the ones the PE reader and the synthetic image
+//	writer use are declared here with the same names and layout.
+//
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <WinNT.h>
+#else
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t		BYTE;
+typedef uint16_t	WORD;
+typedef uint32_t	DWORD;
+typedef int32_t		LONG;
+typedef uint64_t	ULONGLONG;
+
+#define IMAGE_DOS_SIGNATURE					0x5A4D
+#define IMAGE_NT_SIGNATURE					0x00004550
+#define IMAGE_FILE_MACHINE_I386				0x014C
+#define IMAGE_FILE_MACHINE_AMD64			0x8664
+#define IMAGE_FILE_EXECUTABLE_IMAGE			0x0002
+#define IMAGE_NT_OPTIONAL_HDR32_MAGIC		0x010B
+#define IMAGE_NT_OPTIONAL_HDR64_MAGIC		0x020B
+#define IMAGE_SUBSYSTEM_WINDOWS_CUI			3
+#define IMAGE_NUMBEROF_DIRECTORY_ENTRIES	16
+#define IMAGE_DIRECTORY_ENTRY_DEBUG			6
+#define IMAGE_DEBUG_TYPE_CODEVIEW			2
+#define IMAGE_SIZEOF_SHORT_NAME				8
+#define IMAGE_SCN_CNT_CODE					0x00000020
+#define IMAGE_SCN_CNT_INITIALIZED_DATA		0x00000040
+#define IMAGE_SCN_MEM_EXECUTE				0x20000000
+#define IMAGE_SCN_MEM_READ					0x40000000
+
+typedef struct
+{
+	WORD		e_magic;
+	WORD		e_cblp;
+	WORD		e_cp;
+	WORD		e_crlc;
+	WORD		e_cparhdr;
+	WORD		e_minalloc;
+	WORD		e_maxalloc;
+	WORD		e_ss;
+	WORD		e_sp;
+	WORD		e_csum;
+	WORD		e_ip;
+	WORD		e_cs;
+	WORD		e_lfarlc;
+	WORD		e_ovno;
+	WORD		e_res[4];
+	WORD		e_oemid;
+	WORD		e_oeminfo;
+	WORD		e_res2[10];
+	LONG		e_lfanew;
+} IMAGE_DOS_HEADER;
+
+typedef struct
+{
+	WORD		Machine;
+	WORD		NumberOfSections;
+	DWORD		TimeDateStamp;
+	DWORD		PointerToSymbolTable;
+	DWORD		NumberOfSymbols;
+	WORD		SizeOfOptionalHeader;
+	WORD		Characteristics;
+} IMAGE_FILE_HEADER;
+
+typedef struct
+{
+	DWORD		VirtualAddress;
+	DWORD		Size;
+} IMAGE_DATA_DIRECTORY;
+
+typedef struct
+{
+	WORD					Magic;
+	BYTE					MajorLinkerVersion;
+	BYTE					MinorLinkerVersion;
+	DWORD					SizeOfCode;
+	DWORD					SizeOfInitializedData;
+	DWORD					SizeOfUninitializedData;
+	DWORD					AddressOfEntryPoint;
+	DWORD					BaseOfCode;
+	DWORD					BaseOfData;
+	DWORD					ImageBase;
+	DWORD					SectionAlignment;
+	DWORD					FileAlignment;
+	WORD					MajorOperatingSystemVersion;
+	WORD					MinorOperatingSystemVersion;
+	WORD					MajorImageVersion;
+	WORD					MinorImageVersion;
+	WORD					MajorSubsystemVersion;
+	WORD					MinorSubsystemVersion;
+	DWORD					Win32VersionValue;
+	DWORD					SizeOfImage;
+	DWORD					SizeOfHeaders;
+	DWORD					CheckSum;
+	WORD					Subsystem;
+	WORD					DllCharacteristics;
+	DWORD					SizeOfStackReserve;
+	DWORD					SizeOfStackCommit;
+	DWORD					SizeOfHeapReserve;
+	DWORD					SizeOfHeapCommit;
+	DWORD					LoaderFlags;
+	DWORD					NumberOfRvaAndSizes;
+	IMAGE_DATA_DIRECTORY	DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+} IMAGE_OPTIONAL_HEADER32;
+
+typedef struct
+{
+	WORD					Magic;
+	BYTE					MajorLinkerVersion;
+	BYTE					MinorLinkerVersion;
+	DWORD					SizeOfCode;
+	DWORD					SizeOfInitializedData;
+	DWORD					SizeOfUninitializedData;
+	DWORD					AddressOfEntryPoint;
+	DWORD					BaseOfCode;
+	ULONGLONG				ImageBase;
+	DWORD					SectionAlignment;
+	DWORD					FileAlignment;
+	WORD					MajorOperatingSystemVersion;
+	WORD					MinorOperatingSystemVersion;
+	WORD					MajorImageVersion;
+	WORD					MinorImageVersion;
+	WORD					MajorSubsystemVersion;
+	WORD					MinorSubsystemVersion;
+	DWORD					Win32VersionValue;
+	DWORD					SizeOfImage;
+	DWORD					SizeOfHeaders;
+	DWORD					CheckSum;
+	WORD					Subsystem;
+	WORD					DllCharacteristics;
+	ULONGLONG				SizeOfStackReserve;
+	ULONGLONG				SizeOfStackCommit;
+	ULONGLONG				SizeOfHeapReserve;
+	ULONGLONG				SizeOfHeapCommit;
+	DWORD					LoaderFlags;
+	DWORD					NumberOfRvaAndSizes;
+	IMAGE_DATA_DIRECTORY	DataDirectory[IMAGE_NUMBEROF_DIRECTORY_ENTRIES];
+} IMAGE_OPTIONAL_HEADER64;
+
+typedef struct
+{
+	BYTE		Name[IMAGE_SIZEOF_SHORT_NAME];
+	union
+	{
+		DWORD	PhysicalAddress;
+		DWORD	VirtualSize;
+	} Misc;
+	DWORD		VirtualAddress;
+	DWORD		SizeOfRawData;
+	DWORD		PointerToRawData;
+	DWORD		PointerToRelocations;
+	DWORD		PointerToLinenumbers;
+	WORD		NumberOfRelocations;
+	WORD		NumberOfLinenumbers;
+	DWORD		Characteristics;
+} IMAGE_SECTION_HEADER;
+
+typedef struct
+{
+	DWORD		Characteristics;
+	DWORD		TimeDateStamp;
+	WORD		MajorVersion;
+	WORD		MinorVersion;
+	DWORD		Type;
+	DWORD		SizeOfData;
+	DWORD		AddressOfRawData;
+	DWORD		PointerToRawData;
+} IMAGE_DEBUG_DIRECTORY;
+
+// the layouts are read straight out of the file, so they must match WinNT.h exactly
+static_assert(sizeof(IMAGE_DOS_HEADER) == 64, "IMAGE_DOS_HEADER layout");
+static_assert(sizeof(IMAGE_FILE_HEADER) == 20, "IMAGE_FILE_HEADER layout");
+static_assert(sizeof(IMAGE_OPTIONAL_HEADER32) == 224, "IMAGE_OPTIONAL_HEADER32 layout");
+static_assert(sizeof(IMAGE_OPTIONAL_HEADER64) == 240, "IMAGE_OPTIONAL_HEADER64 layout");
+static_assert(sizeof(IMAGE_SECTION_HEADER) == 40, "IMAGE_SECTION_HEADER layout");
+static_assert(sizeof(IMAGE_DEBUG_DIRECTORY) == 28, "IMAGE_DEBUG_DIRECTORY layout");
+
+// the bounds-checked copies the MSVC CRT provides
+inline int memcpy_s(void* dest, size_t destSize, const void* src, size_t count)
+{
+	if(count > destSize)
+	{
+		memset(dest, 0, destSize);
+		return ERANGE;
+	}
+
+	memcpy(dest, src, count);
+	return 0;
+}
+
+inline int strcpy_s(char* dest, size_t destSize, const char* src)
+{
+	size_t length = strlen(src);
+
+	if(length >= destSize)
+	{
+		if(destSize > 0)
+			dest[0] = '\0';
+		return ERANGE;
+	}
+
+	memcpy(dest, src, length + 1);
+	return 0;
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -1,9 +1,7 @@
 #ifndef __PESECTION_H__
 #define __PESECTION_H__
 
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <WinNT.h>
+#include "PEFormat.h"
 
 class PESection
 {
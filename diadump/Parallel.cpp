@@ -0,0 +1,217 @@
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Parallel.h"
+#include "Stats.h"
+
+using namespace std;
+
+typedef struct
+{
+	mutex			lock;
+	deque<size_t>	items;
+} WorkerQueue;
+
+static bool TakeWork(vector<shared_ptr<WorkerQueue>>& queues, size_t worker, size_t& item)
+{
+	{
+		lock_guard<mutex> guard(queues[worker]->lock);
+
+		if(!queues[worker]->items.empty()) {
+			item = queues[worker]->items.front();
+			queues[worker]->items.pop_front();
+			return true;
+		}
+	}
+
+	// steal from the back so we take the cheapest work the
+	// victim has left and stay out of the way of its front
+	for(size_t offset = 1, numQueues = queues.size(); offset < numQueues; ++offset) {
+		WorkerQueue& victim = *queues[(worker + offset) % numQueues];
+		lock_guard<mutex> guard(victim.lock);
+
+		if(!victim.items.empty()) {
+			item = victim.items.back();
+			victim.items.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ParallelFor(const vector<size_t>& items, unsigned int numThreads, const function<void (size_t)>& task)
+{
+	if(numThreads == 0)
+		numThreads = GetHardwareThreadCount();
+
+	if(numThreads > items.size())
+		numThreads = static_cast<unsigned int>(items.size());
+
+	if(numThreads <= 1) {
+		for(vector<size_t>::const_iterator i = items.begin(), i_end = items.end(); i != i_end; ++i)
+			task(*i);
+
+		return;
+	}
+
+	vector<shared_ptr<WorkerQueue>> queues;
+
+	for(unsigned int worker = 0; worker < numThreads; ++worker)
+		queues.push_back(shared_ptr<WorkerQueue>(new WorkerQueue));
+
+	for(size_t i = 0, i_end = items.size(); i < i_end; ++i)
+		queues[i % numThreads]->items.push_back(items[i]);
+
+	mutex			errorLock;
+	exception_ptr	firstError;
+	vector<thread>	threads;
+
+	for(unsigned int worker = 0; worker < numThreads; ++worker) {
+		threads.push_back(thread([&queues, &task, &errorLock, &firstError, worker]() {
+			size_t item;
+
+			SetStatsWorker(worker + 1);
+
+			while(TakeWork(queues, worker, item)) {
+				try {
+					task(item);
+				} catch(...) {
+					lock_guard<mutex> guard(errorLock);
+
+					if(!firstError)
+						firstError = current_exception();
+				}
+			}
+		}));
+	}
+
+	for(vector<thread>::iterator i = threads.begin(), i_end = threads.end(); i != i_end; ++i)
+		i->join();
+
+	if(firstError)
+		rethrow_exception(firstError);
+}
+
+void ParallelOrdered(size_t numItems, unsigned int numThreads, size_t maxAhead, const function<void (size_t)>& produce, const function<void (size_t)>& consume)
+{
+	if(numThreads == 0)
+		numThreads = GetHardwareThreadCount();
+
+	if(maxAhead == 0)
+		maxAhead = 1;
+
+	if(numThreads > maxAhead)
+		numThreads = static_cast<unsigned int>(maxAhead);
+
+	if(numThreads > numItems)
+		numThreads = static_cast<unsigned int>(numItems);
+
+	if(numThreads <= 1) {
+		for(size_t item = 0; item < numItems; ++item) {
+			produce(item);
+			consume(item);
+		}
+
+		return;
+	}
+
+	// workers claim items in order; slot item % maxAhead says whether
+	// that item is ready for the consumer
+	mutex				lock;
+	condition_variable	itemClaimable;
+	condition_variable	itemReady;
+	vector<bool>		bSlotReady(maxAhead, false);
+	size_t				nextToClaim = 0;
+	size_t				nextToConsume = 0;
+	bool				bStopping = false;
+	exception_ptr		firstError;
+	vector<thread>		threads;
+
+	for(unsigned int worker = 0; worker < numThreads; ++worker) {
+		threads.push_back(thread([&, worker]() {
+			SetStatsWorker(worker + 1);
+
+			for(;;) {
+				size_t item;
+
+				{
+					unique_lock<mutex> guard(lock);
+
+					while(!bStopping && nextToClaim < numItems && nextToClaim >= nextToConsume + maxAhead)
+						itemClaimable.wait(guard);
+
+					if(bStopping || nextToClaim >= numItems)
+						return;
+
+					item = nextToClaim++;
+				}
+
+				try {
+					produce(item);
+				} catch(...) {
+					lock_guard<mutex> guard(lock);
+
+					if(!firstError)
+						firstError = current_exception();
+
+					bStopping = true;
+					itemClaimable.notify_all();
+					itemReady.notify_all();
+					return;
+				}
+
+				lock_guard<mutex> guard(lock);
+
+				bSlotReady[item % maxAhead] = true;
+				itemReady.notify_all();
+			}
+		}));
+	}
+
+	try {
+		while(nextToConsume < numItems) {
+			{
+				unique_lock<mutex> guard(lock);
+
+				while(!bStopping && !bSlotReady[nextToConsume % maxAhead])
+					itemReady.wait(guard);
+
+				if(bStopping)
+					break;
+			}
+
+			consume(nextToConsume);
+
+			lock_guard<mutex> guard(lock);
+
+			bSlotReady[nextToConsume % maxAhead] = false;
+			++nextToConsume;
+			itemClaimable.notify_all();
+		}
+	} catch(...) {
+		lock_guard<mutex> guard(lock);
+
+		if(!firstError)
+			firstError = current_exception();
+
+		bStopping = true;
+		itemClaimable.notify_all();
+	}
+
+	for(vector<thread>::iterator i = threads.begin(), i_end = threads.end(); i != i_end; ++i)
+		i->join();
+
+	if(firstError)
+		rethrow_exception(firstError);
+}
+
+unsigned int GetHardwareThreadCount()
+{
+	unsigned int numThreads = thread::hardware_concurrency();
+
+	return numThreads ? numThreads : 1;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <functional>
+#include <vector>
+
+//
+//	Runs task(item) for every entry of items across numThreads workers
+//	and returns once all of them are done. Items are dealt out round-robin
+//	in the order given, so put the most expensive ones first. A worker
+//	that runs out takes work from the back of another worker's queue.
+//
+//	The first exception thrown by a task is rethrown on the calling thread.
+//
+void			ParallelFor(const std::vector<size_t>& items, unsigned int numThreads, const std::function<void (size_t)>& task);
+
+//
+//	Runs produce(item) for items 0 to numItems - 1 across numThreads
+//	workers and calls consume(item) for each on the calling thread, in
+//	item order, once it has been produced. The workers are started once
+//	for the whole run and never get more than maxAhead items past the one
+//	being consumed, so the caller can keep results in maxAhead slots
+//	indexed by item % maxAhead.
+//
+//	The first exception thrown by either callback stops the run and is
+//	rethrown on the calling thread.
+//
+void			ParallelOrdered(size_t numItems, unsigned int numThreads, size_t maxAhead,
+					const std::function<void (size_t)>& produce, const std::function<void (size_t)>& consume);
+unsigned int	GetHardwareThreadCount();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <string.h>
+#include "RecursiveDescent.h"
+
+using namespace std;
+
+// what each byte of the function has turned out to be
+enum ByteState
+{
+	ByteUnknown,
+	ByteInstructionStart,
+	ByteInstruction,
+	ByteData,
+	ByteBad
+};
+
+// more entries than this is a misread table, not a real switch
+static const size_t MaxJumpTableEntries = 4096;
+
+typedef struct
+{
+	unsigned int	offset;
+	unsigned char	length;
+	unsigned short	iclass;
+	unsigned char	category;
+	unsigned char	flags;
+	unsigned char	numOperands;
+} DecodedEntry;
+
+static bool EntryOffsetLess(const DecodedEntry& a, const DecodedEntry& b)
+{
+	return a.offset < b.offset;
+}
+
+static void PushTarget(long long target, size_t codeSize, vector<size_t>& worklist)
+{
+	if(target >= 0 && static_cast<unsigned long long>(target) < codeSize)
+		worklist.push_back(static_cast<size_t>(target));
+}
+
+RecursiveDescent::RecursiveDescent(const PE& pe)
+	: m_pe(pe)
+{
+	if(m_pe.Is64Bit()) {
+		m_machineMode = XED_MACHINE_MODE_LONG_64;
+		m_stackAddrWidth = XED_ADDRESS_WIDTH_64b;
+	} else {
+		m_machineMode = XED_MACHINE_MODE_LEGACY_32;
+		m_stackAddrWidth = XED_ADDRESS_WIDTH_32b;
+	}
+}
+
+void RecursiveDescent::DecodeFunction(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const
+{
+	ByteSpan code;
+
+	if(!m_pe.getRVARange(func.address, func.length, code))
+		return;
+
+	disasFunc.code = code;
+
+	vector<unsigned char>	byteStates(code.size, ByteUnknown);
+	vector<DecodedEntry>	entries;
+	vector<size_t>			worklist;
+
+	worklist.push_back(0);
+
+	while(!worklist.empty()) {
+		size_t offset = worklist.back();
+		worklist.pop_back();
+
+		// the table and compare feeding the next indirect jump,
+		// only trusted within one straight run of instructions
+		bool		bHaveTableLoad = false;
+		long long	tableDisplacement = 0;
+		bool		bHaveBound = false;
+		size_t		maxEntries = 0;
+
+		while(offset < code.size && byteStates[offset] == ByteUnknown) {
+			xed_decoded_inst_t	xedd;
+			size_t				bytesLeft = code.size - offset;
+
+			xed_decoded_inst_zero(&xedd);
+			xed_decoded_inst_set_mode(&xedd, m_machineMode, m_stackAddrWidth);
+
+			xed_error_enum_t xed_error = xed_decode(&xedd,
+				XED_STATIC_CAST(const xed_uint8_t*, code.data + offset),
+				static_cast<unsigned int>(bytesLeft < 15 ? bytesLeft : 15));
+
+			if(xed_error != XED_ERROR_NONE) {
+				AddInvalidRegion(diag, code.data, code.size, offset, 1);
+
+				DecodedEntry bad = { static_cast<unsigned int>(offset), 1, XED_ICLASS_INVALID, XED_CATEGORY_INVALID, 0, 0 };
+				entries.push_back(bad);
+				byteStates[offset] = ByteBad;
+				break;
+			}
+
+			size_t instrLen = xed_decoded_inst_get_length(&xedd);
+			bool bOverlaps = false;
+
+			// a path that lands in the middle of code or data we've already
+			// claimed is following a misread target, drop it
+			for(size_t byteNum = 1; byteNum < instrLen; ++byteNum) {
+				if(byteStates[offset + byteNum] != ByteUnknown) {
+					bOverlaps = true;
+					break;
+				}
+			}
+
+			if(bOverlaps)
+				break;
+
+			xed_iclass_enum_t	iclass = xed_decoded_inst_get_iclass(&xedd);
+			xed_category_enum_t	category = xed_decoded_inst_get_category(&xedd);
+			xed_uint_t			numMemOps = xed_decoded_inst_number_of_memory_operands(&xedd);
+			unsigned char		instrFlags = InstrValid;
+
+			for(xed_uint_t memOp = 0; memOp < numMemOps; ++memOp) {
+				instrFlags |= InstrHasMemoryOperand;
+
+				if(xed_decoded_inst_get_index_reg(&xedd, memOp) != XED_REG_INVALID)
+					instrFlags |= InstrHasIndexRegister;
+			}
+
+			xed_uint_t branchWidth = xed_decoded_inst_get_branch_displacement_width(&xedd);
+
+			if(branchWidth)
+				instrFlags |= InstrRelativeBranch;
+
+			DecodedEntry entry = {
+				static_cast<unsigned int>(offset),
+				static_cast<unsigned char>(instrLen),
+				static_cast<unsigned short>(iclass),
+				static_cast<unsigned char>(category),
+				instrFlags,
+				static_cast<unsigned char>(xed_inst_noperands(xed_decoded_inst_inst(&xedd)))
+			};
+
+			entries.push_back(entry);
+
+			byteStates[offset] = ByteInstructionStart;
+
+			for(size_t byteNum = 1; byteNum < instrLen; ++byteNum)
+				byteStates[offset + byteNum] = ByteInstruction;
+
+			size_t nextOffset = offset + instrLen;
+
+			// x64 switches load a 32-bit RVA with mov/movsxd reg, [base + index*4 + table]
+			if((iclass == XED_ICLASS_MOV || iclass == XED_ICLASS_MOVSXD) && numMemOps == 1 &&
+				xed_decoded_inst_get_index_reg(&xedd, 0) != XED_REG_INVALID &&
+				xed_decoded_inst_get_scale(&xedd, 0) == 4) {
+
+					bHaveTableLoad = true;
+					tableDisplacement = xed_decoded_inst_get_memory_displacement(&xedd, 0);
+			}
+
+			// the cmp index, N / ja default in front of the table bounds it
+			if(iclass == XED_ICLASS_CMP && xed_decoded_inst_get_immediate_width(&xedd)) {
+				long long bound = xed_decoded_inst_get_signed_immediate(&xedd);
+
+				bHaveBound = bound >= 0 && static_cast<unsigned long long>(bound) < MaxJumpTableEntries;
+				maxEntries = bHaveBound ? static_cast<size_t>(bound) + 1 : 0;
+			}
+
+			if(category == XED_CATEGORY_RET || iclass == XED_ICLASS_INT3)
+				break;
+
+			if(branchWidth) {
+				long long target = static_cast<long long>(nextOffset) + xed_decoded_inst_get_branch_displacement(&xedd);
+
+				// calls out of the function are someone else's to decode
+				PushTarget(target, code.size, worklist);
+
+				if(category == XED_CATEGORY_UNCOND_BR)
+					break;
+			} else if(category == XED_CATEGORY_UNCOND_BR) {
+				// x86 switches jump through jmp [index*4 + table] with absolute entries
+				if(!m_pe.Is64Bit() && numMemOps == 1 &&
+					xed_decoded_inst_get_base_reg(&xedd, 0) == XED_REG_INVALID &&
+					xed_decoded_inst_get_index_reg(&xedd, 0) != XED_REG_INVALID &&
+					xed_decoded_inst_get_scale(&xedd, 0) == 4) {
+
+						unsigned long long tableRVA = static_cast<unsigned long long>(xed_decoded_inst_get_memory_displacement(&xedd, 0)) - m_pe.getImageBase();
+						ReadJumpTable(func, code, tableRVA, false, bHaveBound ? maxEntries : 0, byteStates, worklist);
+				} else if(m_pe.Is64Bit() && numMemOps == 0 && bHaveTableLoad && tableDisplacement > 0) {
+					ReadJumpTable(func, code, static_cast<unsigned long long>(tableDisplacement), true, bHaveBound ? maxEntries : 0, byteStates, worklist);
+				}
+
+				break;
+			}
+
+			offset = nextOffset;
+		}
+	}
+
+	// whatever was never reached goes in as data, so the
+	// output still accounts for every byte of the function
+	for(size_t offset = 0; offset < code.size;) {
+		if(byteStates[offset] != ByteUnknown && byteStates[offset] != ByteData) {
+			++offset;
+			continue;
+		}
+
+		size_t runEnd = offset + 1;
+
+		while(runEnd < code.size && runEnd - offset < DataChunkSize &&
+			(byteStates[runEnd] == ByteUnknown || byteStates[runEnd] == ByteData))
+				++runEnd;
+
+		DecodedEntry data = { static_cast<unsigned int>(offset), static_cast<unsigned char>(runEnd - offset), XED_ICLASS_INVALID, XED_CATEGORY_INVALID, InstrData, 0 };
+		entries.push_back(data);
+
+		offset = runEnd;
+	}
+
+	sort(entries.begin(), entries.end(), EntryOffsetLess);
+
+	size_t numEntries = entries.size();
+
+	disasFunc.offsets.resize(numEntries);
+	disasFunc.lengths.resize(numEntries);
+	disasFunc.iclasses.resize(numEntries);
+	disasFunc.categories.resize(numEntries);
+	disasFunc.flags.resize(numEntries);
+	disasFunc.numOperands.resize(numEntries);
+
+	for(size_t i = 0; i < numEntries; ++i) {
+		disasFunc.offsets[i] = entries[i].offset;
+		disasFunc.lengths[i] = entries[i].length;
+		disasFunc.iclasses[i] = entries[i].iclass;
+		disasFunc.categories[i] = entries[i].category;
+		disasFunc.flags[i] = entries[i].flags;
+		disasFunc.numOperands[i] = entries[i].numOperands;
+	}
+}
+
+size_t RecursiveDescent::ReadJumpTable(const Function& func, const ByteSpan& code, unsigned long long tableRVA, bool bEntriesAreRVAs,
+	size_t maxEntries, vector<unsigned char>& byteStates, vector<size_t>& worklist) const
+{
+	// without a bound, keep going while the entries look like
+	// targets in this function and we aren't reading into code
+	bool bBounded = maxEntries != 0;
+
+	if(!bBounded)
+		maxEntries = MaxJumpTableEntries;
+
+	ByteSpan table;
+
+	if(!m_pe.getRVARange(tableRVA, maxEntries * sizeof(unsigned int), table))
+		return 0;
+
+	size_t numEntries = 0;
+
+	for(; numEntries < maxEntries && (numEntries + 1) * sizeof(unsigned int) <= table.size; ++numEntries) {
+		unsigned long long	entryRVA = tableRVA + numEntries * sizeof(unsigned int);
+		bool				bInFunction = entryRVA >= func.address && entryRVA - func.address + sizeof(unsigned int) <= code.size;
+		size_t				entryOffset = bInFunction ? static_cast<size_t>(entryRVA - func.address) : 0;
+
+		if(!bBounded && bInFunction && byteStates[entryOffset] != ByteUnknown && byteStates[entryOffset] != ByteData)
+			break;
+
+		unsigned int entry;
+		memcpy(&entry, table.data + numEntries * sizeof(unsigned int), sizeof(entry));
+
+		unsigned long long targetRVA = bEntriesAreRVAs ? entry : entry - m_pe.getImageBase();
+
+		if(targetRVA < func.address || targetRVA - func.address >= code.size) {
+			if(!bBounded)
+				break;
+
+			continue;
+		}
+
+		if(bInFunction) {
+			for(size_t byteNum = 0; byteNum < sizeof(unsigned int); ++byteNum) {
+				if(byteStates[entryOffset + byteNum] == ByteUnknown)
+					byteStates[entryOffset + byteNum] = ByteData;
+			}
+		}
+
+		worklist.push_back(static_cast<size_t>(targetRVA - func.address));
+	}
+
+	return numEntries;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef __RECURSIVEDESCENT_H__
+#define __RECURSIVEDESCENT_H__
+
+extern "C"
+{
+	#include <xed-interface.h>
+}
+
+#include <vector>
+
+#include "DecodeDiagnostics.h"
+#include "DisassembledFunction.h"
+#include "PE.h"
+#include "PDB.h"
+
+//
+//	Decodes a function by following its control flow from the start
+//	address instead of sweeping its whole range. Every byte is decoded
+//	at most once, jump tables are read as tables rather than as code,
+//	and whatever is never reached is reported as data.
+//
+class RecursiveDescent
+{
+public:
+	explicit RecursiveDescent(const PE& pe);
+
+	void						DecodeFunction(const Function& func, DisassembledFunction& disasFunc, DecodeDiagnostics& diag) const;
+
+private:
+	size_t						ReadJumpTable(const Function& func, const ByteSpan& code, unsigned long long tableRVA, bool bEntriesAreRVAs,
+									size_t maxEntries, std::vector<unsigned char>& byteStates, std::vector<size_t>& worklist) const;
+
+	const PE&					m_pe;
+
+	xed_machine_mode_enum_t		m_machineMode;
+	xed_address_width_enum_t	m_stackAddrWidth;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "RegisterMap.h"
+#include "XedTables.h"
+
+using namespace std;
+
+typedef struct
+{
+	CV_HREG_e		cvReg;
+	xed_reg_enum_t	xedReg;
+} RegisterPair;
+
+// registers with the same number on x86 and x64
+static const RegisterPair s_x86Registers[] =
+{
+	{ CV_REG_AH,			XED_REG_AH },
+	{ CV_REG_AL,			XED_REG_AL },
+	{ CV_REG_AX,			XED_REG_AX },
+	{ CV_REG_BH,			XED_REG_BH },
+	{ CV_REG_BL,			XED_REG_BL },
+	{ CV_REG_BP,			XED_REG_BP },
+	{ CV_REG_BX,			XED_REG_BX },
+	{ CV_REG_CH,			XED_REG_CH },
+	{ CV_REG_CL,			XED_REG_CL },
+	{ CV_REG_CR0,			XED_REG_CR0 },
+	{ CV_REG_CR1,			XED_REG_CR1 },
+	{ CV_REG_CR2,			XED_REG_CR2 },
+	{ CV_REG_CR3,			XED_REG_CR3 },
+	{ CV_REG_CR4,			XED_REG_CR4 },
+	{ CV_REG_CS,			XED_REG_CS },
+	{ CV_REG_CX,			XED_REG_CX },
+	{ CV_REG_DH,			XED_REG_DH },
+	{ CV_REG_DI,			XED_REG_DI },
+	{ CV_REG_DL,			XED_REG_DL },
+	{ CV_REG_DR0,			XED_REG_DR0 },
+	{ CV_REG_DR1,			XED_REG_DR1 },
+	{ CV_REG_DR2,			XED_REG_DR2 },
+	{ CV_REG_DR3,			XED_REG_DR3 },
+	{ CV_REG_DR4,			XED_REG_DR4 },
+	{ CV_REG_DR5,			XED_REG_DR5 },
+	{ CV_REG_DR6,			XED_REG_DR6 },
+	{ CV_REG_DR7,			XED_REG_DR7 },
+	{ CV_REG_DS,			XED_REG_DS },
+	{ CV_REG_DX,			XED_REG_DX },
+	{ CV_REG_EAX,			XED_REG_EAX },
+	{ CV_REG_EBP,			XED_REG_EBP },
+	{ CV_REG_EBX,			XED_REG_EBX },
+	{ CV_REG_ECX,			XED_REG_ECX },
+	{ CV_REG_EDI,			XED_REG_EDI },
+	{ CV_REG_EDX,			XED_REG_EDX },
+	{ CV_REG_EFLAGS,		XED_REG_EFLAGS },
+	{ CV_REG_EIP,			XED_REG_EIP },
+	{ CV_REG_ES,			XED_REG_ES },
+	{ CV_REG_ESI,			XED_REG_ESI },
+	{ CV_REG_ESP,			XED_REG_ESP },
+	{ CV_REG_FLAGS,			XED_REG_FLAGS },
+	{ CV_REG_FS,			XED_REG_FS },
+	{ CV_REG_GDTR,			XED_REG_GDTR },
+	{ CV_REG_GS,			XED_REG_GS },
+	{ CV_REG_IDTR,			XED_REG_IDTR },
+	{ CV_REG_IP,			XED_REG_IP },
+	{ CV_REG_LDTR,			XED_REG_LDTR },
+	{ CV_REG_MXCSR,			XED_REG_MXCSR },
+	{ CV_REG_SI,			XED_REG_SI },
+	{ CV_REG_SP,			XED_REG_SP },
+	{ CV_REG_SS,			XED_REG_SS },
+	{ CV_REG_ST0,			XED_REG_ST0 },
+	{ CV_REG_ST1,			XED_REG_ST1 },
+	{ CV_REG_ST2,			XED_REG_ST2 },
+	{ CV_REG_ST3,			XED_REG_ST3 },
+	{ CV_REG_ST4,			XED_REG_ST4 },
+	{ CV_REG_ST5,			XED_REG_ST5 },
+	{ CV_REG_ST6,			XED_REG_ST6 },
+	{ CV_REG_ST7,			XED_REG_ST7 },
+	{ CV_REG_TR,			XED_REG_TR },
+	{ CV_REG_XMM0,			XED_REG_XMM0 },
+	{ CV_REG_XMM1,			XED_REG_XMM1 },
+	{ CV_REG_XMM10,			XED_REG_XMM10 },
+	{ CV_REG_XMM11,			XED_REG_XMM11 },
+	{ CV_REG_XMM12,			XED_REG_XMM12 },
+	{ CV_REG_XMM13,			XED_REG_XMM13 },
+	{ CV_REG_XMM2,			XED_REG_XMM2 },
+	{ CV_REG_XMM3,			XED_REG_XMM3 },
+	{ CV_REG_XMM4,			XED_REG_XMM4 },
+	{ CV_REG_XMM5,			XED_REG_XMM5 },
+	{ CV_REG_XMM6,			XED_REG_XMM6 },
+	{ CV_REG_XMM7,			XED_REG_XMM7 },
+	{ CV_REG_YMM0,			XED_REG_YMM0 },
+	{ CV_REG_YMM1,			XED_REG_YMM1 },
+	{ CV_REG_YMM2,			XED_REG_YMM2 },
+	{ CV_REG_YMM3,			XED_REG_YMM3 },
+	{ CV_REG_YMM4,			XED_REG_YMM4 },
+	{ CV_REG_YMM5,			XED_REG_YMM5 },
+	{ CV_REG_YMM6,			XED_REG_YMM6 },
+	{ CV_REG_YMM7,			XED_REG_YMM7 },
+};
+
+// x64 only; some of these reuse numbers that mean
+// something else on x86 (XMM8-15 are YMM0-7 there)
+static const RegisterPair s_amd64Registers[] =
+{
+	{ CV_AMD64_BPL,			XED_REG_BPL },
+	{ CV_AMD64_CR8,			XED_REG_CR8 },
+	{ CV_AMD64_DIL,			XED_REG_DIL },
+	{ CV_AMD64_DR10,		XED_REG_DR10 },
+	{ CV_AMD64_DR11,		XED_REG_DR11 },
+	{ CV_AMD64_DR12,		XED_REG_DR12 },
+	{ CV_AMD64_DR13,		XED_REG_DR13 },
+	{ CV_AMD64_DR14,		XED_REG_DR14 },
+	{ CV_AMD64_DR15,		XED_REG_DR15 },
+	{ CV_AMD64_DR8,			XED_REG_DR8 },
+	{ CV_AMD64_DR9,			XED_REG_DR9 },
+	{ CV_AMD64_EFLAGS,		XED_REG_EFLAGS },
+	{ CV_AMD64_FLAGS,		XED_REG_RFLAGS },
+	{ CV_AMD64_R10,			XED_REG_R10 },
+	{ CV_AMD64_R10B,		XED_REG_R10B },
+	{ CV_AMD64_R10D,		XED_REG_R10D },
+	{ CV_AMD64_R10W,		XED_REG_R10W },
+	{ CV_AMD64_R11,			XED_REG_R11 },
+	{ CV_AMD64_R11B,		XED_REG_R11B },
+	{ CV_AMD64_R11D,		XED_REG_R11D },
+	{ CV_AMD64_R11W,		XED_REG_R11W },
+	{ CV_AMD64_R12,			XED_REG_R12 },
+	{ CV_AMD64_R12B,		XED_REG_R12B },
+	{ CV_AMD64_R12D,		XED_REG_R12D },
+	{ CV_AMD64_R12W,		XED_REG_R12W },
+	{ CV_AMD64_R13,			XED_REG_R13 },
+	{ CV_AMD64_R13B,		XED_REG_R13B },
+	{ CV_AMD64_R13D,		XED_REG_R13D },
+	{ CV_AMD64_R13W,		XED_REG_R13W },
+	{ CV_AMD64_R14,			XED_REG_R14 },
+	{ CV_AMD64_R14B,		XED_REG_R14B },
+	{ CV_AMD64_R14D,		XED_REG_R14D },
+	{ CV_AMD64_R14W,		XED_REG_R14W },
+	{ CV_AMD64_R15,			XED_REG_R15 },
+	{ CV_AMD64_R15B,		XED_REG_R15B },
+	{ CV_AMD64_R15D,		XED_REG_R15D },
+	{ CV_AMD64_R15W,		XED_REG_R15W },
+	{ CV_AMD64_R8,			XED_REG_R8 },
+	{ CV_AMD64_R8B,			XED_REG_R8B },
+	{ CV_AMD64_R8D,			XED_REG_R8D },
+	{ CV_AMD64_R8W,			XED_REG_R8W },
+	{ CV_AMD64_R9,			XED_REG_R9 },
+	{ CV_AMD64_R9B,			XED_REG_R9B },
+	{ CV_AMD64_R9D,			XED_REG_R9D },
+	{ CV_AMD64_R9W,			XED_REG_R9W },
+	{ CV_AMD64_RAX,			XED_REG_RAX },
+	{ CV_AMD64_RBP,			XED_REG_RBP },
+	{ CV_AMD64_RBX,			XED_REG_RBX },
+	{ CV_AMD64_RCX,			XED_REG_RCX },
+	{ CV_AMD64_RDI,			XED_REG_RDI },
+	{ CV_AMD64_RDX,			XED_REG_RDX },
+	{ CV_AMD64_RIP,			XED_REG_RIP },
+	{ CV_AMD64_RSI,			XED_REG_RSI },
+	{ CV_AMD64_RSP,			XED_REG_RSP },
+	{ CV_AMD64_SIL,			XED_REG_SIL },
+	{ CV_AMD64_SPL,			XED_REG_SPL },
+	{ CV_AMD64_XMM14,		XED_REG_XMM14 },
+	{ CV_AMD64_XMM15,		XED_REG_XMM15 },
+	{ CV_AMD64_XMM8,		XED_REG_XMM8 },
+	{ CV_AMD64_XMM9,		XED_REG_XMM9 },
+	{ CV_AMD64_YMM10,		XED_REG_YMM10 },
+	{ CV_AMD64_YMM11,		XED_REG_YMM11 },
+	{ CV_AMD64_YMM12,		XED_REG_YMM12 },
+	{ CV_AMD64_YMM13,		XED_REG_YMM13 },
+	{ CV_AMD64_YMM14,		XED_REG_YMM14 },
+	{ CV_AMD64_YMM15,		XED_REG_YMM15 },
+	{ CV_AMD64_YMM8,		XED_REG_YMM8 },
+	{ CV_AMD64_YMM9,		XED_REG_YMM9 },
+};
+
+template<size_t N>
+static void AddRegisters(const RegisterPair (&registers)[N], vector<xed_reg_enum_t>& table)
+{
+	for(size_t i = 0; i < N; ++i) {
+		size_t cvReg = static_cast<size_t>(registers[i].cvReg);
+
+		if(cvReg >= table.size())
+			table.resize(cvReg + 1, XED_REG_INVALID);
+
+		table[cvReg] = registers[i].xedReg;
+	}
+}
+
+RegisterMap::RegisterMap(bool bIs64Bit)
+	: m_fullRegister(XED_REG_LAST, XED_REG_INVALID)
+{
+	AddRegisters(s_x86Registers, m_cvToXed);
+
+	if(bIs64Bit)
+		AddRegisters(s_amd64Registers, m_cvToXed);
+
+	// the enclosing register tables are filled in by xed_tables_init
+	InitXedTables();
+
+	for(size_t reg = 0, reg_end = m_fullRegister.size(); reg < reg_end; ++reg) {
+		xed_reg_enum_t xedReg = static_cast<xed_reg_enum_t>(reg);
+		xed_reg_enum_t fullReg = bIs64Bit ? xed_get_largest_enclosing_register(xedReg) : xed_get_largest_enclosing_register32(xedReg);
+
+		// anything that isn't part of a bigger register stands for itself
+		m_fullRegister[reg] = fullReg != XED_REG_INVALID ? fullReg : xedReg;
+	}
+}
+
+xed_reg_enum_t RegisterMap::ToDisasReg(CV_HREG_e reg) const
+{
+	size_t cvReg = static_cast<size_t>(reg);
+
+	return cvReg < m_cvToXed.size() ? m_cvToXed[cvReg] : XED_REG_INVALID;
+}
+
+xed_reg_enum_t RegisterMap::GetFullRegister(xed_reg_enum_t reg) const
+{
+	size_t xedReg = static_cast<size_t>(reg);
+
+	return xedReg < m_fullRegister.size() ? m_fullRegister[xedReg] : XED_REG_INVALID;
+}
+
+/* UNMAPPED CV_HREG_e's
+ *
+ *		XED_REG_CR5
+ *		XED_REG_CR6
+ *		XED_REG_CR7
+ *		XED_REG_CR9
+ *		XED_REG_CR10
+ *		XED_REG_CR11
+ *		XED_REG_CR12
+ *		XED_REG_CR13
+ *		XED_REG_CR14
+ *		XED_REG_CR15
+ *		XED_REG_ERROR
+ *		XED_REG_MMX0
+ *		XED_REG_MMX1
+ *		XED_REG_MMX2
+ *		XED_REG_MMX3
+ *		XED_REG_MMX4
+ *		XED_REG_MMX5
+ *		XED_REG_MMX6
+ *		XED_REG_MMX7
+ *		XED_REG_STACKPUSH
+ *		XED_REG_STACKPOP
+ *		XED_REG_TSC
+ *		XED_REG_TSCAUX
+ *		XED_REG_MSRS
+ *		XED_REG_FSBASE
+ *		XED_REG_GSBASE
+ *		XED_REG_X87CONTROL
+ *		XED_REG_X87STATUS
+ *		XED_REG_X87TAG
+ *		XED_REG_X87PUSH
+ *		XED_REG_X87POP
+ *		XED_REG_X87POP2
+ *		XED_REG_X87OPCODE
+ *		XED_REG_X87LASTCS
+ *		XED_REG_X87LASTIP
+ *		XED_REG_X87LASTDS
+ *		XED_REG_X87LASTDP
+ *		XED_REG_TMP0
+ *		XED_REG_TMP1
+ *		XED_REG_TMP2
+ *		XED_REG_TMP3
+ *		XED_REG_TMP4
+ *		XED_REG_TMP5
+ *		XED_REG_TMP6
+ *		XED_REG_TMP7
+ *		XED_REG_TMP8
+ *		XED_REG_TMP9
+ *		XED_REG_TMP10
+ *		XED_REG_TMP11
+ *		XED_REG_TMP12
+ *		XED_REG_TMP13
+ *		XED_REG_TMP14
+ *		XED_REG_TMP15
+ *		XED_REG_XCR0
+ *		
+ *
+ */
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef __REGISTERMAP_H__
+#define __REGISTERMAP_H__
+
+extern "C"
+{
+	#include <xed-interface.h>
+}
+
+#include <vector>
+
+#include "CVConst.h"
+
+//
+//	Translates CodeView register numbers to XED registers through a
+//	flat table for the image's architecture, and maps any XED register
+//	to the full register enclosing it (ECX and CL both become RCX on
+//	x64), so sub-register uses can be matched against a variable.
+//
+class RegisterMap
+{
+public:
+	explicit RegisterMap(bool bIs64Bit);
+
+	xed_reg_enum_t				ToDisasReg(CV_HREG_e reg) const;
+	xed_reg_enum_t				GetFullRegister(xed_reg_enum_t reg) const;
+
+private:
+	std::vector<xed_reg_enum_t>	m_cvToXed;
+	std::vector<xed_reg_enum_t>	m_fullRegister;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,278 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#define THREAD_LOCAL __declspec(thread)
+#else
+#include <sys/resource.h>
+#include <time.h>
+#define THREAD_LOCAL __thread
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+#include "Stats.h"
+
+using namespace std;
+
+typedef struct
+{
+	unsigned long long	wall[NumStatsPhases];
+	unsigned long long	cpu[NumStatsPhases];
+	unsigned long long	calls[NumStatsPhases];
+} WorkerStats;
+
+static const char* const PhaseNames[NumStatsPhases] = { "pe_load", "pdb_load", "decode", "annotate", "output" };
+static const char* const CounterNames[NumStatsCounters] = { "functions", "instructions", "invalid_resyncs", "bytes_written" };
+
+static bool									s_bEnabled = false;
+static chrono::high_resolution_clock::time_point	s_runStart;
+static atomic<unsigned long long>			s_counters[NumStatsCounters];
+static mutex								s_workersLock;
+static vector<WorkerStats>					s_workers;
+static THREAD_LOCAL unsigned int			s_worker;
+
+static unsigned long long GetWallTime()
+{
+	return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+// both CPU times are in nanoseconds, user plus kernel
+static unsigned long long GetThreadCPUTime()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+
+	if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		return 0;
+
+	ULARGE_INTEGER kernelTime, userTime;
+	kernelTime.LowPart = kernel.dwLowDateTime;
+	kernelTime.HighPart = kernel.dwHighDateTime;
+	userTime.LowPart = user.dwLowDateTime;
+	userTime.HighPart = user.dwHighDateTime;
+
+	return (kernelTime.QuadPart + userTime.QuadPart) * 100;
+#else
+	timespec now;
+
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+		return 0;
+
+	return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+static unsigned long long GetProcessCPUTime()
+{
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+
+	if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0;
+
+	ULARGE_INTEGER kernelTime, userTime;
+	kernelTime.LowPart = kernel.dwLowDateTime;
+	kernelTime.HighPart = kernel.dwHighDateTime;
+	userTime.LowPart = user.dwLowDateTime;
+	userTime.HighPart = user.dwHighDateTime;
+
+	return (kernelTime.QuadPart + userTime.QuadPart) * 100;
+#else
+	timespec now;
+
+	if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now) != 0)
+		return 0;
+
+	return static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+static unsigned long long GetPeakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage;
+
+	if(getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+	// Linux reports kilobytes
+	return static_cast<unsigned long long>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+static double ToSeconds(unsigned long long nanoseconds)
+{
+	return nanoseconds / 1e9;
+}
+
+PhaseTimer::PhaseTimer(StatsPhase phase)
+	: m_phase(phase), m_bActive(s_bEnabled), m_wallStart(0), m_cpuStart(0)
+{
+	if(m_bActive) {
+		m_wallStart = GetWallTime();
+		m_cpuStart = GetThreadCPUTime();
+	}
+}
+
+PhaseTimer::~PhaseTimer()
+{
+	Stop();
+}
+
+void PhaseTimer::Stop()
+{
+	if(!m_bActive)
+		return;
+
+	m_bActive = false;
+
+	unsigned long long wall = GetWallTime() - m_wallStart;
+	unsigned long long cpu = GetThreadCPUTime() - m_cpuStart;
+
+	lock_guard<mutex> guard(s_workersLock);
+
+	if(s_workers.size() <= s_worker) {
+		WorkerStats empty = {};
+		s_workers.resize(s_worker + 1, empty);
+	}
+
+	s_workers[s_worker].wall[m_phase] += wall;
+	s_workers[s_worker].cpu[m_phase] += cpu;
+	++s_workers[s_worker].calls[m_phase];
+}
+
+void EnableStats()
+{
+	s_runStart = chrono::high_resolution_clock::now();
+	s_bEnabled = true;
+}
+
+bool IsStatsEnabled()
+{
+	return s_bEnabled;
+}
+
+void SetStatsWorker(unsigned int worker)
+{
+	s_worker = worker;
+}
+
+void AddStatsCounter(StatsCounter counter, unsigned long long amount)
+{
+	if(s_bEnabled)
+		s_counters[counter] += amount;
+}
+
+static void SumPhases(WorkerStats& total)
+{
+	WorkerStats empty = {};
+	total = empty;
+
+	for(vector<WorkerStats>::const_iterator i = s_workers.begin(), i_end = s_workers.end(); i != i_end; ++i) {
+		for(int phase = 0; phase < NumStatsPhases; ++phase) {
+			total.wall[phase] += i->wall[phase];
+			total.cpu[phase] += i->cpu[phase];
+			total.calls[phase] += i->calls[phase];
+		}
+	}
+}
+
+void WriteStatsText(wostream& out)
+{
+	lock_guard<mutex> guard(s_workersLock);
+
+	WorkerStats total;
+	SumPhases(total);
+
+	double runSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - s_runStart).count();
+
+	out << fixed << setprecision(3);
+	out << L"Run: " << runSeconds << L" s wall, " << ToSeconds(GetProcessCPUTime()) << L" s CPU, "
+		<< GetPeakMemory() / (1024 * 1024) << L" MB peak memory" << endl << endl;
+
+	out << left << setw(12) << L"Phase" << right << setw(12) << L"Wall (s)" << setw(12) << L"CPU (s)" << setw(12) << L"Calls" << endl;
+
+	for(int phase = 0; phase < NumStatsPhases; ++phase) {
+		out << left << setw(12) << PhaseNames[phase] << right
+			<< setw(12) << ToSeconds(total.wall[phase])
+			<< setw(12) << ToSeconds(total.cpu[phase])
+			<< setw(12) << total.calls[phase] << endl;
+	}
+
+	out << endl;
+
+	for(size_t worker = 0, worker_end = s_workers.size(); worker < worker_end; ++worker) {
+		out << L"Worker " << worker << L":";
+
+		for(int phase = 0; phase < NumStatsPhases; ++phase) {
+			if(s_workers[worker].calls[phase])
+				out << L" " << PhaseNames[phase] << L" " << ToSeconds(s_workers[worker].wall[phase]) << L"/" << ToSeconds(s_workers[worker].cpu[phase]);
+		}
+
+		out << endl;
+	}
+
+	out << endl;
+
+	for(int counter = 0; counter < NumStatsCounters; ++counter)
+		out << left << setw(16) << CounterNames[counter] << right << s_counters[counter].load() << endl;
+}
+
+void WriteStatsJSON(ostream& out)
+{
+	lock_guard<mutex> guard(s_workersLock);
+
+	WorkerStats total;
+	SumPhases(total);
+
+	double runSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - s_runStart).count();
+
+	// times are in seconds, memory in bytes
+	out << fixed << setprecision(6);
+	out << "{\n";
+	out << "  \"wall_seconds\": " << runSeconds << ",\n";
+	out << "  \"cpu_seconds\": " << ToSeconds(GetProcessCPUTime()) << ",\n";
+	out << "  \"peak_memory_bytes\": " << GetPeakMemory() << ",\n";
+	out << "  \"phases\": {\n";
+
+	for(int phase = 0; phase < NumStatsPhases; ++phase) {
+		out << "    \"" << PhaseNames[phase] << "\": { \"wall_seconds\": " << ToSeconds(total.wall[phase])
+			<< ", \"cpu_seconds\": " << ToSeconds(total.cpu[phase])
+			<< ", \"calls\": " << total.calls[phase] << " }" << (phase + 1 < NumStatsPhases ? "," : "") << "\n";
+	}
+
+	out << "  },\n";
+	out << "  \"workers\": [\n";
+
+	for(size_t worker = 0, worker_end = s_workers.size(); worker < worker_end; ++worker) {
+		out << "    {";
+
+		for(int phase = 0; phase < NumStatsPhases; ++phase) {
+			out << " \"" << PhaseNames[phase] << "\": { \"wall_seconds\": " << ToSeconds(s_workers[worker].wall[phase])
+				<< ", \"cpu_seconds\": " << ToSeconds(s_workers[worker].cpu[phase]) << " }" << (phase + 1 < NumStatsPhases ? "," : "");
+		}
+
+		out << " }" << (worker + 1 < worker_end ? "," : "") << "\n";
+	}
+
+	out << "  ],\n";
+	out << "  \"counters\": {\n";
+
+	for(int counter = 0; counter < NumStatsCounters; ++counter)
+		out << "    \"" << CounterNames[counter] << "\": " << s_counters[counter].load() << (counter + 1 < NumStatsCounters ? "," : "") << "\n";
+
+	out << "  }\n";
+	out << "}\n";
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <ostream>
+
+//
+//	Run instrumentation for --stats. Time is charged to a phase by
+//	holding a PhaseTimer for it, and is kept per worker: the main thread
+//	is worker 0 and ParallelFor's workers are 1 to N, so repeated
+//	parallel loops add up on the same rows. Phase wall times are summed
+//	over workers, so with several jobs they can exceed the run's wall time.
+//
+//	Everything is a no-op until EnableStats is called.
+//
+
+enum StatsPhase
+{
+	PhasePELoad,
+	PhasePDBLoad,
+	PhaseDecode,
+	PhaseAnnotate,
+	PhaseOutput,
+	NumStatsPhases
+};
+
+enum StatsCounter
+{
+	CounterFunctions,
+	CounterInstructions,
+	CounterInvalidResyncs,
+	CounterBytesWritten,
+	NumStatsCounters
+};
+
+class PhaseTimer
+{
+public:
+	explicit PhaseTimer(StatsPhase phase);
+	~PhaseTimer();
+
+	// charges the time so far and stops; the destructor then does nothing
+	void					Stop();
+
+private:
+	PhaseTimer(const PhaseTimer&);
+	PhaseTimer&		operator=(const PhaseTimer&);
+
+	StatsPhase				m_phase;
+	bool					m_bActive;
+	unsigned long long		m_wallStart;
+	unsigned long long		m_cpuStart;
+};
+
+void	EnableStats();
+bool	IsStatsEnabled();
+
+// called by each ParallelFor worker before it takes any work
+void	SetStatsWorker(unsigned int worker);
+void	AddStatsCounter(StatsCounter counter, unsigned long long amount);
+
+void	WriteStatsText(std::wostream& out);
+void	WriteStatsJSON(std::ostream& out);
+
+#endif
\ No newline at end of file
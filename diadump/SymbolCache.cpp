@@ -0,0 +1,346 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <stdio.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string.h>
+#include "BinaryReader.h"
+#include "MappedFile.h"
+#include "TypeStream.h"
+#include "Utility.h"
+#include "SymbolCache.h"
+
+using namespace std;
+
+//
+//	File layout, all little-endian:
+//
+//	header		magic, version, PDB GUID, PDB age, image timestamp
+//	types		count, then the TPI index behind each TypeId in order,
+//				then the record count and the offset of each TPI record,
+//				then the size and raw bytes of the TPI stream
+//	compilands	count, then each name
+//	functions	count, then each function and its variables
+//	trailer		magic again, so a half-written file is never used
+//
+//	Strings are stored as NUL-terminated UTF-8. Everything up to the TPI
+//	bytes is a whole number of u32s, so the record offsets stay aligned
+//	and the type stream is used in place from the mapped file.
+//
+
+static const unsigned int CacheMagic = 0x43534444;	// "DDSC"
+static const unsigned int CacheVersion = 2;
+
+// batch workers in one process can save the same cache at once, so the
+// temporary file name needs more than the process id to be unique
+static atomic<unsigned int> s_nextTempFile(0);
+
+template<typename T>
+static void Write(vector<unsigned char>& buf, T value)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+	buf.insert(buf.end(), bytes, bytes + sizeof(T));
+}
+
+// replaces to in one step, so nobody ever opens a half-written cache
+static bool MoveOverFile(const wstring& from, const wstring& to)
+{
+#ifdef _WIN32
+	return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(WideToUtf8(from).c_str(), WideToUtf8(to).c_str()) == 0;
+#endif
+}
+
+static void RemoveFile(const wstring& path)
+{
+#ifdef _WIN32
+	DeleteFileW(path.c_str());
+#else
+	unlink(WideToUtf8(path).c_str());
+#endif
+}
+
+static void WriteString(vector<unsigned char>& buf, const wstring& str)
+{
+	string utf8 = WideToUtf8(str);
+
+	buf.insert(buf.end(), utf8.begin(), utf8.end());
+	buf.push_back(0);
+}
+
+static void WriteVariables(vector<unsigned char>& buf, const vector<Variable>& variables)
+{
+	Write<unsigned int>(buf, static_cast<unsigned int>(variables.size()));
+
+	for(vector<Variable>::const_iterator var = variables.begin(), var_end = variables.end();
+		var != var_end; ++var) {
+
+			Write<unsigned int>(buf, var->location);
+			Write<long long>(buf, var->offset);
+			Write<unsigned int>(buf, var->section);
+			Write<unsigned long long>(buf, var->szSize);
+			Write<unsigned int>(buf, var->eRegister);
+			Write<unsigned int>(buf, var->type);
+			WriteString(buf, var->name);
+	}
+}
+
+static void ReadVariables(BinaryReader& reader, vector<Variable>& variables)
+{
+	unsigned int numVariables = reader.Read<unsigned int>();
+
+	// each variable takes at least this many bytes, so a corrupt
+	// count fails the bounds check instead of a huge allocation
+	if(numVariables > reader.Remaining() / 33)
+		throw runtime_error("Corrupt symbol cache.");
+
+	variables.resize(numVariables);
+
+	for(vector<Variable>::iterator var = variables.begin(), var_end = variables.end();
+		var != var_end; ++var) {
+
+			var->location = static_cast<VariableLocation>(reader.Read<unsigned int>());
+			var->offset = reader.Read<long long>();
+			var->section = reader.Read<unsigned int>();
+			var->szSize = reader.Read<unsigned long long>();
+			var->eRegister = static_cast<CV_HREG_e>(reader.Read<unsigned int>());
+			var->type = reader.Read<unsigned int>();
+			var->name = Utf8ToWide(reader.ReadCString());
+	}
+}
+
+SymbolCache::SymbolCache(const wstring& cacheDir, const CodeViewInfo& cvInfo, unsigned long timeDateStamp)
+	: m_cvInfo(cvInfo), m_timeDateStamp(timeDateStamp)
+{
+	static const wchar_t hexDigits[] = L"0123456789ABCDEF";
+
+	wstring name;
+
+	for(size_t i = 0; i < sizeof(cvInfo.guid); ++i) {
+		name += hexDigits[cvInfo.guid[i] >> 4];
+		name += hexDigits[cvInfo.guid[i] & 0xF];
+	}
+
+	wchar_t suffix[32];
+	swprintf(suffix, sizeof(suffix) / sizeof(suffix[0]), L"-%X-%08X.dsc", static_cast<unsigned int>(cvInfo.age), static_cast<unsigned int>(timeDateStamp));
+	name += suffix;
+
+	m_path = JoinPath(cacheDir, name);
+}
+
+const wstring& SymbolCache::GetPath() const
+{
+	return m_path;
+}
+
+bool SymbolCache::Load(vector<Function>& functions, shared_ptr<TypeTable>& types) const
+{
+	shared_ptr<MappedFile> file;
+
+	try {
+		file = shared_ptr<MappedFile>(new MappedFile(m_path));
+	} catch(const runtime_error&) {
+		return false;
+	}
+
+	// anything wrong with the file just means we go back to the PDB
+	try {
+		BinaryReader reader(file->GetData(), file->GetSize());
+
+		if(reader.Read<unsigned int>() != CacheMagic || reader.Read<unsigned int>() != CacheVersion)
+			return false;
+
+		unsigned char guid[16];
+		reader.ReadBytes(guid, sizeof(guid));
+
+		if(memcmp(guid, m_cvInfo.guid, sizeof(guid)) != 0 ||
+			reader.Read<unsigned int>() != m_cvInfo.age ||
+			reader.Read<unsigned int>() != m_timeDateStamp)
+				return false;
+
+		unsigned int numTypes = reader.Read<unsigned int>();
+
+		if(numTypes > reader.Remaining() / sizeof(unsigned int))
+			return false;
+
+		vector<unsigned int> typeIndices(numTypes);
+
+		if(numTypes)
+			reader.ReadBytes(&typeIndices[0], numTypes * sizeof(unsigned int));
+
+		unsigned int numRecords = reader.Read<unsigned int>();
+
+		if(numRecords > reader.Remaining() / sizeof(unsigned int))
+			return false;
+
+		const unsigned int* recordOffsets = reinterpret_cast<const unsigned int*>(reader.Current());
+		reader.Skip(numRecords * sizeof(unsigned int));
+
+		ByteSpan tpiData;
+		tpiData.size = reader.Read<unsigned int>();
+		tpiData.data = reader.Current();
+
+		if(tpiData.size > reader.Remaining())
+			return false;
+
+		// the records are read straight out of the mapping, which the
+		// stream keeps alive for as long as the types are in use
+		shared_ptr<TypeStream> tpi(new TypeStream(file, tpiData, recordOffsets, numRecords));
+		reader.Skip(tpiData.size);
+
+		// interning the same indices in the same order gives back the
+		// same TypeIds the cached variables refer to
+		shared_ptr<TypeTable> loadedTypes(new TypeTable(tpi));
+
+		for(unsigned int typeNum = 0; typeNum < numTypes; ++typeNum) {
+			if(loadedTypes->Intern(typeIndices[typeNum]) != typeNum)
+				return false;
+		}
+
+		unsigned int numCompilands = reader.Read<unsigned int>();
+
+		if(numCompilands > reader.Remaining())
+			return false;
+
+		vector<wstring> compilands(numCompilands);
+
+		for(unsigned int compilandNum = 0; compilandNum < numCompilands; ++compilandNum)
+			compilands[compilandNum] = Utf8ToWide(reader.ReadCString());
+
+		unsigned int numFunctions = reader.Read<unsigned int>();
+
+		if(numFunctions > reader.Remaining())
+			return false;
+
+		vector<Function> loadedFunctions(numFunctions);
+
+		for(vector<Function>::iterator func = loadedFunctions.begin(), func_end = loadedFunctions.end();
+			func != func_end; ++func) {
+
+				unsigned int compilandNum = reader.Read<unsigned int>();
+
+				if(compilandNum >= numCompilands)
+					return false;
+
+				func->compiland = compilands[compilandNum];
+				func->name = Utf8ToWide(reader.ReadCString());
+				func->length = reader.Read<unsigned long long>();
+				func->address = reader.Read<unsigned int>();
+
+				ReadVariables(reader, func->parameters);
+				ReadVariables(reader, func->localVariables);
+		}
+
+		if(reader.Read<unsigned int>() != CacheMagic)
+			return false;
+
+		functions.swap(loadedFunctions);
+		types = loadedTypes;
+	} catch(const runtime_error&) {
+		return false;
+	}
+
+	return true;
+}
+
+bool SymbolCache::Save(const vector<Function>& functions, const TypeTable& types) const
+{
+	vector<unsigned char> buf;
+
+	Write<unsigned int>(buf, CacheMagic);
+	Write<unsigned int>(buf, CacheVersion);
+	buf.insert(buf.end(), m_cvInfo.guid, m_cvInfo.guid + sizeof(m_cvInfo.guid));
+	Write<unsigned int>(buf, static_cast<unsigned int>(m_cvInfo.age));
+	Write<unsigned int>(buf, static_cast<unsigned int>(m_timeDateStamp));
+
+	size_t numTypes = types.GetNumTypes();
+	Write<unsigned int>(buf, static_cast<unsigned int>(numTypes));
+
+	for(size_t typeNum = 0; typeNum < numTypes; ++typeNum)
+		Write<unsigned int>(buf, types.GetTypeIndex(static_cast<TypeId>(typeNum)));
+
+	const TypeStream&	tpi = types.GetTypeStream();
+	const ByteSpan&		tpiData = tpi.GetData();
+
+	Write<unsigned int>(buf, static_cast<unsigned int>(tpi.GetNumRecords()));
+
+	for(size_t recordNum = 0, numRecords = tpi.GetNumRecords(); recordNum < numRecords; ++recordNum)
+		Write<unsigned int>(buf, tpi.GetRecordOffsets()[recordNum]);
+
+	Write<unsigned int>(buf, static_cast<unsigned int>(tpiData.size));
+	buf.insert(buf.end(), tpiData.data, tpiData.data + tpiData.size);
+
+	// most compilands have many functions, store each name once
+	map<wstring, unsigned int>	compilandIndices;
+	vector<const wstring*>		compilands;
+
+	for(vector<Function>::const_iterator func = functions.begin(), func_end = functions.end();
+		func != func_end; ++func) {
+
+			if(compilandIndices.insert(make_pair(func->compiland, static_cast<unsigned int>(compilands.size()))).second)
+				compilands.push_back(&func->compiland);
+	}
+
+	Write<unsigned int>(buf, static_cast<unsigned int>(compilands.size()));
+
+	for(vector<const wstring*>::const_iterator i = compilands.begin(), i_end = compilands.end(); i != i_end; ++i)
+		WriteString(buf, **i);
+
+	Write<unsigned int>(buf, static_cast<unsigned int>(functions.size()));
+
+	for(vector<Function>::const_iterator func = functions.begin(), func_end = functions.end();
+		func != func_end; ++func) {
+
+			Write<unsigned int>(buf, compilandIndices[func->compiland]);
+			WriteString(buf, func->name);
+			Write<unsigned long long>(buf, func->length);
+			Write<unsigned int>(buf, func->address);
+
+			WriteVariables(buf, func->parameters);
+			WriteVariables(buf, func->localVariables);
+	}
+
+	Write<unsigned int>(buf, CacheMagic);
+
+	// written next to the cache under a name only this save uses, then
+	// moved over it, so neither other runs nor other batch workers saving
+	// the same PDB ever see a torn file
+	wchar_t tempSuffix[48];
+	swprintf(tempSuffix, sizeof(tempSuffix) / sizeof(tempSuffix[0]), L".%u.%u.tmp",
+		static_cast<unsigned int>(getpid()), s_nextTempFile++);
+
+	wstring tempPath = m_path + tempSuffix;
+
+	{
+		ofstream cacheFile(NativePath(tempPath).c_str(), ios::out | ios::binary | ios::trunc);
+
+		if(!cacheFile)
+			return false;
+
+		cacheFile.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+		cacheFile.close();
+
+		if(!cacheFile) {
+			RemoveFile(tempPath);
+			return false;
+		}
+	}
+
+	if(!MoveOverFile(tempPath, m_path)) {
+		// most likely another run has the cache mapped; theirs is just as good
+		RemoveFile(tempPath);
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
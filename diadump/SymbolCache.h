@@ -0,0 +1,32 @@
+#ifndef __SYMBOLCACHE_H__
+#define __SYMBOLCACHE_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PDB.h"
+
+//
+//	On-disk copy of everything PDB pulls out of a PDB file: functions,
+//	their variables and the type table. The file name carries the PDB
+//	GUID and age plus the image's link timestamp, so a rebuilt image
+//	never picks up a stale cache. Load maps the file and reads the type
+//	records in place; functions and variables are decoded into vectors.
+//
+class SymbolCache
+{
+public:
+	SymbolCache(const std::wstring& cacheDir, const CodeViewInfo& cvInfo, unsigned long timeDateStamp);
+
+	bool								Load(std::vector<Function>& functions, std::shared_ptr<TypeTable>& types) const;
+	bool								Save(const std::vector<Function>& functions, const TypeTable& types) const;
+	const std::wstring&					GetPath() const;
+
+private:
+	std::wstring						m_path;
+	CodeViewInfo						m_cvInfo;
+	unsigned long						m_timeDateStamp;
+};
+
+#endif
\ No newline at end of file
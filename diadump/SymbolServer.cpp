@@ -0,0 +1,472 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef SOCKET SocketHandle;
+typedef WSAPOLLFD PollDescriptor;
+#define CloseSocket closesocket
+#define PollSockets WSAPoll
+#else
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int SocketHandle;
+typedef pollfd PollDescriptor;
+#define INVALID_SOCKET -1
+#define CloseSocket close
+#define PollSockets poll
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include "Disassembler.h"
+#include "Utility.h"
+#include "SymbolServer.h"
+
+using namespace std;
+
+static const unsigned long RequestMagic = 0x51534444;	// 'DDSQ'
+static const unsigned long ResponseMagic = 0x52534444;	// 'DDSR'
+static const size_t RequestHeaderSize = 16;
+
+// keeps a hostile or broken client from making us allocate without bound
+static const unsigned long MaxPathLength = 32 * 1024;
+static const unsigned long MaxQueriesPerRequest = 1024 * 1024;
+
+// connections are multiplexed on the one server thread; past this many,
+// new clients wait in the listen backlog until a slot frees up
+static const size_t MaxClients = 64;
+static const int PollIntervalMilliseconds = 1000;
+
+// a client that sends nothing for this long is dropped to free its slot,
+// and one that stops reading its responses can only stall the others this long
+static const long long ClientIdleSeconds = 300;
+static const int ClientSendTimeoutMilliseconds = 10000;
+
+// a persistent accept failure (out of descriptors, say) backs off between
+// these delays, and the server gives up after this many in a row
+static const int AcceptRetryMinMilliseconds = 10;
+static const int AcceptRetryMaxMilliseconds = 1000;
+static const unsigned int MaxAcceptFailures = 100;
+
+enum PendingRequest
+{
+	RequestIncomplete,
+	RequestComplete,
+	RequestMalformed
+};
+
+typedef struct
+{
+	SocketHandle							socket;
+	bool									bClosed;
+	std::chrono::steady_clock::time_point	lastActivity;
+
+	// bytes received but not yet handled; may hold a partial request
+	std::vector<unsigned char>				pending;
+} ClientConnection;
+
+static unsigned long ReadU32(const unsigned char* data)
+{
+	return static_cast<unsigned long>(data[0]) | (static_cast<unsigned long>(data[1]) << 8) |
+		(static_cast<unsigned long>(data[2]) << 16) | (static_cast<unsigned long>(data[3]) << 24);
+}
+
+static void WriteU32(vector<unsigned char>& out, unsigned long value)
+{
+	for(int i = 0; i < 4; ++i)
+		out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+}
+
+static void WriteU64(vector<unsigned char>& out, unsigned long long value)
+{
+	for(int i = 0; i < 8; ++i)
+		out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+}
+
+static void WriteString(vector<unsigned char>& out, const string& str)
+{
+	WriteU32(out, static_cast<unsigned long>(str.length()));
+	out.insert(out.end(), str.begin(), str.end());
+}
+
+static void WriteError(vector<unsigned char>& out, const string& message)
+{
+	out.clear();
+	WriteU32(out, ResponseMagic);
+	WriteU32(out, SymbolStatusError);
+	WriteString(out, message);
+}
+
+// says whether pending starts with a whole request, and if so how long it is
+static PendingRequest CheckPendingRequest(const vector<unsigned char>& pending, size_t& r_requestSize)
+{
+	if(pending.size() < RequestHeaderSize)
+		return RequestIncomplete;
+
+	unsigned long numQueries = ReadU32(&pending[8]);
+	unsigned long pathLength = ReadU32(&pending[12]);
+
+	if(ReadU32(&pending[0]) != RequestMagic || numQueries > MaxQueriesPerRequest || pathLength > MaxPathLength)
+		return RequestMalformed;
+
+	r_requestSize = RequestHeaderSize + pathLength + numQueries * 4;
+
+	return pending.size() >= r_requestSize ? RequestComplete : RequestIncomplete;
+}
+
+static void SetSendTimeout(SocketHandle sock, int milliseconds)
+{
+#ifdef _WIN32
+	DWORD timeout = milliseconds;
+#else
+	timeval timeout;
+	timeout.tv_sec = milliseconds / 1000;
+	timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+static PollDescriptor MakePollDescriptor(SocketHandle sock, bool bWantRead)
+{
+	PollDescriptor descriptor;
+
+	memset(&descriptor, 0, sizeof(descriptor));
+	descriptor.fd = sock;
+	descriptor.events = bWantRead ? POLLIN : 0;
+
+	return descriptor;
+}
+
+static bool SendAll(SocketHandle sock, const unsigned char* data, size_t length)
+{
+	while(length) {
+		int chunk = static_cast<int>(length < 0x10000 ? length : 0x10000);
+		int sent = send(sock, reinterpret_cast<const char*>(data), chunk, 0);
+
+		if(sent <= 0)
+			return false;
+
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
+
+SymbolServer::SymbolServer(size_t cacheSize, const wstring& symbolCacheDir)
+	: m_cacheSize(cacheSize ? cacheSize : 1), m_symbolCacheDir(symbolCacheDir)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+const SymbolServerStats& SymbolServer::GetStats() const
+{
+	return m_stats;
+}
+
+void SymbolServer::Run(const wstring& socketPath)
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+
+	if(WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		throw runtime_error("Unable to initialize Winsock");
+#endif
+
+	string path = WideToUtf8(socketPath);
+	sockaddr_un addr;
+
+	if(path.length() >= sizeof(addr.sun_path))
+		throw runtime_error("Socket path is too long");
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.length());
+
+	SocketHandle listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	if(listener == INVALID_SOCKET)
+		throw runtime_error("Unable to create socket");
+
+	// a socket file left behind by an earlier run would make bind fail
+	remove(path.c_str());
+
+	if(bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listener, 16) != 0) {
+		CloseSocket(listener);
+		throw runtime_error("Unable to listen on " + path);
+	}
+
+	wcout << L"Listening on " << socketPath << endl;
+
+	vector<ClientConnection>	clients;
+	vector<PollDescriptor>		descriptors;
+	vector<unsigned char>		receiveBuffer(0x10000);
+	vector<unsigned char>		request;
+	vector<unsigned char>		response;
+	unsigned int				acceptFailures = 0;
+	int							acceptRetryMilliseconds = AcceptRetryMinMilliseconds;
+	bool						bRunning = true;
+	const char*					failure = NULL;
+
+	// one thread serves every connection, so the image cache and stats need no
+	// locking; a client only holds the others up while its own request runs
+	while(bRunning) {
+		bool bListening = clients.size() < MaxClients;
+
+		descriptors.clear();
+		descriptors.push_back(MakePollDescriptor(listener, bListening));
+
+		for(vector<ClientConnection>::const_iterator i = clients.begin(), i_end = clients.end(); i != i_end; ++i)
+			descriptors.push_back(MakePollDescriptor(i->socket, true));
+
+		if(PollSockets(&descriptors[0], static_cast<unsigned long>(descriptors.size()), PollIntervalMilliseconds) < 0) {
+#ifndef _WIN32
+			if(errno == EINTR)
+				continue;
+#endif
+			failure = "Unable to poll client sockets";
+			break;
+		}
+
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+		for(size_t clientNum = 0, numPolled = clients.size(); clientNum < numPolled && bRunning; ++clientNum) {
+			ClientConnection& client = clients[clientNum];
+
+			if(!descriptors[clientNum + 1].revents) {
+				if(now - client.lastActivity > chrono::seconds(ClientIdleSeconds))
+					client.bClosed = true;
+				continue;
+			}
+
+			// readable, hung up or failed; recv tells them apart
+			int received = recv(client.socket, reinterpret_cast<char*>(&receiveBuffer[0]), static_cast<int>(receiveBuffer.size()), 0);
+
+			if(received <= 0) {
+				client.bClosed = true;
+				continue;
+			}
+
+			client.lastActivity = now;
+			client.pending.insert(client.pending.end(), receiveBuffer.begin(), receiveBuffer.begin() + received);
+
+			// a client may send several requests back to back
+			while(bRunning && !client.bClosed) {
+				size_t			requestSize;
+				PendingRequest	pendingState = CheckPendingRequest(client.pending, requestSize);
+
+				if(pendingState == RequestIncomplete)
+					break;
+
+				if(pendingState == RequestMalformed) {
+					WriteError(response, "Malformed request");
+					SendAll(client.socket, &response[0], response.size());
+					client.bClosed = true;
+					break;
+				}
+
+				chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+				request.assign(client.pending.begin(), client.pending.begin() + requestSize);
+				client.pending.erase(client.pending.begin(), client.pending.begin() + requestSize);
+
+				unsigned long numQueries = ReadU32(&request[8]);
+
+				bRunning = HandleRequest(request, response);
+
+				if(!SendAll(client.socket, &response[0], response.size())) {
+					client.bClosed = true;
+					break;
+				}
+
+				unsigned long long microseconds = chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - start).count();
+
+				++m_stats.numRequests;
+				m_stats.numQueries += numQueries;
+				m_stats.totalMicroseconds += microseconds;
+				m_stats.maxMicroseconds = max(m_stats.maxMicroseconds, microseconds);
+				m_stats.bytesIn += request.size();
+				m_stats.bytesOut += response.size();
+			}
+		}
+
+		for(size_t clientNum = 0; clientNum < clients.size();) {
+			if(clients[clientNum].bClosed) {
+				CloseSocket(clients[clientNum].socket);
+				clients.erase(clients.begin() + clientNum);
+			} else {
+				++clientNum;
+			}
+		}
+
+		if(!bRunning || !bListening || !descriptors[0].revents)
+			continue;
+
+		SocketHandle clientSocket = accept(listener, NULL, NULL);
+
+		if(clientSocket == INVALID_SOCKET) {
+			if(++acceptFailures >= MaxAcceptFailures) {
+				failure = "Repeated failures accepting clients";
+				break;
+			}
+
+			this_thread::sleep_for(chrono::milliseconds(acceptRetryMilliseconds));
+			acceptRetryMilliseconds = min(acceptRetryMilliseconds * 2, AcceptRetryMaxMilliseconds);
+			continue;
+		}
+
+		acceptFailures = 0;
+		acceptRetryMilliseconds = AcceptRetryMinMilliseconds;
+
+		SetSendTimeout(clientSocket, ClientSendTimeoutMilliseconds);
+
+		ClientConnection connection;
+		connection.socket = clientSocket;
+		connection.bClosed = false;
+		connection.lastActivity = now;
+		clients.push_back(connection);
+	}
+
+	for(vector<ClientConnection>::const_iterator i = clients.begin(), i_end = clients.end(); i != i_end; ++i)
+		CloseSocket(i->socket);
+
+	CloseSocket(listener);
+	remove(path.c_str());
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+
+	if(failure)
+		throw runtime_error(failure);
+}
+
+SymbolServer::ImagePtr SymbolServer::GetImage(const wstring& imageFilename)
+{
+	map<wstring, ImageList::iterator>::iterator found = m_imageIndex.find(imageFilename);
+
+	if(found != m_imageIndex.end()) {
+		++m_stats.cacheHits;
+		m_images.splice(m_images.begin(), m_images, found->second);
+		return m_images.front().second;
+	}
+
+	++m_stats.cacheMisses;
+
+	ImagePtr image(new Disassembler(imageFilename.c_str(), m_symbolCacheDir));
+
+	if(m_images.size() >= m_cacheSize) {
+		m_imageIndex.erase(m_images.back().first);
+		m_images.pop_back();
+	}
+
+	m_images.push_front(make_pair(imageFilename, image));
+	m_imageIndex[imageFilename] = m_images.begin();
+
+	return image;
+}
+
+bool SymbolServer::HandleRequest(const vector<unsigned char>& request, vector<unsigned char>& response)
+{
+	response.clear();
+
+	unsigned long type = ReadU32(&request[4]);
+	unsigned long numQueries = ReadU32(&request[8]);
+	unsigned long pathLength = ReadU32(&request[12]);
+
+	switch(type) {
+	case SymbolRequestQuery:
+		try {
+			const char*		pathStart = reinterpret_cast<const char*>(&request[0]) + RequestHeaderSize;
+			wstring			imageFilename = Utf8ToWide(string(pathStart, pathLength));
+
+			vector<unsigned long> rvas(numQueries);
+
+			for(unsigned long i = 0; i < numQueries; ++i)
+				rvas[i] = ReadU32(&request[RequestHeaderSize + pathLength + i * 4]);
+
+			Query(imageFilename, rvas, response);
+		} catch(const exception& e) {
+			WriteError(response, e.what());
+		}
+		return true;
+
+	case SymbolRequestStats:
+		WriteU32(response, ResponseMagic);
+		WriteU32(response, SymbolStatusOK);
+		WriteU64(response, m_stats.numRequests);
+		WriteU64(response, m_stats.numQueries);
+		WriteU64(response, m_stats.totalMicroseconds);
+		WriteU64(response, m_stats.maxMicroseconds);
+		WriteU64(response, m_stats.bytesIn);
+		WriteU64(response, m_stats.bytesOut);
+		WriteU64(response, m_stats.cacheHits);
+		WriteU64(response, m_stats.cacheMisses);
+		WriteU64(response, m_images.size());
+		return true;
+
+	case SymbolRequestShutdown:
+		WriteU32(response, ResponseMagic);
+		WriteU32(response, SymbolStatusOK);
+		return false;
+
+	default:
+		WriteError(response, "Unknown request type");
+		return true;
+	}
+}
+
+void SymbolServer::Query(const wstring& imageFilename, const vector<unsigned long>& rvas, vector<unsigned char>& response)
+{
+	ImagePtr image = GetImage(imageFilename);
+
+	// look the whole batch up in one sorted pass over the function index
+	vector<unsigned long long> sortedRVAs(rvas.begin(), rvas.end());
+	sort(sortedRVAs.begin(), sortedRVAs.end());
+
+	vector<const Function*> sortedFunctions;
+	image->GetPDB().FindFunctions(sortedRVAs, sortedFunctions);
+
+	WriteU32(response, ResponseMagic);
+	WriteU32(response, SymbolStatusOK);
+	WriteU32(response, static_cast<unsigned long>(rvas.size()));
+
+	AddressInfo info;
+
+	for(vector<unsigned long>::const_iterator i = rvas.begin(), i_end = rvas.end(); i != i_end; ++i) {
+		size_t				sortedIndex = lower_bound(sortedRVAs.begin(), sortedRVAs.end(), *i) - sortedRVAs.begin();
+		const Function*		func = sortedFunctions[sortedIndex];
+		unsigned long		flags = 0;
+
+		if(func) {
+			image->DescribeAddress(*i, func, info);
+
+			flags |= SymbolResultFunction;
+
+			if(info.bFoundInstruction)
+				flags |= SymbolResultInstruction;
+
+			if(info.bFoundVariable)
+				flags |= SymbolResultVariable;
+		}
+
+		WriteU32(response, *i);
+		WriteU32(response, flags);
+		WriteU32(response, func ? info.functionRVA : 0);
+		WriteU32(response, func ? info.instructionRVA : 0);
+		WriteString(response, func ? WideToUtf8(info.functionName) : string());
+		WriteString(response, func ? info.instruction : string());
+		WriteString(response, func ? WideToUtf8(info.variableName) : string());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef __SYMBOLSERVER_H__
+#define __SYMBOLSERVER_H__
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Disassembler;
+
+//
+//	Resident symbolization server. Loaded images (PE plus PDB, held as a
+//	Disassembler) stay in memory in an LRU of at most cacheSize entries,
+//	so repeated questions about the same build only pay the PDB load once.
+//
+//	Clients connect to a local AF_UNIX socket and send requests in a small
+//	little-endian binary protocol; a connection may carry any number of
+//	requests and is served until the client closes it. Connections are
+//	polled together on the server thread, so an idle client doesn't keep
+//	others waiting; one that stays silent for five minutes is dropped.
+//
+//	Request:
+//		u32 magic 'DDSQ'
+//		u32 type (SymbolRequestQuery, SymbolRequestStats, SymbolRequestShutdown)
+//		u32 count of RVAs
+//		u32 length of the image path, then the UTF-8 path
+//		u32 RVAs[count]
+//
+//	Response:
+//		u32 magic 'DDSR'
+//		u32 status (SymbolStatusOK or SymbolStatusError)
+//		on error:	u32 length, UTF-8 message
+//		for stats:	u64 requests, queries, total latency (us), max latency (us),
+//					bytes in, bytes out, cache hits, cache misses, images loaded
+//		for query:	u32 count, then per RVA
+//					u32 rva, u32 SymbolResult flags, u32 function RVA, u32 instruction RVA,
+//					u32 length + UTF-8 function name, instruction text and variable name
+//
+
+enum SymbolRequestType
+{
+	SymbolRequestQuery = 1,
+	SymbolRequestStats = 2,
+	SymbolRequestShutdown = 3
+};
+
+enum SymbolStatus
+{
+	SymbolStatusOK = 0,
+	SymbolStatusError = 1
+};
+
+enum SymbolResult
+{
+	SymbolResultFunction = 0x1,
+	SymbolResultInstruction = 0x2,
+	SymbolResultVariable = 0x4
+};
+
+typedef struct
+{
+	unsigned long long	numRequests;
+	unsigned long long	numQueries;
+	unsigned long long	totalMicroseconds;
+	unsigned long long	maxMicroseconds;
+	unsigned long long	bytesIn;
+	unsigned long long	bytesOut;
+	unsigned long long	cacheHits;
+	unsigned long long	cacheMisses;
+} SymbolServerStats;
+
+class SymbolServer
+{
+public:
+	SymbolServer(size_t cacheSize, const std::wstring& symbolCacheDir = std::wstring());
+
+	// blocks serving clients until a shutdown request arrives
+	void												Run(const std::wstring& socketPath);
+	const SymbolServerStats&							GetStats() const;
+
+private:
+	SymbolServer(const SymbolServer&);
+	SymbolServer&										operator=(const SymbolServer&);
+
+	typedef std::shared_ptr<Disassembler>			ImagePtr;
+	typedef std::list<std::pair<std::wstring, ImagePtr> >	ImageList;
+
+	ImagePtr											GetImage(const std::wstring& imageFilename);
+	bool												HandleRequest(const std::vector<unsigned char>& request, std::vector<unsigned char>& response);
+	void												Query(const std::wstring& imageFilename, const std::vector<unsigned long>& rvas, std::vector<unsigned char>& response);
+
+	size_t												m_cacheSize;
+	std::wstring										m_symbolCacheDir;
+	SymbolServerStats									m_stats;
+
+	// most recently used image at the front
+	ImageList											m_images;
+	std::map<std::wstring, ImageList::iterator>			m_imageIndex;
+};
+
+#endif
\ No newline at end of file
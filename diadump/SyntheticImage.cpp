@@ -0,0 +1,690 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+#include <vector>
+#include "CVConst.h"
+#include "CodeView.h"
+#include "PEFormat.h"
+#include "Utility.h"
+#include "SyntheticImage.h"
+
+using namespace std;
+using namespace CodeView;
+
+static const unsigned long	HeadersSize = 0x400;
+static const unsigned long	FileAlignment = 0x200;
+static const unsigned long	SectionAlignment = 0x1000;
+static const unsigned long	TextRVA = 0x1000;
+static const unsigned long	FunctionAlignment = 16;
+static const unsigned long	MSFBlockSize = 0x1000;
+static const unsigned long	ProcTypeIndex = FirstNonSimpleTypeIndex;
+static const unsigned short	NoStream = 0xFFFF;
+
+// the variable types handed out in turn: int, unsigned long, int*
+static const unsigned long	VariableTypes32[] = { 0x0074, 0x0022, 0x0474 };
+static const unsigned long	VariableTypes64[] = { 0x0074, 0x0022, 0x0674 };
+
+static const char			MSFMagic[] = "Microsoft C/C++ MSF 7.00\r\n\x1a" "DS\0\0";
+
+// register only instructions the same in both modes: add eax, ecx; xor edx, edx;
+// mov ecx, eax; imul eax, ecx; shl eax, 3; test eax, eax; nop
+static const unsigned char	ArithmeticInstrs[][4] =
+{
+	{ 2, 0x03, 0xC1 },
+	{ 2, 0x33, 0xD2 },
+	{ 2, 0x8B, 0xC8 },
+	{ 3, 0x0F, 0xAF, 0xC1 },
+	{ 3, 0xC1, 0xE0, 0x03 },
+	{ 2, 0x85, 0xC0 },
+	{ 1, 0x90 }
+};
+
+// a tiny xorshift generator; unlike <random>'s distributions it
+// gives the same numbers on every compiler, so images are reproducible
+class SyntheticRandom
+{
+public:
+	explicit SyntheticRandom(unsigned long seed)
+		: m_state(seed ? seed : 0x9E3779B9)
+	{
+	}
+
+	unsigned long Next()
+	{
+		m_state ^= m_state << 13;
+		m_state ^= m_state >> 17;
+		m_state ^= m_state << 5;
+		m_state &= 0xFFFFFFFF;
+		return m_state;
+	}
+
+	// uniform over [low, high]
+	unsigned long Range(unsigned long low, unsigned long high)
+	{
+		return high <= low ? low : low + Next() % (high - low + 1);
+	}
+
+private:
+	unsigned long m_state;
+};
+
+typedef struct
+{
+	size_t			patchOffset;
+	size_t			nextInstrOffset;
+	unsigned int	target;
+} CodeFixup;
+
+static void Put8(vector<unsigned char>& out, unsigned long value)
+{
+	out.push_back(static_cast<unsigned char>(value));
+}
+
+static void Put16(vector<unsigned char>& out, unsigned long value)
+{
+	out.push_back(static_cast<unsigned char>(value));
+	out.push_back(static_cast<unsigned char>(value >> 8));
+}
+
+static void Put32(vector<unsigned char>& out, unsigned long value)
+{
+	for(int i = 0; i < 4; ++i)
+		out.push_back(static_cast<unsigned char>(value >> (i * 8)));
+}
+
+static void Patch32(vector<unsigned char>& out, size_t offset, unsigned long value)
+{
+	for(int i = 0; i < 4; ++i)
+		out[offset + i] = static_cast<unsigned char>(value >> (i * 8));
+}
+
+static void PutCString(vector<unsigned char>& out, const string& str)
+{
+	out.insert(out.end(), str.begin(), str.end());
+	out.push_back(0);
+}
+
+static void PadTo(vector<unsigned char>& out, size_t alignment, unsigned char fill)
+{
+	while(out.size() % alignment)
+		out.push_back(fill);
+}
+
+static unsigned long AlignUp(unsigned long value, unsigned long alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+// opcode /reg with an [rbp + disp] operand
+static void PutFrameAccess(vector<unsigned char>& code, bool bRexW, unsigned char opcode, unsigned char reg, long displacement)
+{
+	if(bRexW)
+		Put8(code, 0x48);
+
+	Put8(code, opcode);
+
+	if(displacement >= -128 && displacement <= 127) {
+		Put8(code, 0x40 | (reg << 3) | 5);
+		Put8(code, static_cast<unsigned long>(displacement));
+	} else {
+		Put8(code, 0x80 | (reg << 3) | 5);
+		Put32(code, static_cast<unsigned long>(displacement));
+	}
+}
+
+static long GetVariableOffset(const SyntheticImageOptions& options, unsigned int varNum)
+{
+	// parameters sit above the saved frame pointer and return address, locals below
+	if(varNum < options.numParameters)
+		return options.bIs64Bit ? 16 + 8 * varNum : 8 + 4 * varNum;
+
+	return -4 * static_cast<long>(varNum - options.numParameters + 1);
+}
+
+static string GetFunctionName(unsigned int funcNum, unsigned int compilandNum)
+{
+	ostringstream name;
+	name << "Module" << compilandNum << "::Function" << funcNum;
+	return name.str();
+}
+
+static void GenerateFunction(const SyntheticImageOptions& options, SyntheticRandom& random, unsigned int numFunctions, vector<unsigned char>& code, vector<CodeFixup>& calls)
+{
+	bool				bIs64Bit = options.bIs64Bit;
+	unsigned int		numVariables = options.numParameters + options.numLocals;
+	unsigned int		numInstrs = random.Range(options.minInstructions, options.maxInstructions);
+	vector<size_t>		instrOffsets;
+	vector<CodeFixup>	branches;
+
+	// push rbp; mov rbp, rsp; sub rsp, frameSize
+	Put8(code, 0x55);
+
+	if(bIs64Bit)
+		Put8(code, 0x48);
+
+	Put8(code, 0x8B);
+	Put8(code, 0xEC);
+
+	if(bIs64Bit)
+		Put8(code, 0x48);
+
+	Put8(code, 0x81);
+	Put8(code, 0xEC);
+	Put32(code, AlignUp(4 * options.numLocals, 16));
+
+	for(unsigned int instrNum = 0; instrNum < numInstrs; ++instrNum) {
+		unsigned long pick = random.Range(0, 99);
+
+		instrOffsets.push_back(code.size());
+
+		if(pick < options.memoryPercent && numVariables) {
+			long displacement = GetVariableOffset(options, random.Range(0, numVariables - 1));
+
+			// mov eax, [v]; mov [v], ecx; add edx, [v]; lea rax, [v]
+			switch(random.Range(0, 3)) {
+				case 0:		PutFrameAccess(code, false, 0x8B, 0, displacement); break;
+				case 1:		PutFrameAccess(code, false, 0x89, 1, displacement); break;
+				case 2:		PutFrameAccess(code, false, 0x03, 2, displacement); break;
+				default:	PutFrameAccess(code, bIs64Bit, 0x8D, 0, displacement); break;
+			}
+		} else if(pick < options.memoryPercent + options.branchPercent) {
+			// short jcc forward to a later instruction, or the epilogue
+			CodeFixup branch;
+
+			Put8(code, 0x70 | random.Range(0, 15));
+			Put8(code, 0);
+
+			branch.patchOffset = code.size() - 1;
+			branch.nextInstrOffset = code.size();
+			branch.target = instrNum + random.Range(1, 8);
+			branches.push_back(branch);
+		} else if(pick < options.memoryPercent + options.branchPercent + options.callPercent) {
+			// call rel32 to the start of some function
+			CodeFixup call;
+
+			Put8(code, 0xE8);
+			Put32(code, 0);
+
+			call.patchOffset = code.size() - 4;
+			call.nextInstrOffset = code.size();
+			call.target = random.Range(0, numFunctions - 1);
+			calls.push_back(call);
+		} else {
+			const unsigned char* instr = ArithmeticInstrs[random.Range(0, sizeof(ArithmeticInstrs) / sizeof(ArithmeticInstrs[0]) - 1)];
+			code.insert(code.end(), instr + 1, instr + 1 + instr[0]);
+		}
+	}
+
+	instrOffsets.push_back(code.size());
+
+	// mov rsp, rbp; pop rbp; ret
+	if(bIs64Bit)
+		Put8(code, 0x48);
+
+	Put8(code, 0x8B);
+	Put8(code, 0xE5);
+	Put8(code, 0x5D);
+	Put8(code, 0xC3);
+
+	// each short branch covers at most 8 instructions of at most 7 bytes, so rel8 always reaches
+	for(vector<CodeFixup>::const_iterator i = branches.begin(), i_end = branches.end(); i != i_end; ++i) {
+		size_t target = instrOffsets[i->target < numInstrs ? i->target : numInstrs];
+		code[i->patchOffset] = static_cast<unsigned char>(target - i->nextInstrOffset);
+	}
+}
+
+template<typename OptionalHeader>
+static void FillOptionalHeader(OptionalHeader& header, WORD magic, unsigned long long imageBase, unsigned long entryPoint, unsigned long codeSize, unsigned long imageSize)
+{
+	memset(&header, 0, sizeof(header));
+
+	header.Magic = magic;
+	header.AddressOfEntryPoint = entryPoint;
+	header.BaseOfCode = TextRVA;
+	header.SizeOfCode = codeSize;
+	header.ImageBase = imageBase;
+	header.SectionAlignment = SectionAlignment;
+	header.FileAlignment = FileAlignment;
+	header.MajorOperatingSystemVersion = 6;
+	header.MajorSubsystemVersion = 6;
+	header.SizeOfImage = imageSize;
+	header.SizeOfHeaders = HeadersSize;
+	header.Subsystem = IMAGE_SUBSYSTEM_WINDOWS_CUI;
+	header.NumberOfRvaAndSizes = IMAGE_NUMBEROF_DIRECTORY_ENTRIES;
+}
+
+static void BuildPE(const SyntheticImageOptions& options, const vector<unsigned char>& code, unsigned long entryPoint, const unsigned char* guid, unsigned long age, const string& pdbName, vector<unsigned char>& image)
+{
+	unsigned long textRawSize = AlignUp(static_cast<unsigned long>(code.size()), FileAlignment);
+	unsigned long rdataRVA = AlignUp(TextRVA + static_cast<unsigned long>(code.size()), SectionAlignment);
+	unsigned long rdataOffset = HeadersSize + textRawSize;
+
+	// .rdata is just the debug directory and the RSDS record it points at
+	vector<unsigned char> rdata(sizeof(IMAGE_DEBUG_DIRECTORY));
+
+	Put32(rdata, 0x53445352);	// 'RSDS'
+	rdata.insert(rdata.end(), guid, guid + 16);
+	Put32(rdata, age);
+	PutCString(rdata, pdbName);
+
+	IMAGE_DEBUG_DIRECTORY debugDir;
+	memset(&debugDir, 0, sizeof(debugDir));
+	debugDir.Type = IMAGE_DEBUG_TYPE_CODEVIEW;
+	debugDir.SizeOfData = static_cast<DWORD>(rdata.size() - sizeof(IMAGE_DEBUG_DIRECTORY));
+	debugDir.AddressOfRawData = rdataRVA + sizeof(IMAGE_DEBUG_DIRECTORY);
+	debugDir.PointerToRawData = rdataOffset + sizeof(IMAGE_DEBUG_DIRECTORY);
+	memcpy(&rdata[0], &debugDir, sizeof(debugDir));
+
+	unsigned long rdataSize = static_cast<unsigned long>(rdata.size());
+	unsigned long imageSize = AlignUp(rdataRVA + rdataSize, SectionAlignment);
+
+	image.assign(rdataOffset + AlignUp(rdataSize, FileAlignment), 0);
+
+	IMAGE_DOS_HEADER dosHeader;
+	memset(&dosHeader, 0, sizeof(dosHeader));
+	dosHeader.e_magic = IMAGE_DOS_SIGNATURE;
+	dosHeader.e_lfanew = 0x80;
+	memcpy(&image[0], &dosHeader, sizeof(dosHeader));
+
+	size_t offset = dosHeader.e_lfanew;
+
+	DWORD ntSignature = IMAGE_NT_SIGNATURE;
+	memcpy(&image[offset], &ntSignature, sizeof(ntSignature));
+	offset += sizeof(ntSignature);
+
+	IMAGE_FILE_HEADER fileHeader;
+	memset(&fileHeader, 0, sizeof(fileHeader));
+	fileHeader.Machine = options.bIs64Bit ? IMAGE_FILE_MACHINE_AMD64 : IMAGE_FILE_MACHINE_I386;
+	fileHeader.NumberOfSections = 2;
+	fileHeader.TimeDateStamp = options.seed;
+	fileHeader.SizeOfOptionalHeader = options.bIs64Bit ? sizeof(IMAGE_OPTIONAL_HEADER64) : sizeof(IMAGE_OPTIONAL_HEADER32);
+	fileHeader.Characteristics = IMAGE_FILE_EXECUTABLE_IMAGE;
+	memcpy(&image[offset], &fileHeader, sizeof(fileHeader));
+	offset += sizeof(fileHeader);
+
+	if(options.bIs64Bit) {
+		IMAGE_OPTIONAL_HEADER64 optionalHeader;
+		FillOptionalHeader(optionalHeader, IMAGE_NT_OPTIONAL_HDR64_MAGIC, 0x140000000ULL, entryPoint, textRawSize, imageSize);
+		optionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG].VirtualAddress = rdataRVA;
+		optionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG].Size = sizeof(IMAGE_DEBUG_DIRECTORY);
+		memcpy(&image[offset], &optionalHeader, sizeof(optionalHeader));
+	} else {
+		IMAGE_OPTIONAL_HEADER32 optionalHeader;
+		FillOptionalHeader(optionalHeader, IMAGE_NT_OPTIONAL_HDR32_MAGIC, 0x400000, entryPoint, textRawSize, imageSize);
+		optionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG].VirtualAddress = rdataRVA;
+		optionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG].Size = sizeof(IMAGE_DEBUG_DIRECTORY);
+		memcpy(&image[offset], &optionalHeader, sizeof(optionalHeader));
+	}
+
+	offset += fileHeader.SizeOfOptionalHeader;
+
+	IMAGE_SECTION_HEADER sections[2];
+	memset(sections, 0, sizeof(sections));
+
+	memcpy(sections[0].Name, ".text", 5);
+	sections[0].Misc.VirtualSize = static_cast<DWORD>(code.size());
+	sections[0].VirtualAddress = TextRVA;
+	sections[0].SizeOfRawData = textRawSize;
+	sections[0].PointerToRawData = HeadersSize;
+	sections[0].Characteristics = IMAGE_SCN_CNT_CODE | IMAGE_SCN_MEM_EXECUTE | IMAGE_SCN_MEM_READ;
+
+	memcpy(sections[1].Name, ".rdata", 6);
+	sections[1].Misc.VirtualSize = rdataSize;
+	sections[1].VirtualAddress = rdataRVA;
+	sections[1].SizeOfRawData = AlignUp(rdataSize, FileAlignment);
+	sections[1].PointerToRawData = rdataOffset;
+	sections[1].Characteristics = IMAGE_SCN_CNT_INITIALIZED_DATA | IMAGE_SCN_MEM_READ;
+
+	memcpy(&image[offset], sections, sizeof(sections));
+
+	if(!code.empty())
+		memcpy(&image[HeadersSize], &code[0], code.size());
+
+	memcpy(&image[rdataOffset], &rdata[0], rdata.size());
+}
+
+static void PutSymbolRecord(vector<unsigned char>& stream, unsigned short kind, const vector<unsigned char>& body)
+{
+	// records are padded out to 4 bytes, the length covers the padding
+	size_t length = AlignUp(static_cast<unsigned long>(2 + body.size() + 2), 4) - 2;
+
+	Put16(stream, static_cast<unsigned long>(length));
+	Put16(stream, kind);
+	stream.insert(stream.end(), body.begin(), body.end());
+
+	for(size_t padding = length - 2 - body.size(); padding; --padding)
+		Put8(stream, 0xF0 | padding);
+}
+
+static void BuildModuleStream(const SyntheticImageOptions& options, unsigned int compilandNum, unsigned int firstFunction, unsigned int lastFunction, const vector<unsigned long>& functionRVAs, const vector<unsigned long>& functionLengths, vector<unsigned char>& stream)
+{
+	const unsigned long*	varTypes = options.bIs64Bit ? VariableTypes64 : VariableTypes32;
+	unsigned short			frameReg = static_cast<unsigned short>(options.bIs64Bit ? CV_AMD64_RBP : CV_REG_EBP);
+	vector<unsigned char>	body;
+
+	Put32(stream, ModuleSymbolSignature);
+
+	for(unsigned int funcNum = firstFunction; funcNum < lastFunction; ++funcNum) {
+		// parent, end and next pointers, length, debug start and end, type, offset, section and flags
+		body.clear();
+		Put32(body, 0);
+		Put32(body, 0);
+		Put32(body, 0);
+		Put32(body, functionLengths[funcNum]);
+		Put32(body, 0);
+		Put32(body, 0);
+		Put32(body, ProcTypeIndex);
+		Put32(body, functionRVAs[funcNum] - TextRVA);
+		Put16(body, 1);
+		Put8(body, 0);
+		PutCString(body, GetFunctionName(funcNum, compilandNum));
+		PutSymbolRecord(stream, S_GPROC32, body);
+
+		for(unsigned int varNum = 0, varNum_end = options.numParameters + options.numLocals; varNum < varNum_end; ++varNum) {
+			ostringstream name;
+
+			if(varNum < options.numParameters)
+				name << "param" << varNum;
+			else
+				name << "local" << varNum - options.numParameters;
+
+			body.clear();
+			Put32(body, static_cast<unsigned long>(GetVariableOffset(options, varNum)));
+			Put32(body, varTypes[varNum % 3]);
+			Put16(body, frameReg);
+			PutCString(body, name.str());
+			PutSymbolRecord(stream, S_REGREL32, body);
+		}
+
+		body.clear();
+		PutSymbolRecord(stream, S_END, body);
+	}
+}
+
+static void BuildTypeStream(const SyntheticImageOptions& options, vector<unsigned char>& stream)
+{
+	// one LF_PROCEDURE shared by every function: int (params...)
+	vector<unsigned char> records;
+
+	Put16(records, 14);
+	Put16(records, LF_PROCEDURE);
+	Put32(records, 0x0074);
+	Put8(records, 0);
+	Put8(records, 0);
+	Put16(records, options.numParameters);
+	Put32(records, 0);
+
+	// version, header size, type index range, record bytes, then the hash
+	// stream and buffer fields, which PDB never reads
+	Put32(stream, 20040203);
+	Put32(stream, 56);
+	Put32(stream, FirstNonSimpleTypeIndex);
+	Put32(stream, FirstNonSimpleTypeIndex + 1);
+	Put32(stream, static_cast<unsigned long>(records.size()));
+	Put16(stream, NoStream);
+	Put16(stream, NoStream);
+
+	for(int field = 0; field < 8; ++field)
+		Put32(stream, 0);
+
+	stream.insert(stream.end(), records.begin(), records.end());
+}
+
+static void BuildDBIStream(const SyntheticImageOptions& options, unsigned long age, unsigned short firstModuleStream, const vector<unsigned long>& symbolSizes, vector<unsigned char>& stream)
+{
+	vector<unsigned char> modInfo;
+
+	for(unsigned int compilandNum = 0; compilandNum < options.numCompilands; ++compilandNum) {
+		ostringstream name;
+		name << "Module" << compilandNum << ".obj";
+
+		// unused, section contribution and flags
+		Put32(modInfo, 0);
+		modInfo.insert(modInfo.end(), 28, 0);
+		Put16(modInfo, 0);
+
+		Put16(modInfo, firstModuleStream + compilandNum);
+		Put32(modInfo, symbolSizes[compilandNum]);
+
+		// no line info or source files
+		Put32(modInfo, 0);
+		Put32(modInfo, 0);
+		Put16(modInfo, 0);
+		Put16(modInfo, 0);
+		Put32(modInfo, 0);
+		Put32(modInfo, 0);
+		Put32(modInfo, 0);
+
+		PutCString(modInfo, name.str());
+		PutCString(modInfo, name.str());
+		PadTo(modInfo, 4, 0);
+	}
+
+	Put32(stream, 0xFFFFFFFF);
+	Put32(stream, 19990903);
+	Put32(stream, age);
+	Put16(stream, NoStream);
+	Put16(stream, 0);
+	Put16(stream, NoStream);
+	Put16(stream, 0);
+	Put16(stream, NoStream);
+	Put16(stream, 0);
+	Put32(stream, static_cast<unsigned long>(modInfo.size()));
+
+	// section contributions, section map, source info, type server map,
+	// MFC type server, optional debug header and EC substream sizes
+	for(int field = 0; field < 7; ++field)
+		Put32(stream, 0);
+
+	Put16(stream, 0);
+	Put16(stream, options.bIs64Bit ? IMAGE_FILE_MACHINE_AMD64 : IMAGE_FILE_MACHINE_I386);
+	Put32(stream, 0);
+
+	stream.insert(stream.end(), modInfo.begin(), modInfo.end());
+}
+
+static void WriteMSF(const wstring& filename, const vector<vector<unsigned char> >& streams)
+{
+	// block 0 is the superblock and 1 and 2 the free block maps, which MSF
+	// never reads; each stream then gets a contiguous run of blocks
+	unsigned long			nextBlock = 3;
+	vector<unsigned char>	directory;
+	vector<unsigned long>	streamStarts;
+
+	Put32(directory, static_cast<unsigned long>(streams.size()));
+
+	for(size_t i = 0, i_end = streams.size(); i < i_end; ++i)
+		Put32(directory, static_cast<unsigned long>(streams[i].size()));
+
+	for(size_t i = 0, i_end = streams.size(); i < i_end; ++i) {
+		unsigned long numBlocks = AlignUp(static_cast<unsigned long>(streams[i].size()), MSFBlockSize) / MSFBlockSize;
+
+		streamStarts.push_back(nextBlock);
+
+		for(unsigned long block = 0; block < numBlocks; ++block)
+			Put32(directory, nextBlock++);
+	}
+
+	unsigned long directoryStart = nextBlock;
+	unsigned long numDirectoryBlocks = AlignUp(static_cast<unsigned long>(directory.size()), MSFBlockSize) / MSFBlockSize;
+	unsigned long blockMapBlock = directoryStart + numDirectoryBlocks;
+	unsigned long numBlocks = blockMapBlock + 1;
+
+	if(numDirectoryBlocks > MSFBlockSize / 4)
+		throw runtime_error("Synthetic PDB too large for a single block map block.");
+
+	vector<unsigned char> file(static_cast<size_t>(numBlocks) * MSFBlockSize, 0);
+
+	memcpy(&file[0], MSFMagic, 32);
+
+	vector<unsigned char> superBlock;
+	Put32(superBlock, MSFBlockSize);
+	Put32(superBlock, 1);
+	Put32(superBlock, numBlocks);
+	Put32(superBlock, static_cast<unsigned long>(directory.size()));
+	Put32(superBlock, 0);
+	Put32(superBlock, blockMapBlock);
+	memcpy(&file[32], &superBlock[0], superBlock.size());
+
+	for(size_t i = 0, i_end = streams.size(); i < i_end; ++i) {
+		if(!streams[i].empty())
+			memcpy(&file[static_cast<size_t>(streamStarts[i]) * MSFBlockSize], &streams[i][0], streams[i].size());
+	}
+
+	memcpy(&file[static_cast<size_t>(directoryStart) * MSFBlockSize], &directory[0], directory.size());
+
+	vector<unsigned char> blockMap;
+
+	for(unsigned long block = 0; block < numDirectoryBlocks; ++block)
+		Put32(blockMap, directoryStart + block);
+
+	memcpy(&file[static_cast<size_t>(blockMapBlock) * MSFBlockSize], &blockMap[0], blockMap.size());
+
+	ofstream out(NativePath(filename).c_str(), ios::out | ios::binary);
+	out.write(reinterpret_cast<const char*>(&file[0]), file.size());
+
+	if(!out)
+		throw runtime_error("Unable to write synthetic PDB.");
+}
+
+void GetDefaultSyntheticImageOptions(SyntheticImageOptions& options)
+{
+	options.bIs64Bit = true;
+	options.seed = 1;
+	options.numFunctions = 20000;
+	options.numCompilands = 50;
+	options.minInstructions = 8;
+	options.maxInstructions = 200;
+	options.numParameters = 2;
+	options.numLocals = 6;
+	options.memoryPercent = 40;
+	options.branchPercent = 10;
+	options.callPercent = 5;
+}
+
+bool ParseSyntheticImageOptions(const wstring& spec, SyntheticImageOptions& options)
+{
+	wistringstream specStream(spec);
+	wstring item;
+
+	while(getline(specStream, item, L',')) {
+		if(item.empty())
+			continue;
+
+		if(item == L"x86") {
+			options.bIs64Bit = false;
+			continue;
+		} else if(item == L"x64") {
+			options.bIs64Bit = true;
+			continue;
+		}
+
+		size_t equals = item.find(L'=');
+
+		if(equals == wstring::npos)
+			return false;
+
+		wstring			key = item.substr(0, equals);
+		wstring			value = item.substr(equals + 1);
+		unsigned long	number = wcstoul(value.c_str(), NULL, 10);
+
+		if(key == L"functions") {
+			options.numFunctions = number;
+		} else if(key == L"compilands") {
+			options.numCompilands = number;
+		} else if(key == L"instructions") {
+			// N or N-M
+			size_t dash = value.find(L'-');
+
+			options.minInstructions = number;
+			options.maxInstructions = dash == wstring::npos ? number : wcstoul(value.c_str() + dash + 1, NULL, 10);
+		} else if(key == L"params") {
+			options.numParameters = number;
+		} else if(key == L"locals") {
+			options.numLocals = number;
+		} else if(key == L"memory") {
+			options.memoryPercent = number;
+		} else if(key == L"branches") {
+			options.branchPercent = number;
+		} else if(key == L"calls") {
+			options.callPercent = number;
+		} else if(key == L"seed") {
+			options.seed = number;
+		} else {
+			return false;
+		}
+	}
+
+	return options.numFunctions && options.numCompilands && options.minInstructions <= options.maxInstructions &&
+		options.memoryPercent + options.branchPercent + options.callPercent <= 100;
+}
+
+void WriteSyntheticImage(const SyntheticImageOptions& options, const wstring& exeFilename, const wstring& pdbFilename)
+{
+	SyntheticRandom			random(options.seed);
+	vector<unsigned char>	code;
+	vector<CodeFixup>		calls;
+	vector<unsigned long>	functionRVAs(options.numFunctions);
+	vector<unsigned long>	functionLengths(options.numFunctions);
+
+	for(unsigned int funcNum = 0; funcNum < options.numFunctions; ++funcNum) {
+		functionRVAs[funcNum] = TextRVA + static_cast<unsigned long>(code.size());
+
+		GenerateFunction(options, random, options.numFunctions, code, calls);
+
+		functionLengths[funcNum] = TextRVA + static_cast<unsigned long>(code.size()) - functionRVAs[funcNum];
+		PadTo(code, FunctionAlignment, 0xCC);
+	}
+
+	for(vector<CodeFixup>::const_iterator i = calls.begin(), i_end = calls.end(); i != i_end; ++i)
+		Patch32(code, i->patchOffset, functionRVAs[i->target] - (TextRVA + static_cast<unsigned long>(i->nextInstrOffset)));
+
+	unsigned char	guid[16];
+	unsigned long	age = 1;
+
+	for(int i = 0; i < 16; ++i)
+		guid[i] = static_cast<unsigned char>(random.Next());
+
+	// just the file name, PDB looks for it next to the EXE
+	wstring pdbName = pdbFilename;
+	size_t	pdbNameStart = pdbName.find_last_of(L"\\/");
+
+	if(pdbNameStart != wstring::npos)
+		pdbName = pdbName.substr(pdbNameStart + 1);
+
+	vector<unsigned char> image;
+	BuildPE(options, code, functionRVAs.empty() ? TextRVA : functionRVAs[0], guid, age, WideToUtf8(pdbName), image);
+
+	ofstream exeFile(NativePath(exeFilename).c_str(), ios::out | ios::binary);
+	exeFile.write(reinterpret_cast<const char*>(&image[0]), image.size());
+
+	if(!exeFile)
+		throw runtime_error("Unable to write synthetic EXE.");
+
+	// streams 0 to 4 are the old directory, PDB info, TPI, DBI and IPI
+	vector<vector<unsigned char> > streams(5 + options.numCompilands);
+
+	Put32(streams[PDBStream], 20000404);
+	Put32(streams[PDBStream], options.seed);
+	Put32(streams[PDBStream], age);
+	streams[PDBStream].insert(streams[PDBStream].end(), guid, guid + 16);
+
+	BuildTypeStream(options, streams[TPIStream]);
+
+	vector<unsigned long> symbolSizes(options.numCompilands);
+
+	for(unsigned int compilandNum = 0; compilandNum < options.numCompilands; ++compilandNum) {
+		unsigned int firstFunction = static_cast<unsigned int>(static_cast<unsigned long long>(options.numFunctions) * compilandNum / options.numCompilands);
+		unsigned int lastFunction = static_cast<unsigned int>(static_cast<unsigned long long>(options.numFunctions) * (compilandNum + 1) / options.numCompilands);
+
+		vector<unsigned char>& stream = streams[5 + compilandNum];
+
+		BuildModuleStream(options, compilandNum, firstFunction, lastFunction, functionRVAs, functionLengths, stream);
+		symbolSizes[compilandNum] = static_cast<unsigned long>(stream.size());
+	}
+
+	BuildDBIStream(options, age, 5, symbolSizes, streams[DBIStream]);
+
+	WriteMSF(pdbFilename, streams);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef __SYNTHETICIMAGE_H__
+#define __SYNTHETICIMAGE_H__
+
+#include <string>
+
+//
+//	Writes a made-up EXE and a matching PDB for benchmarking, so runs can
+//	be repeated anywhere without shipping real binaries. The EXE has one
+//	code section of rbp-framed functions; the PDB is a minimal MSF 7.0
+//	file with just the streams PDB reads: the PDB info, TPI, DBI and one
+//	symbol stream per compiland, each function described by S_GPROC32
+//	plus S_REGREL32 records for its parameters and locals.
+//
+//	The same options and seed always produce the same bytes.
+//
+
+typedef struct
+{
+	bool				bIs64Bit;
+	unsigned long		seed;
+	unsigned int		numFunctions;
+	unsigned int		numCompilands;
+
+	// instructions per function body, picked uniformly from the range
+	unsigned int		minInstructions;
+	unsigned int		maxInstructions;
+
+	unsigned int		numParameters;
+	unsigned int		numLocals;
+
+	// instruction mix, in percent of body instructions; what's left
+	// over is register arithmetic
+	unsigned int		memoryPercent;
+	unsigned int		branchPercent;
+	unsigned int		callPercent;
+} SyntheticImageOptions;
+
+void	GetDefaultSyntheticImageOptions(SyntheticImageOptions& options);
+
+// parses comma separated key=value pairs over the defaults already in options,
+// e.g. "functions=20000,instructions=8-200,locals=6,memory=40,x86"
+bool	ParseSyntheticImageOptions(const std::wstring& spec, SyntheticImageOptions& options);
+
+// the PDB is written next to the EXE and found there through the CodeView record
+void	WriteSyntheticImage(const SyntheticImageOptions& options, const std::wstring& exeFilename, const std::wstring& pdbFilename);
+
+#endif
\ No newline at end of file
@@ -2,11 +2,13 @@
 #define __TYPE_H__
 
 #include <vector>
-#include <memory>
-#include <atlbase.h>
-#include <cvconst.h>
 
-struct IDiaSymbol;
+#include "CVConst.h"
+
+// index of a Type in its TypeTable
+typedef unsigned long TypeId;
+
+static const TypeId InvalidTypeId = 0xFFFFFFFF;
 
 enum TypeModifier
 {
@@ -15,21 +17,30 @@ enum TypeModifier
 	None
 };
 
+//
+//	One node of the type graph. Members refer to their types by id,
+//	so a struct used in many places is only described once, and a
+//	struct that points back to itself just refers to its own id.
+//
 class Type
 {
 public:
-	Type(CComPtr<IDiaSymbol> sym);
+	Type();
 
-	bool											GetBasicType(enum BasicType& r_basicType);
-	const std::vector<std::tr1::shared_ptr<Type>>&	GetSubtypes();
-	bool											IsKnownType();
+	bool						GetBasicType(enum BasicType& r_basicType) const;
+	const std::vector<TypeId>&	GetSubtypes() const;
+	bool						IsKnownType() const;
+	TypeModifier				GetModifier() const;
 
 private:
-	bool									m_bIsBasicType;
-	bool									m_bKnownType;
-	enum BasicType							m_basicType;
-	TypeModifier							m_modifier;
-	std::vector<std::tr1::shared_ptr<Type>>	m_subtypes;
+	friend class TypeTable;
+
+	bool						m_bResolved;
+	bool						m_bIsBasicType;
+	bool						m_bKnownType;
+	enum BasicType				m_basicType;
+	TypeModifier				m_modifier;
+	std::vector<TypeId>			m_subtypes;
 };
 
 #endif
\ No newline at end of file
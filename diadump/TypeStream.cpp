@@ -0,0 +1,205 @@
+#include <stdexcept>
+#include "CodeView.h"
+#include "MSF.h"
+#include "TypeStream.h"
+
+using namespace std;
+using namespace CodeView;
+
+typedef struct
+{
+	unsigned int	version;
+	unsigned int	headerSize;
+	unsigned int	typeIndexBegin;
+	unsigned int	typeIndexEnd;
+	unsigned int	typeRecordBytes;
+} TypeStreamHeader;
+
+TypeStream::TypeStream(const MSF& msf, unsigned long streamIndex)
+	: m_recordOffsets(NULL), m_numRecords(0), m_typeIndexBegin(FirstNonSimpleTypeIndex), m_bDefinitionsIndexed(false)
+{
+	// a missing IPI stream just means an older PDB, leave the stream empty
+	if(!msf.ReadStream(streamIndex, m_ownedData))
+		m_ownedData.clear();
+
+	m_data.data = m_ownedData.empty() ? NULL : &m_ownedData[0];
+	m_data.size = m_ownedData.size();
+
+	IndexRecords();
+}
+
+TypeStream::TypeStream(const shared_ptr<MappedFile>& file, const ByteSpan& data, const unsigned int* recordOffsets, size_t numRecords)
+	: m_file(file), m_data(data), m_recordOffsets(recordOffsets), m_numRecords(numRecords),
+	m_typeIndexBegin(FirstNonSimpleTypeIndex), m_bDefinitionsIndexed(false)
+{
+	ReadTypeIndexBegin();
+}
+
+const ByteSpan& TypeStream::GetData() const
+{
+	return m_data;
+}
+
+const unsigned int* TypeStream::GetRecordOffsets() const
+{
+	return m_recordOffsets;
+}
+
+size_t TypeStream::GetNumRecords() const
+{
+	return m_numRecords;
+}
+
+void TypeStream::ReadTypeIndexBegin()
+{
+	if(!m_data.size)
+		return;
+
+	BinaryReader reader(m_data.data, m_data.size);
+
+	TypeStreamHeader header;
+	reader.ReadBytes(&header, sizeof(header));
+
+	if(header.typeIndexEnd < header.typeIndexBegin)
+		throw runtime_error("Invalid PDB file. Bad type stream header.");
+
+	m_typeIndexBegin = header.typeIndexBegin;
+}
+
+void TypeStream::IndexRecords()
+{
+	if(!m_data.size)
+		return;
+
+	ReadTypeIndexBegin();
+
+	BinaryReader reader(m_data.data, m_data.size);
+
+	TypeStreamHeader header;
+	reader.ReadBytes(&header, sizeof(header));
+
+	m_ownedOffsets.reserve(header.typeIndexEnd - header.typeIndexBegin);
+
+	reader.Seek(header.headerSize);
+
+	size_t recordsEnd = header.headerSize + header.typeRecordBytes;
+
+	if(recordsEnd > m_data.size)
+		recordsEnd = m_data.size;
+
+	while(reader.Tell() + sizeof(unsigned short) <= recordsEnd) {
+		m_ownedOffsets.push_back(static_cast<unsigned int>(reader.Tell()));
+
+		unsigned short recordLength = reader.Read<unsigned short>();
+		reader.Skip(recordLength);
+	}
+
+	m_recordOffsets = m_ownedOffsets.empty() ? NULL : &m_ownedOffsets[0];
+	m_numRecords = m_ownedOffsets.size();
+}
+
+bool TypeStream::GetRecord(unsigned long typeIndex, unsigned short& kind, BinaryReader& reader) const
+{
+	if(typeIndex < m_typeIndexBegin || typeIndex - m_typeIndexBegin >= m_numRecords)
+		return false;
+
+	// cached offsets are used as they were saved, so check them here
+	size_t offset = m_recordOffsets[typeIndex - m_typeIndexBegin];
+
+	if(offset + 2 * sizeof(unsigned short) > m_data.size)
+		return false;
+
+	BinaryReader header(m_data.data + offset, m_data.size - offset);
+
+	unsigned short recordLength = header.Read<unsigned short>();
+
+	if(recordLength < sizeof(unsigned short) || recordLength > header.Remaining())
+		return false;
+
+	kind = header.Read<unsigned short>();
+	reader = BinaryReader(header.Current(), recordLength - sizeof(unsigned short));
+
+	return true;
+}
+
+bool TypeStream::GetUDTInfo(unsigned long typeIndex, UDTInfo& info) const
+{
+	BinaryReader reader;
+
+	if(!GetRecord(typeIndex, info.kind, reader))
+		return false;
+
+	info.underlyingType = 0;
+	info.fieldList = 0;
+
+	switch(info.kind) {
+		case LF_CLASS:
+		case LF_STRUCTURE:
+		case LF_INTERFACE:
+			reader.Skip(sizeof(unsigned short));
+			info.property = reader.Read<unsigned short>();
+			info.fieldList = reader.Read<unsigned int>();
+			reader.Skip(2 * sizeof(unsigned int));
+			reader.ReadNumeric();
+			break;
+		case LF_UNION:
+			reader.Skip(sizeof(unsigned short));
+			info.property = reader.Read<unsigned short>();
+			info.fieldList = reader.Read<unsigned int>();
+			reader.ReadNumeric();
+			break;
+		case LF_ENUM:
+			reader.Skip(sizeof(unsigned short));
+			info.property = reader.Read<unsigned short>();
+			info.underlyingType = reader.Read<unsigned int>();
+			info.fieldList = reader.Read<unsigned int>();
+			break;
+		default:
+			return false;
+	}
+
+	info.name = reader.ReadCString();
+
+	if(info.property & PropHasUniqueName)
+		info.uniqueName = reader.ReadCString();
+	else
+		info.uniqueName.clear();
+
+	return true;
+}
+
+unsigned long TypeStream::ResolveForwardReference(unsigned long typeIndex) const
+{
+	UDTInfo info;
+
+	if(!GetUDTInfo(typeIndex, info) || !(info.property & PropForwardRef))
+		return typeIndex;
+
+	IndexUDTDefinitions();
+
+	map<string, unsigned long>::const_iterator def = m_udtDefinitions.find(info.uniqueName.empty() ? info.name : info.uniqueName);
+
+	if(def == m_udtDefinitions.end())
+		return typeIndex;
+
+	return def->second;
+}
+
+void TypeStream::IndexUDTDefinitions() const
+{
+	if(m_bDefinitionsIndexed)
+		return;
+
+	m_bDefinitionsIndexed = true;
+
+	UDTInfo info;
+
+	for(unsigned long i = 0, i_end = static_cast<unsigned long>(m_numRecords); i < i_end; ++i) {
+		unsigned long typeIndex = m_typeIndexBegin + i;
+
+		if(!GetUDTInfo(typeIndex, info) || (info.property & PropForwardRef))
+			continue;
+
+		m_udtDefinitions.insert(make_pair(info.uniqueName.empty() ? info.name : info.uniqueName, typeIndex));
+	}
+}
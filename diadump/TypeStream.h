@@ -0,0 +1,69 @@
+#ifndef __TYPESTREAM_H__
+#define __TYPESTREAM_H__
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BinaryReader.h"
+#include "MappedFile.h"
+
+class MSF;
+
+typedef struct
+{
+	unsigned short	kind;
+	unsigned short	property;
+	unsigned long	fieldList;
+	unsigned long	underlyingType;
+	std::string		name;
+	std::string		uniqueName;
+} UDTInfo;
+
+//
+//	Random access over the type records of a TPI or IPI stream.
+//	Records are indexed once on load so any type index can be
+//	looked up without walking the stream. A stream from the symbol
+//	cache is read in place from the mapped file, along with the
+//	record index saved next to it.
+//
+class TypeStream
+{
+public:
+	TypeStream(const MSF& msf, unsigned long streamIndex);
+	TypeStream(const std::shared_ptr<MappedFile>& file, const ByteSpan& data, const unsigned int* recordOffsets, size_t numRecords);
+
+	bool							GetRecord(unsigned long typeIndex, unsigned short& kind, BinaryReader& reader) const;
+	bool							GetUDTInfo(unsigned long typeIndex, UDTInfo& info) const;
+	unsigned long					ResolveForwardReference(unsigned long typeIndex) const;
+	const ByteSpan&					GetData() const;
+
+	// offset of each record from the start of the stream, in type index order
+	const unsigned int*				GetRecordOffsets() const;
+	size_t							GetNumRecords() const;
+
+private:
+	TypeStream(const TypeStream&);
+	TypeStream&						operator=(const TypeStream&);
+
+	void							ReadTypeIndexBegin();
+	void							IndexRecords();
+	void							IndexUDTDefinitions() const;
+
+	// a cached stream keeps its file mapped, one read out of the MSF owns
+	// its bytes and index; either way the spans below point at them
+	std::shared_ptr<MappedFile>		m_file;
+	std::vector<unsigned char>		m_ownedData;
+	std::vector<unsigned int>		m_ownedOffsets;
+
+	ByteSpan						m_data;
+	const unsigned int*				m_recordOffsets;
+	size_t							m_numRecords;
+	unsigned long					m_typeIndexBegin;
+
+	mutable bool								m_bDefinitionsIndexed;
+	mutable std::map<std::string, unsigned long>	m_udtDefinitions;
+};
+
+#endif
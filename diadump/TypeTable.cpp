@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "CodeView.h"
+#include "TypeStream.h"
+#include "TypeTable.h"
+
+using namespace std;
+using namespace CodeView;
+
+static bool SimpleTypeToBasicType(unsigned long simpleKind, enum BasicType& r_basicType);
+static unsigned long StripModifiers(const TypeStream& tpi, unsigned long typeIndex);
+
+TypeTable::TypeTable(const std::shared_ptr<const TypeStream>& tpi)
+	: m_tpi(tpi)
+{
+}
+
+TypeId TypeTable::Intern(unsigned long typeIndex)
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return InternLocked(typeIndex);
+}
+
+TypeId TypeTable::InternLocked(unsigned long typeIndex) const
+{
+	typeIndex = StripModifiers(*m_tpi, typeIndex);
+
+	unordered_map<unsigned long, TypeId>::const_iterator found = m_idsByTypeIndex.find(typeIndex);
+
+	if(found != m_idsByTypeIndex.end())
+		return found->second;
+
+	TypeId id = static_cast<TypeId>(m_types.size());
+
+	m_types.push_back(Type());
+	m_typeIndices.push_back(typeIndex);
+	m_idsByTypeIndex.insert(make_pair(typeIndex, id));
+
+	return id;
+}
+
+const Type& TypeTable::GetType(TypeId id) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(id >= m_types.size())
+		throw runtime_error("Invalid type id.");
+
+	Type& type = m_types[id];
+
+	// members only get an id here, they're read when they're asked
+	// for, so a type that (through a pointer) contains itself just
+	// refers back to this entry
+	if(!type.m_bResolved) {
+		BuildType(m_typeIndices[id], type);
+		type.m_bResolved = true;
+	}
+
+	return type;
+}
+
+size_t TypeTable::GetNumTypes() const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	return m_types.size();
+}
+
+unsigned long TypeTable::GetTypeIndex(TypeId id) const
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	if(id >= m_typeIndices.size())
+		throw runtime_error("Invalid type id.");
+
+	return m_typeIndices[id];
+}
+
+const TypeStream& TypeTable::GetTypeStream() const
+{
+	return *m_tpi;
+}
+
+void TypeTable::BuildType(unsigned long typeIndex, Type& type) const
+{
+	const TypeStream& tpi = *m_tpi;
+
+	type.m_bKnownType = true;
+
+	unsigned long finalType = typeIndex;
+
+	// built-in types encode a pointer mode in bits 8-11
+	// of the index instead of having a separate record
+	if(finalType < FirstNonSimpleTypeIndex)
+	{
+		if((finalType >> 8) & 0xF)
+			type.m_modifier = Pointer;
+
+		type.m_bIsBasicType = true;
+
+		if(!SimpleTypeToBasicType(finalType & 0xFF, type.m_basicType))
+			type.m_bKnownType = false;
+
+		return;
+	}
+
+	unsigned short		kind;
+	BinaryReader		reader;
+
+	if(!tpi.GetRecord(finalType, kind, reader))
+	{
+		type.m_bKnownType = false;
+		return;
+	}
+
+	if(kind == LF_POINTER)
+	{
+		finalType = StripModifiers(tpi, reader.Read<unsigned int>());
+		type.m_modifier = Pointer;
+	}
+	else if(kind == LF_ARRAY)
+	{
+		finalType = StripModifiers(tpi, reader.Read<unsigned int>());
+		type.m_modifier = Array;
+	}
+
+	if(type.m_modifier != None)
+	{
+		if(finalType < FirstNonSimpleTypeIndex)
+		{
+			type.m_bIsBasicType = true;
+
+			if(!SimpleTypeToBasicType(finalType & 0xFF, type.m_basicType))
+				type.m_bKnownType = false;
+
+			return;
+		}
+	}
+
+	finalType = tpi.ResolveForwardReference(finalType);
+
+	UDTInfo udt;
+
+	if(!tpi.GetUDTInfo(finalType, udt))
+	{
+		// procedures, bitfields and anything else we don't model
+		type.m_bKnownType = false;
+		return;
+	}
+
+	if(udt.kind == LF_ENUM)
+	{
+		type.m_bIsBasicType = true;
+
+		if(udt.underlyingType >= FirstNonSimpleTypeIndex ||
+			!SimpleTypeToBasicType(udt.underlyingType & 0xFF, type.m_basicType))
+		{
+			type.m_bKnownType = false;
+		}
+
+		return;
+	}
+
+	// a forward reference that never got resolved has no members we can see
+	if(udt.property & PropForwardRef)
+	{
+		type.m_bKnownType = false;
+		return;
+	}
+
+	vector<unsigned long> visitedLists;
+
+	for(unsigned long fieldList = udt.fieldList; fieldList;)
+	{
+		// an LF_INDEX chain that loops back on itself would never end
+		if(find(visitedLists.begin(), visitedLists.end(), fieldList) != visitedLists.end())
+			return;
+
+		visitedLists.push_back(fieldList);
+
+		if(!tpi.GetRecord(fieldList, kind, reader) || kind != LF_FIELDLIST)
+		{
+			type.m_bKnownType = false;
+			return;
+		}
+
+		fieldList = 0;
+
+		while(!reader.AtEnd())
+		{
+			// skip LF_PAD bytes between field records; a pad of zero or
+			// one running off the record is corrupt, keep what we have
+			if(*reader.Current() >= 0xF0)
+			{
+				size_t padLength = *reader.Current() & 0x0F;
+
+				if(!padLength || padLength > reader.Remaining())
+					break;
+
+				reader.Skip(padLength);
+				continue;
+			}
+
+			unsigned short	fieldKind = reader.Read<unsigned short>();
+			unsigned short	attr;
+			unsigned long	memberType;
+
+			switch(fieldKind)
+			{
+			case LF_MEMBER:
+				reader.Skip(sizeof(unsigned short));
+				memberType = reader.Read<unsigned int>();
+				reader.ReadNumeric();
+				reader.ReadCString();
+				type.m_subtypes.push_back(InternLocked(memberType));
+				break;
+			case LF_STMEMBER:
+				reader.Skip(sizeof(unsigned short));
+				memberType = reader.Read<unsigned int>();
+				reader.ReadCString();
+				type.m_subtypes.push_back(InternLocked(memberType));
+				break;
+			case LF_BCLASS:
+				reader.Skip(sizeof(unsigned short) + sizeof(unsigned int));
+				reader.ReadNumeric();
+				break;
+			case LF_VBCLASS:
+			case LF_IVBCLASS:
+				reader.Skip(sizeof(unsigned short) + 2 * sizeof(unsigned int));
+				reader.ReadNumeric();
+				reader.ReadNumeric();
+				break;
+			case LF_ENUMERATE:
+				reader.Skip(sizeof(unsigned short));
+				reader.ReadNumeric();
+				reader.ReadCString();
+				break;
+			case LF_METHOD:
+				reader.Skip(sizeof(unsigned short) + sizeof(unsigned int));
+				reader.ReadCString();
+				break;
+			case LF_ONEMETHOD:
+				attr = reader.Read<unsigned short>();
+				reader.Skip(sizeof(unsigned int));
+
+				// introducing virtual methods carry a vtable offset
+				if(((attr >> 2) & 7) == 4 || ((attr >> 2) & 7) == 6)
+					reader.Skip(sizeof(unsigned int));
+
+				reader.ReadCString();
+				break;
+			case LF_NESTTYPE:
+				reader.Skip(sizeof(unsigned short) + sizeof(unsigned int));
+				reader.ReadCString();
+				break;
+			case LF_VFUNCTAB:
+				reader.Skip(sizeof(unsigned short) + sizeof(unsigned int));
+				break;
+			case LF_INDEX:
+				// the member list continues in another LF_FIELDLIST
+				reader.Skip(sizeof(unsigned short));
+				fieldList = reader.Read<unsigned int>();
+				break;
+			default:
+				// no way to know how long an unknown field is, so
+				// keep whatever members we've found so far
+				reader.Seek(reader.Tell() + reader.Remaining());
+				break;
+			}
+		}
+	}
+}
+
+static unsigned long StripModifiers(const TypeStream& tpi, unsigned long typeIndex)
+{
+	unsigned short	kind;
+	BinaryReader	reader;
+
+	// const/volatile don't change what we report, look straight through them
+	while(typeIndex >= FirstNonSimpleTypeIndex && tpi.GetRecord(typeIndex, kind, reader) && kind == LF_MODIFIER)
+		typeIndex = reader.Read<unsigned int>();
+
+	return typeIndex;
+}
+
+static bool SimpleTypeToBasicType(unsigned long simpleKind, enum BasicType& r_basicType)
+{
+	switch(simpleKind)
+	{
+	case 0x03:	r_basicType = btVoid;		return true;
+	case 0x08:	r_basicType = btHresult;	return true;
+	case 0x10:
+	case 0x70:	r_basicType = btChar;		return true;
+	case 0x71:	r_basicType = btWChar;		return true;
+	case 0x7a:	r_basicType = btChar16;		return true;
+	case 0x7b:	r_basicType = btChar32;		return true;
+	case 0x11:
+	case 0x13:
+	case 0x68:
+	case 0x72:
+	case 0x74:
+	case 0x76:	r_basicType = btInt;		return true;
+	case 0x20:
+	case 0x21:
+	case 0x23:
+	case 0x69:
+	case 0x73:
+	case 0x75:
+	case 0x77:	r_basicType = btUInt;		return true;
+	case 0x12:	r_basicType = btLong;		return true;
+	case 0x22:	r_basicType = btULong;		return true;
+	case 0x40:
+	case 0x41:
+	case 0x42:
+	case 0x46:	r_basicType = btFloat;		return true;
+	case 0x30:
+	case 0x31:
+	case 0x32:
+	case 0x33:	r_basicType = btBool;		return true;
+	}
+
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef __TYPETABLE_H__
+#define __TYPETABLE_H__
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "Type.h"
+
+class TypeStream;
+
+//
+//	Every type referenced by the PDB's variables, each built once
+//	and keyed by its TPI type index (after const/volatile are
+//	stripped). Variables and members only hold the TypeId.
+//
+//	Interning only hands out an id; the type record is read the first
+//	time GetType asks for it, so types nobody looks at cost nothing.
+//	Safe to call from several threads at once.
+//
+class TypeTable
+{
+public:
+	explicit TypeTable(const std::shared_ptr<const TypeStream>& tpi);
+
+	TypeId								Intern(unsigned long typeIndex);
+	const Type&							GetType(TypeId id) const;
+	size_t								GetNumTypes() const;
+	unsigned long						GetTypeIndex(TypeId id) const;
+	const TypeStream&					GetTypeStream() const;
+
+private:
+	TypeId								InternLocked(unsigned long typeIndex) const;
+	void								BuildType(unsigned long typeIndex, Type& type) const;
+
+	std::shared_ptr<const TypeStream>	m_tpi;
+
+	// a deque so references handed out stay valid as types are added
+	mutable std::deque<Type>						m_types;
+	mutable std::deque<unsigned long>				m_typeIndices;
+	mutable std::unordered_map<unsigned long, TypeId>	m_idsByTypeIndex;
+	mutable std::mutex								m_mutex;
+};
+
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef __UTILITY_H__
 #define __UTILITY_H__
 
+#include <string>
+
 template<typename T>
 void DeleteBuffer(T* buf)
 {
@@ -9,4 +11,127 @@ void DeleteBuffer(T* buf)
 	}
 }
 
+#ifdef _WIN32
+static const wchar_t PathSeparator = L'\\';
+#else
+static const wchar_t PathSeparator = L'/';
+#endif
+
+// dir may or may not already end in a separator; either kind is accepted
+inline std::wstring JoinPath(const std::wstring& dir, const std::wstring& name)
+{
+	if(dir.empty())
+		return name;
+
+	wchar_t last = dir[dir.length() - 1];
+
+	if(last == L'\\' || last == L'/')
+		return dir + name;
+
+	return dir + PathSeparator + name;
+}
+
+// names in the PDB streams are UTF-8, everything else here is wide
+inline std::wstring Utf8ToWide(const std::string& str)
+{
+	std::wstring wide;
+	wide.reserve(str.length());
+
+	for(size_t i = 0, i_end = str.length(); i < i_end;) {
+		unsigned char	lead = static_cast<unsigned char>(str[i]);
+		unsigned long	codePoint;
+		size_t			extraBytes;
+
+		if(lead < 0x80) {
+			codePoint = lead;
+			extraBytes = 0;
+		} else if((lead & 0xE0) == 0xC0) {
+			codePoint = lead & 0x1F;
+			extraBytes = 1;
+		} else if((lead & 0xF0) == 0xE0) {
+			codePoint = lead & 0x0F;
+			extraBytes = 2;
+		} else if((lead & 0xF8) == 0xF0) {
+			codePoint = lead & 0x07;
+			extraBytes = 3;
+		} else {
+			wide += L'?';
+			++i;
+			continue;
+		}
+
+		if(i + extraBytes >= i_end) {
+			wide += L'?';
+			break;
+		}
+
+		for(size_t byteNum = 1; byteNum <= extraBytes; ++byteNum)
+			codePoint = (codePoint << 6) | (static_cast<unsigned char>(str[i + byteNum]) & 0x3F);
+
+		if(codePoint >= 0x10000 && sizeof(wchar_t) == 2) {
+			codePoint -= 0x10000;
+			wide += static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+			wide += static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+		} else {
+			wide += static_cast<wchar_t>(codePoint);
+		}
+
+		i += extraBytes + 1;
+	}
+
+	return wide;
+}
+
+inline std::string WideToUtf8(const std::wstring& wide)
+{
+	std::string str;
+	str.reserve(wide.length());
+
+	for(size_t i = 0, i_end = wide.length(); i < i_end; ++i) {
+		unsigned long codePoint = static_cast<unsigned long>(wide[i]);
+
+		// recombine UTF-16 surrogate pairs
+		if(codePoint >= 0xD800 && codePoint < 0xDC00 && i + 1 < i_end) {
+			unsigned long low = static_cast<unsigned long>(wide[i + 1]);
+
+			if(low >= 0xDC00 && low < 0xE000) {
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+				++i;
+			}
+		}
+
+		if(codePoint < 0x80) {
+			str += static_cast<char>(codePoint);
+		} else if(codePoint < 0x800) {
+			str += static_cast<char>(0xC0 | (codePoint >> 6));
+			str += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else if(codePoint < 0x10000) {
+			str += static_cast<char>(0xE0 | (codePoint >> 12));
+			str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			str += static_cast<char>(0x80 | (codePoint & 0x3F));
+		} else {
+			str += static_cast<char>(0xF0 | (codePoint >> 18));
+			str += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			str += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	return str;
+}
+
+// the fstream constructors taking a wchar_t* name are an MSVC extension;
+// elsewhere files are opened by their UTF-8 name
+#ifdef _WIN32
+inline std::wstring NativePath(const std::wstring& path)
+{
+	return path;
+}
+#else
+inline std::string NativePath(const std::wstring& path)
+{
+	return WideToUtf8(path);
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "VariableIndex.h"
+
+using namespace std;
+
+static bool MakeStackKey(xed_reg_enum_t baseReg, long long displacement, unsigned long long& key)
+{
+	// stack slots are always within a 32-bit displacement
+	if(displacement < -0x80000000LL || displacement > 0x7FFFFFFFLL)
+		return false;
+
+	key = (static_cast<unsigned long long>(baseReg) << 32) | static_cast<unsigned int>(displacement);
+	return true;
+}
+
+VariableIndex::VariableIndex(const Function& func, const RegisterMap& registers)
+	: m_registers(registers)
+{
+	// locals win over parameters at the same slot, and the
+	// first variable listed wins over later ones
+	AddStackVariables(func.localVariables);
+	AddStackVariables(func.parameters);
+
+	for(vector<Variable>::const_iterator var = func.localVariables.begin(), var_end = func.localVariables.end();
+		var != var_end; ++var) {
+
+			if(var->location != ValueInRegister)
+				continue;
+
+			xed_reg_enum_t reg = m_registers.GetFullRegister(m_registers.ToDisasReg(var->eRegister));
+
+			if(reg != XED_REG_INVALID)
+				m_registerVariables.insert(make_pair(static_cast<unsigned int>(reg), &*var));
+	}
+}
+
+void VariableIndex::AddStackVariables(const vector<Variable>& variables)
+{
+	for(vector<Variable>::const_iterator var = variables.begin(), var_end = variables.end();
+		var != var_end; ++var) {
+
+			if(var->location != RegisterRelative)
+				continue;
+
+			xed_reg_enum_t		baseReg = m_registers.GetFullRegister(m_registers.ToDisasReg(var->eRegister));
+			unsigned long long	key;
+
+			if(baseReg != XED_REG_INVALID && MakeStackKey(baseReg, var->offset, key))
+				m_stackVariables.insert(make_pair(key, &*var));
+	}
+}
+
+const Variable* VariableIndex::FindStackVariable(xed_reg_enum_t baseReg, long long displacement) const
+{
+	unsigned long long key;
+
+	if(!MakeStackKey(m_registers.GetFullRegister(baseReg), displacement, key))
+		return 0;
+
+	unordered_map<unsigned long long, const Variable*>::const_iterator found = m_stackVariables.find(key);
+
+	return found == m_stackVariables.end() ? 0 : found->second;
+}
+
+const Variable* VariableIndex::FindRegisterVariable(xed_reg_enum_t reg) const
+{
+	if(reg == XED_REG_INVALID)
+		return 0;
+
+	unordered_map<unsigned int, const Variable*>::const_iterator found = m_registerVariables.find(static_cast<unsigned int>(m_registers.GetFullRegister(reg)));
+
+	return found == m_registerVariables.end() ? 0 : found->second;
+}
\ No newline at end of file
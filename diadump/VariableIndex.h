@@ -0,0 +1,38 @@
+#ifndef __VARIABLEINDEX_H__
+#define __VARIABLEINDEX_H__
+
+extern "C"
+{
+	#include <xed-interface.h>
+}
+
+#include <unordered_map>
+
+#include "PDB.h"
+#include "RegisterMap.h"
+
+//
+//	Lookup tables for one function's variables, built once before its
+//	instructions are annotated. Registers are stored as the full XED
+//	register enclosing them so an operand naming any part of a
+//	variable's register still finds it.
+//
+class VariableIndex
+{
+public:
+	VariableIndex(const Function& func, const RegisterMap& registers);
+
+	const Variable*		FindStackVariable(xed_reg_enum_t baseReg, long long displacement) const;
+	const Variable*		FindRegisterVariable(xed_reg_enum_t reg) const;
+
+private:
+	void				AddStackVariables(const std::vector<Variable>& variables);
+
+	const RegisterMap&	m_registers;
+
+	// keyed by base register in the high half and displacement in the low
+	std::unordered_map<unsigned long long, const Variable*>	m_stackVariables;
+	std::unordered_map<unsigned int, const Variable*>		m_registerVariables;
+};
+
+#endif
\ No newline at end of file
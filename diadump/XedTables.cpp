@@ -0,0 +1,16 @@
+extern "C"
+{
+#include <xed-interface.h>
+}
+
+#include <mutex>
+#include "XedTables.h"
+
+using namespace std;
+
+static once_flag s_xedTablesInitialized;
+
+void InitXedTables()
+{
+	call_once(s_xedTablesInitialized, xed_tables_init);
+}
\ No newline at end of file
@@ -0,0 +1,8 @@
+#ifndef __XEDTABLES_H__
+#define __XEDTABLES_H__
+
+// xed_tables_init isn't safe to call from two threads at once; every
+// user goes through this instead so it runs exactly once per process
+void	InitXedTables();
+
+#endif
\ No newline at end of file
@@ -1,8 +1,21 @@
+#include <chrono>
 #include <iostream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <fstream>
 #include <stdlib.h>
+#include <wchar.h>
 
+#include "Batch.h"
+#include "Benchmark.h"
 #include "Disassembler.h"
+#include "GapScanner.h"
+#include "OutputFormatter.h"
+#include "Parallel.h"
+#include "Stats.h"
+#include "SymbolServer.h"
 #include "Utility.h"
 
 using namespace std;
@@ -25,34 +38,410 @@ using namespace std;
 //			b. Otherwise, don't output anything as we won't have type information.
 //				Although this may not necessarily be the case, we will make this assumption for now.
 
+static void PrintOutputThroughput(unsigned long long bytesWritten, chrono::high_resolution_clock::time_point start)
+{
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+	double megabytes = bytesWritten / (1024.0 * 1024.0);
+
+	wcout << L"Wrote " << fixed << setprecision(2) << megabytes << L" MB in " << seconds << L" s";
+
+	if(seconds > 0)
+		wcout << L" (" << megabytes / seconds << L" MB/s)";
+
+	wcout << endl;
+}
+
+// "start-end" in hex RVAs, either end may have a 0x prefix
+static bool ParseRange(const wchar_t* spec, unsigned long long& start, unsigned long long& end)
+{
+	wchar_t* next;
+
+	start = wcstoull(spec, &next, 16);
+
+	if(next == spec || *next != L'-')
+		return false;
+
+	spec = next + 1;
+	end = wcstoull(spec, &next, 16);
+
+	return next != spec && !*next && start < end;
+}
+
+// keeps the console window open when run from Explorer; there's no
+// such window, or pause command, anywhere else
+static void PauseBeforeExit()
+{
+#ifdef _WIN32
+	system("pause");
+#endif
+}
+
+static void ReportStats(const wstring& statsJSONFilename)
+{
+	if(!IsStatsEnabled())
+		return;
+
+	wcout << endl;
+	WriteStatsText(wcout);
+
+	if(!statsJSONFilename.empty()) {
+		ofstream statsFile(NativePath(statsJSONFilename).c_str(), ios::out | ios::binary);
+		WriteStatsJSON(statsFile);
+	}
+}
+
 int wmain(int argc, wchar_t* argv[])
 {
-	if(argc < 2) {
-		wcout << L"Usage: " << argv[0] << " exeFilename [outDumpFilename]" << endl;
-		system("pause");
+	unsigned int		numJobs = 1;
+	bool				bStream = false;
+	bool				bRecursive = false;
+	bool				bOutputCFG = false;
+	wstring				symbolCacheDir;
+	wstring				incrementalFilename;
+	wstring				batchListOrDir;
+	wstring				outputDir;
+	wstring				serverSocketPath;
+	size_t				serverCacheSize = 8;
+	bool				bStats = false;
+	wstring				statsJSONFilename;
+	wstring				benchmarkDir;
+	wstring				benchmarkBaseline;
+	wstring				benchmarkSaveBaseline;
+	BenchmarkOptions	benchmarkOptions;
+	bool				bColumnar = false;
+	FunctionFilter		filter;
+	bool				bScanGaps = false;
+	vector<wchar_t*>	positionalArgs;
+
+	GetDefaultSyntheticImageOptions(benchmarkOptions.image);
+	benchmarkOptions.numRepeats = 5;
+	benchmarkOptions.tolerance = 0.10;
+
+	for(int argNum = 1; argNum < argc; ++argNum) {
+		if(wcscmp(argv[argNum], L"--jobs") == 0 && argNum + 1 < argc) {
+			// 0 means one job per hardware thread
+			numJobs = wcstoul(argv[++argNum], NULL, 10);
+
+			if(!numJobs)
+				numJobs = GetHardwareThreadCount();
+		} else if(wcscmp(argv[argNum], L"--stream") == 0) {
+			bStream = true;
+		} else if(wcscmp(argv[argNum], L"--recursive") == 0) {
+			bRecursive = true;
+		} else if(wcscmp(argv[argNum], L"--cfg") == 0) {
+			bOutputCFG = true;
+		} else if(wcscmp(argv[argNum], L"--symcache") == 0 && argNum + 1 < argc) {
+			symbolCacheDir = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--batch") == 0 && argNum + 1 < argc) {
+			batchListOrDir = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--outdir") == 0 && argNum + 1 < argc) {
+			outputDir = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--incremental") == 0 && argNum + 1 < argc) {
+			incrementalFilename = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--server") == 0 && argNum + 1 < argc) {
+			serverSocketPath = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--server-cache") == 0 && argNum + 1 < argc) {
+			serverCacheSize = wcstoul(argv[++argNum], NULL, 10);
+		} else if(wcscmp(argv[argNum], L"--stats") == 0) {
+			bStats = true;
+		} else if(wcscmp(argv[argNum], L"--stats-json") == 0 && argNum + 1 < argc) {
+			bStats = true;
+			statsJSONFilename = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--format") == 0 && argNum + 1 < argc) {
+			++argNum;
+
+			if(wcscmp(argv[argNum], L"columnar") == 0) {
+				bColumnar = true;
+			} else if(wcscmp(argv[argNum], L"text") != 0) {
+				wcout << L"Error: Unknown output format " << argv[argNum] << endl;
+				return 1;
+			}
+		} else if(wcscmp(argv[argNum], L"--function") == 0 && argNum + 1 < argc) {
+			filter.AddNamePattern(argv[++argNum]);
+		} else if(wcscmp(argv[argNum], L"--function-regex") == 0 && argNum + 1 < argc) {
+			try {
+				filter.AddNameRegex(argv[++argNum]);
+			} catch(const exception& e) {
+				wcout << L"Error: " << e.what() << endl;
+				return 1;
+			}
+		} else if(wcscmp(argv[argNum], L"--compiland") == 0 && argNum + 1 < argc) {
+			filter.AddCompiland(argv[++argNum]);
+		} else if(wcscmp(argv[argNum], L"--range") == 0 && argNum + 1 < argc) {
+			unsigned long long start, end;
+
+			if(!ParseRange(argv[++argNum], start, end)) {
+				wcout << L"Error: Bad --range " << argv[argNum] << endl;
+				return 1;
+			}
+
+			filter.AddRange(start, end);
+		} else if(wcscmp(argv[argNum], L"--min-size") == 0 && argNum + 1 < argc) {
+			filter.SetMinSize(wcstoull(argv[++argNum], NULL, 0));
+		} else if(wcscmp(argv[argNum], L"--scan-gaps") == 0) {
+			bScanGaps = true;
+		} else if(wcscmp(argv[argNum], L"--benchmark") == 0 && argNum + 1 < argc) {
+			benchmarkDir = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--bench-image") == 0 && argNum + 1 < argc) {
+			if(!ParseSyntheticImageOptions(argv[++argNum], benchmarkOptions.image)) {
+				wcout << L"Error: Bad --bench-image option " << argv[argNum] << endl;
+				return 1;
+			}
+		} else if(wcscmp(argv[argNum], L"--bench-repeats") == 0 && argNum + 1 < argc) {
+			benchmarkOptions.numRepeats = wcstoul(argv[++argNum], NULL, 10);
+		} else if(wcscmp(argv[argNum], L"--bench-tolerance") == 0 && argNum + 1 < argc) {
+			// given in percent
+			benchmarkOptions.tolerance = wcstod(argv[++argNum], NULL) / 100.0;
+		} else if(wcscmp(argv[argNum], L"--bench-baseline") == 0 && argNum + 1 < argc) {
+			benchmarkBaseline = argv[++argNum];
+		} else if(wcscmp(argv[argNum], L"--bench-save") == 0 && argNum + 1 < argc) {
+			benchmarkSaveBaseline = argv[++argNum];
+		} else {
+			positionalArgs.push_back(argv[argNum]);
+		}
+	}
+
+	if(bStats)
+		EnableStats();
+
+	if(!benchmarkDir.empty()) {
+		// no pause, benchmarks are meant to be scripted; returns 1 on any regression
+		vector<BenchmarkResult> results;
+
+		benchmarkOptions.workDir = benchmarkDir;
+
+		try {
+			RunBenchmarks(benchmarkOptions, results);
+		} catch(const exception& e) {
+			wcout << L"Error: " << e.what() << endl;
+			return 1;
+		}
+
+		WriteBenchmarkResults(results, wcout);
+
+		if(!benchmarkSaveBaseline.empty() && !SaveBenchmarkBaseline(benchmarkSaveBaseline, results)) {
+			wcout << L"Warning: Unable to write benchmark baseline to " << benchmarkSaveBaseline << endl;
+		}
+
+		if(!benchmarkBaseline.empty()) {
+			wcout << endl;
+
+			int numRegressions = CompareBenchmarkBaseline(benchmarkBaseline, results, benchmarkOptions.tolerance, wcout);
+
+			if(numRegressions < 0) {
+				wcout << L"Error: Unable to read benchmark baseline " << benchmarkBaseline << endl;
+				return 1;
+			}
+
+			if(numRegressions > 0)
+				return 1;
+		}
+
+		return 0;
+	}
+
+	if(!serverSocketPath.empty()) {
+		SymbolServer server(serverCacheSize, symbolCacheDir);
+
+		try {
+			server.Run(serverSocketPath);
+		} catch(const exception& e) {
+			wcout << L"Error: " << e.what() << endl;
+			return 1;
+		}
+
+		const SymbolServerStats& stats = server.GetStats();
+
+		wcout << L"Served " << stats.numQueries << L" queries in " << stats.numRequests << L" requests, "
+			<< stats.cacheHits << L" image cache hits, " << stats.cacheMisses << L" misses" << endl;
+
+		return 0;
+	}
+
+	if(!batchListOrDir.empty()) {
+		// no pause at the end, batch runs are meant to be scripted
+		vector<wstring> inputs;
+
+		if(!GetBatchInputs(batchListOrDir, inputs)) {
+			wcout << L"Error: Unable to read batch list " << batchListOrDir << endl;
+			return 1;
+		}
+
+		BatchOptions options;
+		options.numJobs = numJobs;
+		options.bRecursive = bRecursive;
+		options.bOutputCFG = bOutputCFG;
+		options.symbolCacheDir = symbolCacheDir;
+		options.outputDir = outputDir;
+		options.filter = filter;
+		options.bScanGaps = bScanGaps;
+
+		chrono::high_resolution_clock::time_point batchStart = chrono::high_resolution_clock::now();
+
+		vector<BatchResult> results;
+		RunBatch(inputs, options, results);
+
+		double totalSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - batchStart).count();
+
+		wstring summaryFilename = JoinPath(outputDir, L"batch_summary.txt");
+		wofstream summaryFile(NativePath(summaryFilename).c_str());
+
+		WriteBatchSummary(results, totalSeconds, wcout);
+		WriteBatchSummary(results, totalSeconds, summaryFile);
+		ReportStats(statsJSONFilename);
+
+		for(vector<BatchResult>::const_iterator i = results.begin(), i_end = results.end(); i != i_end; ++i) {
+			if(!i->bSucceeded)
+				return 1;
+		}
+
+		return 0;
+	}
+
+	if(positionalArgs.empty()) {
+		wcout << L"Usage: " << argv[0] << " [--jobs N] [--stream] [--recursive] [--cfg] [--symcache dir] [--incremental stateFile] [--stats] [--stats-json file] [--format text|columnar] [--scan-gaps] [filters] exeFilename [outDumpFilename]" << endl;
+		wcout << L"       " << argv[0] << " [--jobs N] [--recursive] [--cfg] [--symcache dir] [--stats] [--stats-json file] [--scan-gaps] [filters] --batch listFileOrDir [--outdir dir]" << endl;
+		wcout << L"       " << argv[0] << " [--symcache dir] [--server-cache N] --server socketPath" << endl;
+		wcout << L"       " << argv[0] << " [--bench-image spec] [--bench-repeats N] [--bench-baseline file] [--bench-tolerance pct] [--bench-save file] --benchmark workDir" << endl;
+		wcout << L"filters: [--function glob] [--function-regex re] [--compiland glob] [--range startRVA-endRVA] [--min-size bytes]" << endl;
+		PauseBeforeExit();
 		return 1;
 	}
 
-	Disassembler disas(argv[1]);
-	
-	if(!disas.DisassembleFunctions())
-	{
-		wcout << L"Error: Unable to disassemble functions." << endl;
-		system("pause");
+	Disassembler disas(positionalArgs[0], symbolCacheDir);
+	disas.SetRecursiveDescent(bRecursive);
+	disas.SetOutputControlFlowGraph(bOutputCFG);
+
+	if(!filter.IsEmpty()) {
+		disas.SelectFunctions(filter);
+		wcout << L"Selected " << disas.GetFunctions().size() << L" of " << disas.GetPDB().GetFunctions().size() << L" functions" << endl;
 	}
 
-	wchar_t* outFilename;
+	if(bScanGaps) {
+		// code no PDB function covers, anything that starts like a function gets disassembled too
+		GapScanner			scanner(disas.GetPE(), disas.GetPDB());
+		vector<SectionGap>	gaps;
+		vector<Function>	candidates;
 
-	if(argc > 2) {
-		outFilename = argv[2];
+		scanner.Scan(gaps);
+		GapScanner::GetCandidateFunctions(gaps, candidates);
+		disas.AddFunctions(candidates, filter);
+
+		wcout << L"Scanned executable sections (" << scanner.GetImplementationName() << L")" << endl;
+		GapScanner::WriteGapSummary(gaps, wcout);
+	}
+
+	const wchar_t* outFilename;
+
+	if(positionalArgs.size() > 1) {
+		outFilename = positionalArgs[1];
 	} else {
-		outFilename = L"exedump_out.txt";
+		outFilename = bColumnar ? L"exedump_out.ddc" : L"exedump_out.txt";
 	}
     
-	wofstream outDump(outFilename, ios::out);
+	// the dump is written as UTF-8 through our own buffering
+	ofstream outFile(NativePath(outFilename).c_str(), ios::out | ios::binary);
+
+	if(!outFile) {
+		wcout << L"Error: Unable to open " << outFilename << endl;
+		PauseBeforeExit();
+		return 1;
+	}
+
+	if(bColumnar) {
+		// functions, variables and instructions as column arrays, see ColumnarFile.h
+		// scripts read the columnar file, so any failure has to show in the exit code
+		if(!disas.DisassembleFunctions(numJobs)) {
+			wcout << L"Error: Unable to disassemble functions." << endl;
+			PauseBeforeExit();
+			return 1;
+		}
+
+		chrono::high_resolution_clock::time_point columnarStart = chrono::high_resolution_clock::now();
+
+		const vector<Function>&				functions = disas.GetFunctions();
+		const vector<DisassembledFunction>&	disassembled = disas.GetDisassembledFunctions();
+		ColumnarWriter						columnar(outFile, disas.GetPE().Is64Bit(), disas.GetPE().getImageBase());
+
+		for(size_t i = 0, i_end = functions.size(); i < i_end; ++i)
+			disas.OutputFunctionColumnar(functions[i], disassembled[i], columnar);
+
+		bool bWritten = columnar.Finish();
+
+		if(!bWritten) {
+			wcout << L"Error: Unable to write " << outFilename << endl;
+		}
+
+		PrintOutputThroughput(columnar.GetBytesWritten(), columnarStart);
+		AddStatsCounter(CounterBytesWritten, columnar.GetBytesWritten());
+		ReportStats(statsJSONFilename);
+
+		PauseBeforeExit();
+		return bWritten ? 0 : 1;
+	}
+
+	OutputFormatter outDump(outFile);
+
+	if(!incrementalFilename.empty()) {
+		// reuse last run's text for every function that hasn't changed
+		chrono::high_resolution_clock::time_point incrementalStart = chrono::high_resolution_clock::now();
+
+		IncrementalCache	previous;
+		IncrementalCache	next;
+		size_t				numReused;
+
+		previous.Load(incrementalFilename);
+
+		if(!disas.DisassembleAndOutputIncremental(outDump, previous, next, numJobs, numReused)) {
+			wcout << L"Error: Unable to disassemble functions." << endl;
+		}
+
+		outDump.Flush();
+		PrintOutputThroughput(outDump.GetBytesWritten(), incrementalStart);
+		AddStatsCounter(CounterBytesWritten, outDump.GetBytesWritten());
+
+		wcout << L"Reused " << numReused << L" of " << disas.GetFunctions().size() << L" functions" << endl;
+
+		// the old state file is still mapped, let go of it before overwriting it
+		previous.Clear();
+
+		if(!next.Save(incrementalFilename)) {
+			wcout << L"Warning: Unable to write incremental state to " << incrementalFilename << endl;
+		}
+
+		ReportStats(statsJSONFilename);
+
+		PauseBeforeExit();
+		return 0;
+	}
+
+	if(bStream) {
+		// decode, write and drop each function as we go
+		chrono::high_resolution_clock::time_point streamStart = chrono::high_resolution_clock::now();
+
+		if(!disas.DisassembleAndOutputFunctions(outDump, numJobs)) {
+			wcout << L"Error: Unable to disassemble functions." << endl;
+		}
+
+		outDump.Flush();
+		PrintOutputThroughput(outDump.GetBytesWritten(), streamStart);
+		AddStatsCounter(CounterBytesWritten, outDump.GetBytesWritten());
+		ReportStats(statsJSONFilename);
+
+		PauseBeforeExit();
+		return 0;
+	}
+	
+	if(!disas.DisassembleFunctions(numJobs))
+	{
+		wcout << L"Error: Unable to disassemble functions." << endl;
+		PauseBeforeExit();
+	}
 
 	const vector<Function>& functions = disas.GetFunctions();
 
+	chrono::high_resolution_clock::time_point outputStart = chrono::high_resolution_clock::now();
+
 	//wcout << endl << endl << endl << L"Disassembled functions (check output for disassembled instructions)" << endl << endl;
 
 	for(vector<Function>::const_iterator i = functions.begin(), i_end = functions.end();
@@ -62,8 +451,31 @@ int wmain(int argc, wchar_t* argv[])
 			disas.OutputFunctionDisassembly(i, outDump);
 	}
 
+	outDump.Flush();
+	PrintOutputThroughput(outDump.GetBytesWritten(), outputStart);
+	AddStatsCounter(CounterBytesWritten, outDump.GetBytesWritten());
+	ReportStats(statsJSONFilename);
+
 	//wcout << endl << endl << endl;
 
-	system("pause");
+	PauseBeforeExit();
 	return 0;
-}
\ No newline at end of file
+}
+
+#ifndef _WIN32
+// only MSVC starts programs at wmain; elsewhere the UTF-8 arguments are widened first
+int main(int argc, char* argv[])
+{
+	vector<wstring>		args;
+	vector<wchar_t*>	argPtrs;
+
+	for(int i = 0; i < argc; ++i)
+		args.push_back(Utf8ToWide(argv[i]));
+
+	for(int i = 0; i < argc; ++i)
+		argPtrs.push_back(&args[i][0]);
+	argPtrs.push_back(NULL);
+
+	return wmain(argc, &argPtrs[0]);
+}
+#endif
\ No newline at end of file